@@ -5,6 +5,14 @@ import :log;
 
 export namespace Engine
 {
+	// Refers to a texture in an AssetStore. Handles are indices, so getting
+	// a texture from one is an array access rather than a lookup by name,
+	// and sprites can be sorted and batched by them.
+	enum class TextureHandle : std::uint32_t
+	{
+		Invalid = std::numeric_limits<std::uint32_t>::max()
+	};
+
 	class AssetStore
 	{
 	public:
@@ -15,16 +23,19 @@ export namespace Engine
 
 		void Clear()
 		{
-			for (auto& [_, texture] : textures)
-				SDL::SDL_DestroyTexture(texture);
+			for (auto& texture : textures)
+				SDL::SDL_DestroyTexture(texture.texture);
 			textures.clear();
+			handles.clear();
 		}
 
-		void AddTexture(
+		// Adding a texture under an asset ID that's already used replaces
+		// that texture, and keeps its handle.
+		auto AddTexture(
 			SDL::SDL_Renderer* renderer, 
 			const std::string& assetId, 
 			const std::filesystem::path& path
-		)
+		) -> TextureHandle
 		{
 			auto surface = SDL::IMG_Load(path.string().c_str());
 			if (not surface)
@@ -33,15 +44,56 @@ export namespace Engine
 			SDL::SDL_DestroySurface(surface);
 			if (not texture)
 				throw SDL::SdlError{ "Failed to create texture from surface" };
-			textures[assetId] = texture;
+
+			auto loaded = Texture{ .texture = texture };
+			SDL::SDL_GetTextureSize(texture, &loaded.width, &loaded.height);
+			if (auto existing = handles.find(assetId); existing != handles.end())
+			{
+				auto& replaced = textures[std::to_underlying(existing->second)];
+				SDL::SDL_DestroyTexture(replaced.texture);
+				replaced = loaded;
+				return existing->second;
+			}
+			auto handle = static_cast<TextureHandle>(textures.size());
+			textures.push_back(loaded);
+			handles.emplace(assetId, handle);
+			return handle;
 		}
 
-		auto GetTexture(const std::string& assetId) -> SDL::SDL_Texture*
+		auto GetTextureHandle(std::string_view assetId) const -> TextureHandle
 		{
-			return textures[assetId];
+			auto handle = handles.find(assetId);
+			if (handle == handles.end())
+				throw std::out_of_range{ std::format("No texture with asset ID {}", assetId) };
+			return handle->second;
+		}
+
+		auto GetTexture(TextureHandle handle) const -> SDL::SDL_Texture*
+		{
+			return textures.at(std::to_underlying(handle)).texture;
+		}
+
+		auto GetTexture(std::string_view assetId) const -> SDL::SDL_Texture*
+		{
+			return GetTexture(GetTextureHandle(assetId));
+		}
+
+		// In pixels.
+		auto GetTextureSize(TextureHandle handle) const -> SDL::SDL_FPoint
+		{
+			auto& texture = textures.at(std::to_underlying(handle));
+			return { texture.width, texture.height };
 		}
 
 	private:
-		std::map<std::string, SDL::SDL_Texture*> textures;
+		struct Texture
+		{
+			SDL::SDL_Texture* texture = nullptr;
+			float width = 0;
+			float height = 0;
+		};
+
+		std::vector<Texture> textures;
+		std::map<std::string, TextureHandle, std::less<>> handles;
 	};
 }
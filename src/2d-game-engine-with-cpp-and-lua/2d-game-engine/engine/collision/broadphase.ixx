@@ -0,0 +1,235 @@
+export module engine:collision.broadphase;
+import std;
+
+export namespace Engine
+{
+	// An axis-aligned box, from its top left corner up to but not
+	// including its bottom right one.
+	struct Bounds
+	{
+		float left = 0;
+		float top = 0;
+		float right = 0;
+		float bottom = 0;
+
+		constexpr auto Overlaps(const Bounds& other) const noexcept -> bool
+		{
+			return left < other.right and other.left < right and top < other.bottom and other.top < bottom;
+		}
+	};
+
+	enum class BroadPhaseKind
+	{
+		// Suits colliders spread evenly, or crowded, over the map.
+		SpatialHash,
+		// Suits a few colliders over a large map, where most cells of a
+		// grid would be empty.
+		SweepAndPrune
+	};
+
+	// Finds the pairs of boxes that overlap, without testing each box
+	// against every other. Each box is put in every cell of a uniform grid
+	// that it touches, and only boxes that share a cell are tested. The
+	// grid is hashed into a table sized from the number of entries, so it
+	// covers an unbounded map, and the cells are sized from the boxes, at
+	// twice their average extent, so a box typically touches one to four.
+	//
+	// The table is rebuilt from scratch by Build(), with a counting sort,
+	// so the cost is linear in the number of boxes, and the vectors are
+	// reused from one build to the next.
+	class SpatialHash
+	{
+	public:
+		constexpr void Build(std::span<const Bounds> boxes)
+		{
+			bounds.assign(boxes.begin(), boxes.end());
+			cellSize = 1;
+			if (not boxes.empty())
+			{
+				auto extents = 0.0;
+				for (auto& box : boxes)
+					extents += std::max(box.right - box.left, box.bottom - box.top);
+				cellSize = std::max(static_cast<float>(2 * extents / boxes.size()), 1.0f);
+			}
+
+			auto entryCount = std::size_t{ 0 };
+			cellRanges.clear();
+			for (auto& box : boxes)
+			{
+				auto range = CellRange{ CellOf(box.left), CellOf(box.top), CellOf(box.right), CellOf(box.bottom) };
+				cellRanges.push_back(range);
+				entryCount += std::size_t(range.right - range.left + 1) * std::size_t(range.bottom - range.top + 1);
+			}
+
+			// Counting sort of the entries by bucket: count, turn the counts
+			// into where each bucket starts, then fill.
+			auto bucketCount = std::bit_ceil(std::max(entryCount * 2, std::size_t{ 1 }));
+			bucketStarts.assign(bucketCount + 1, 0);
+			ForEachEntry([&](std::int32_t x, std::int32_t y, std::uint32_t) { bucketStarts[Hash(x, y) + 1]++; });
+			for (auto i = std::size_t{ 1 }; i <= bucketCount; i++)
+				bucketStarts[i] += bucketStarts[i - 1];
+			entries.resize(entryCount);
+			fill.assign(bucketStarts.begin(), bucketStarts.end() - 1);
+			ForEachEntry([&](std::int32_t x, std::int32_t y, std::uint32_t box) { entries[fill[Hash(x, y)]++] = { x, y, box }; });
+		}
+
+		// Calls callback(a, b) once for each pair of overlapping boxes, with
+		// a < b indexing the boxes given to Build().
+		template<typename TCallback>
+		constexpr void ForEachPair(TCallback&& callback) const
+		{
+			for (auto bucket = std::size_t{ 0 }; bucket + 1 < bucketStarts.size(); bucket++)
+			{
+				for (auto i = bucketStarts[bucket]; i < bucketStarts[bucket + 1]; i++)
+				{
+					for (auto j = i + 1; j < bucketStarts[bucket + 1]; j++)
+					{
+						auto& a = entries[i];
+						auto& b = entries[j];
+						// Different cells can share a bucket.
+						if (a.x != b.x or a.y != b.y)
+							continue;
+						auto& boxA = bounds[a.box];
+						auto& boxB = bounds[b.box];
+						if (not boxA.Overlaps(boxB))
+							continue;
+						// Boxes that share several cells are reported only in the
+						// one holding the top left corner of their overlap.
+						if (CellOf(std::max(boxA.left, boxB.left)) != a.x or CellOf(std::max(boxA.top, boxB.top)) != a.y)
+							continue;
+						callback(std::min(a.box, b.box), std::max(a.box, b.box));
+					}
+				}
+			}
+		}
+
+		constexpr auto GetCellSize() const noexcept -> float
+		{
+			return cellSize;
+		}
+
+	private:
+		struct CellRange
+		{
+			std::int32_t left, top, right, bottom;
+		};
+
+		struct Entry
+		{
+			std::int32_t x = 0;
+			std::int32_t y = 0;
+			std::uint32_t box = 0;
+		};
+
+		constexpr auto CellOf(float coordinate) const noexcept -> std::int32_t
+		{
+			// Rounds down, including for negative coordinates.
+			auto scaled = coordinate / cellSize;
+			auto cell = static_cast<std::int32_t>(scaled);
+			return static_cast<float>(cell) > scaled ? cell - 1 : cell;
+		}
+
+		constexpr auto Hash(std::int32_t x, std::int32_t y) const noexcept -> std::size_t
+		{
+			auto hash = static_cast<std::uint32_t>(x) * 73856093u ^ static_cast<std::uint32_t>(y) * 19349663u;
+			return hash & (bucketStarts.size() - 2);
+		}
+
+		template<typename TCallback>
+		constexpr void ForEachEntry(TCallback&& callback) const
+		{
+			for (auto box = std::uint32_t{ 0 }; box < cellRanges.size(); box++)
+			{
+				auto& range = cellRanges[box];
+				for (auto y = range.top; y <= range.bottom; y++)
+					for (auto x = range.left; x <= range.right; x++)
+						callback(x, y, box);
+			}
+		}
+
+		float cellSize = 1;
+		std::vector<Bounds> bounds{};
+		std::vector<CellRange> cellRanges{};
+		std::vector<Entry> entries{};
+		// The entries of bucket b are entries[bucketStarts[b]] up to
+		// entries[bucketStarts[b + 1]].
+		std::vector<std::size_t> bucketStarts{};
+		std::vector<std::size_t> fill{};
+	};
+
+	// Finds the same pairs as SpatialHash by sorting the boxes by their
+	// left edge and testing each only against those that start before it
+	// ends. Costs nothing for empty space, but boxes lined up vertically
+	// all get tested against each other.
+	class SweepAndPrune
+	{
+	public:
+		constexpr void Build(std::span<const Bounds> boxes)
+		{
+			bounds.assign(boxes.begin(), boxes.end());
+			order.resize(boxes.size());
+			std::iota(order.begin(), order.end(), std::uint32_t{ 0 });
+			std::ranges::sort(order, std::less{}, [this](std::uint32_t box) { return bounds[box].left; });
+		}
+
+		template<typename TCallback>
+		constexpr void ForEachPair(TCallback&& callback) const
+		{
+			for (auto i = std::size_t{ 0 }; i < order.size(); i++)
+			{
+				auto& boxA = bounds[order[i]];
+				for (auto j = i + 1; j < order.size() and bounds[order[j]].left < boxA.right; j++)
+					if (boxA.Overlaps(bounds[order[j]]))
+						callback(std::min(order[i], order[j]), std::max(order[i], order[j]));
+			}
+		}
+
+	private:
+		std::vector<Bounds> bounds{};
+		std::vector<std::uint32_t> order{};
+	};
+}
+
+namespace
+{
+	using namespace Engine;
+
+	// Test that both broad phases find exactly the overlapping pairs, once
+	// each, including for boxes that share several cells or are negative.
+	static_assert(
+		[] -> bool
+		{
+			auto boxes = std::array{
+				Bounds{ 0, 0, 10, 10 },
+				Bounds{ 5, 5, 15, 15 },
+				Bounds{ 9, -20, 40, 6 },
+				Bounds{ 100, 100, 104, 104 },
+				Bounds{ -8, -8, -2, -2 },
+				Bounds{ -3, -3, 1, 1 },
+				Bounds{ 10, 0, 20, 10 }
+			};
+			auto expected = std::vector<std::pair<std::uint32_t, std::uint32_t>>{};
+			for (auto a = std::uint32_t{ 0 }; a < boxes.size(); a++)
+				for (auto b = a + 1; b < boxes.size(); b++)
+					if (boxes[a].Overlaps(boxes[b]))
+						expected.emplace_back(a, b);
+
+			auto spatialHash = SpatialHash{};
+			spatialHash.Build(boxes);
+			auto hashed = std::vector<std::pair<std::uint32_t, std::uint32_t>>{};
+			spatialHash.ForEachPair([&](std::uint32_t a, std::uint32_t b) { hashed.emplace_back(a, b); });
+			std::ranges::sort(hashed);
+			if (hashed != expected)
+				throw "Expected the spatial hash to find each overlapping pair once";
+
+			auto sweepAndPrune = SweepAndPrune{};
+			sweepAndPrune.Build(boxes);
+			auto swept = std::vector<std::pair<std::uint32_t, std::uint32_t>>{};
+			sweepAndPrune.ForEachPair([&](std::uint32_t a, std::uint32_t b) { swept.emplace_back(a, b); });
+			std::ranges::sort(swept);
+			if (swept != expected)
+				throw "Expected sweep and prune to find each overlapping pair once";
+			return true;
+		}()
+	);
+}
@@ -0,0 +1,2 @@
+export module engine:collision;
+export import :collision.broadphase;
@@ -1,12 +1,13 @@
 export module engine:components.spritecomponent;
 import std;
 import :sdl3;
+import :assetstore;
 
 export namespace Engine
 {
 	struct SpriteComponent
 	{
-		std::string assetId;
+		TextureHandle texture = TextureHandle::Invalid;
 		int width = 0;
 		int height = 0;
 		int zIndex = 0;
@@ -0,0 +1,290 @@
+export module engine:ecs.archetype;
+import std;
+import :ecs.component;
+import :ecs.entity;
+
+export namespace Engine
+{
+	// What an archetype needs to know to move and destroy a component it
+	// only knows the ID of.
+	struct ComponentType
+	{
+		std::size_t size = 0;
+		std::size_t alignment = 0;
+		// Constructs at destination from source, leaving source moved-from
+		// but still to be destroyed.
+		void (*moveConstruct)(void* destination, void* source) = nullptr;
+		void (*destroy)(void* component) = nullptr;
+
+		template<typename T>
+		static constexpr auto Of() -> ComponentType
+		{
+			static_assert(std::is_nothrow_move_constructible_v<T>, "Components are moved between archetypes and can't throw doing so");
+			static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Chunks are allocated with the default alignment");
+			return {
+				.size = sizeof(T),
+				.alignment = alignof(T),
+				.moveConstruct = [](void* destination, void* source) { std::construct_at(static_cast<T*>(destination), std::move(*static_cast<T*>(source))); },
+				.destroy = [](void* component) { std::destroy_at(static_cast<T*>(component)); }
+			};
+		}
+	};
+
+	// All the entities that have exactly the same set of components. They
+	// are stored in chunks of about ChunkBytes, each holding a column per
+	// component, plus one of entities, so that a system going through a
+	// few components of every entity in a chunk reads memory in order.
+	//
+	// Rows are kept packed: removing one moves the last row into it. Row
+	// numbers run across chunks, so row r is in chunk r / capacity.
+	class Archetype
+	{
+	public:
+		static constexpr auto ChunkBytes = std::size_t{ 16 * 1024 };
+
+		Archetype(const Signature& signature, std::span<const ComponentType, MaxComponents> componentTypes)
+			: signature{ signature }
+		{
+			auto rowBytes = sizeof(Entity);
+			for (auto componentId = 0; componentId < static_cast<int>(MaxComponents); componentId++)
+			{
+				if (not signature.test(componentId))
+					continue;
+				types[componentId] = componentTypes[componentId];
+				componentIds.push_back(componentId);
+				rowBytes += types[componentId].size;
+			}
+
+			capacity = std::max(ChunkBytes / rowBytes, std::size_t{ 1 });
+			// The entities first, then each column, each aligned for its type.
+			chunkBytes = sizeof(Entity) * capacity;
+			for (auto componentId : componentIds)
+			{
+				auto& type = types[componentId];
+				chunkBytes = (chunkBytes + type.alignment - 1) / type.alignment * type.alignment;
+				offsets[componentId] = chunkBytes;
+				chunkBytes += type.size * capacity;
+			}
+		}
+
+		Archetype(const Archetype&) = delete;
+		auto operator=(const Archetype&) -> Archetype& = delete;
+
+		~Archetype()
+		{
+			while (size > 0)
+				Remove(size - 1);
+		}
+
+		auto GetSignature() const -> const Signature&
+		{
+			return signature;
+		}
+
+		auto GetSize() const -> std::size_t
+		{
+			return size;
+		}
+
+		auto GetChunkCount() const -> std::size_t
+		{
+			return chunks.size();
+		}
+
+		// How many rows are in use in the chunk; all but the last are full.
+		auto GetChunkSize(std::size_t chunk) const -> std::size_t
+		{
+			return std::min(size - std::min(size, chunk * capacity), capacity);
+		}
+
+		auto GetEntities(std::size_t chunk) const -> std::span<const Entity>
+		{
+			return { std::launder(reinterpret_cast<const Entity*>(chunks[chunk].get())), GetChunkSize(chunk) };
+		}
+
+		template<typename T>
+		auto GetColumn(std::size_t chunk) -> std::span<T>
+		{
+			auto componentId = Component<T>::GetId();
+			if (not signature.test(componentId))
+				throw std::out_of_range{ "Archetype doesn't have the component" };
+			return { std::launder(reinterpret_cast<T*>(chunks[chunk].get() + offsets[componentId])), GetChunkSize(chunk) };
+		}
+
+		// The component's storage in the row, which is only constructed
+		// once the caller has done so after Append().
+		auto GetComponent(std::size_t row, int componentId) -> void*
+		{
+			return chunks[row / capacity].get() + offsets[componentId] + (row % capacity) * types[componentId].size;
+		}
+
+		// Adds a row for the entity and returns it. Its components are left
+		// for the caller to construct.
+		auto Append(Entity entity) -> std::size_t
+		{
+			auto row = size;
+			if (row / capacity >= chunks.size())
+				chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(chunkBytes));
+			std::construct_at(EntityAt(row), entity);
+			size++;
+			return row;
+		}
+
+		// Destroys the row's components and moves the last row into its
+		// place. Returns the entity that was moved, if any, whose row is
+		// now the removed one.
+		auto Remove(std::size_t row) -> std::optional<Entity>
+		{
+			auto last = size - 1;
+			for (auto componentId : componentIds)
+			{
+				auto& type = types[componentId];
+				type.destroy(GetComponent(row, componentId));
+				if (row != last)
+				{
+					type.moveConstruct(GetComponent(row, componentId), GetComponent(last, componentId));
+					type.destroy(GetComponent(last, componentId));
+				}
+			}
+			size--;
+
+			// Keep one empty chunk spare, so that an entity count going
+			// back and forth over a chunk boundary doesn't allocate each time.
+			if (chunks.size() * capacity >= size + 2 * capacity)
+				chunks.pop_back();
+
+			if (row == last)
+				return std::nullopt;
+			*EntityAt(row) = *EntityAt(last);
+			return *EntityAt(row);
+		}
+
+	private:
+		auto EntityAt(std::size_t row) -> Entity*
+		{
+			return std::launder(reinterpret_cast<Entity*>(chunks[row / capacity].get())) + row % capacity;
+		}
+
+		Signature signature{};
+		std::vector<int> componentIds{};
+		std::array<ComponentType, MaxComponents> types{};
+		std::array<std::size_t, MaxComponents> offsets{};
+		std::size_t capacity = 0;
+		std::size_t chunkBytes = 0;
+		std::size_t size = 0;
+		std::vector<std::unique_ptr<std::byte[]>> chunks{};
+	};
+
+	// Keeps every entity's components in the archetype for its signature,
+	// moving them to another archetype when a component is added or
+	// removed.
+	class ArchetypeStorage
+	{
+	public:
+		// Adds the entity's component, or replaces the one it already has.
+		template<typename T>
+		auto Set(Entity entity, T component) -> T&
+		{
+			auto componentId = Component<T>::GetId();
+			if (not componentTypes[componentId].destroy)
+				componentTypes[componentId] = ComponentType::Of<T>();
+
+			auto& location = LocationOf(entity);
+			auto signature = location.archetype ? location.archetype->GetSignature() : Signature{};
+			if (signature.test(componentId))
+				return *static_cast<T*>(location.archetype->GetComponent(location.row, componentId)) = std::move(component);
+
+			auto& target = GetArchetype(Signature{ signature }.set(componentId));
+			MoveEntity(entity, &target);
+			return *std::construct_at(static_cast<T*>(target.GetComponent(location.row, componentId)), std::move(component));
+		}
+
+		template<typename T>
+		void Remove(Entity entity)
+		{
+			auto componentId = Component<T>::GetId();
+			auto& location = LocationOf(entity);
+			if (not location.archetype or not location.archetype->GetSignature().test(componentId))
+				return;
+			auto signature = Signature{ location.archetype->GetSignature() }.reset(componentId);
+			MoveEntity(entity, signature.any() ? &GetArchetype(signature) : nullptr);
+		}
+
+		void RemoveEntity(Entity entity)
+		{
+			MoveEntity(entity, nullptr);
+		}
+
+		template<typename T>
+		auto Get(Entity entity) -> T&
+		{
+			// Doesn't grow the locations, unlike LocationOf(), so systems
+			// running at the same time can all read components.
+			auto componentId = Component<T>::GetId();
+			if (entity.GetId() >= locations.size())
+				throw std::out_of_range{ "Entity doesn't have the component" };
+			auto& location = locations[entity.GetId()];
+			if (not location.archetype or not location.archetype->GetSignature().test(componentId))
+				throw std::out_of_range{ "Entity doesn't have the component" };
+			return *std::launder(static_cast<T*>(location.archetype->GetComponent(location.row, componentId)));
+		}
+
+		auto GetArchetypes() -> std::span<const std::unique_ptr<Archetype>>
+		{
+			return archetypes;
+		}
+
+	private:
+		struct Location
+		{
+			Archetype* archetype = nullptr;
+			std::size_t row = 0;
+		};
+
+		auto LocationOf(Entity entity) -> Location&
+		{
+			if (entity.GetId() >= locations.size())
+				locations.resize(entity.GetId() + 1);
+			return locations[entity.GetId()];
+		}
+
+		auto GetArchetype(const Signature& signature) -> Archetype&
+		{
+			auto& archetype = archetypesBySignature[signature];
+			if (not archetype)
+				archetype = archetypes.emplace_back(std::make_unique<Archetype>(signature, componentTypes)).get();
+			return *archetype;
+		}
+
+		// Moves the components the target has from the entity's archetype
+		// into a new row of the target, and destroys the rest. A null target
+		// leaves the entity with no components.
+		void MoveEntity(Entity entity, Archetype* target)
+		{
+			auto& location = LocationOf(entity);
+			auto row = std::size_t{ 0 };
+			if (target)
+			{
+				row = target->Append(entity);
+				if (location.archetype)
+					for (auto componentId = 0; componentId < static_cast<int>(MaxComponents); componentId++)
+						if (location.archetype->GetSignature().test(componentId) and target->GetSignature().test(componentId))
+							componentTypes[componentId].moveConstruct(
+								target->GetComponent(row, componentId),
+								location.archetype->GetComponent(location.row, componentId));
+			}
+
+			if (location.archetype)
+				if (auto moved = location.archetype->Remove(location.row))
+					locations[moved->GetId()].row = location.row;
+
+			location = { target, row };
+		}
+
+		std::array<ComponentType, MaxComponents> componentTypes{};
+		std::vector<Location> locations{};
+		// Archetypes are never destroyed, so pointers to them stay valid.
+		std::vector<std::unique_ptr<Archetype>> archetypes{};
+		std::unordered_map<Signature, Archetype*> archetypesBySignature{};
+	};
+}
@@ -0,0 +1,136 @@
+export module engine:ecs.commandbuffer;
+import std;
+import :ecs.entity;
+import :ecs.registry;
+
+export namespace Engine
+{
+	// Records changes to the registry's entities and components, for
+	// systems that run at the same time as others and so can't make them
+	// directly. The changes are made in the order they were recorded when
+	// the buffer is applied, on one thread, once the systems have finished.
+	//
+	// Recording can be done from any thread.
+	//
+	// Each command is kept in memory from a pool that keeps what's given
+	// back to it, so once the buffer has held as many commands as it will
+	// in a frame, recording and applying them allocates nothing.
+	class CommandBuffer
+	{
+	public:
+		CommandBuffer() = default;
+		CommandBuffer(const CommandBuffer&) = delete;
+		auto operator=(const CommandBuffer&) -> CommandBuffer& = delete;
+
+		~CommandBuffer()
+		{
+			Clear();
+		}
+
+		// Creates an entity with the given components.
+		template<typename...TComponents>
+		void CreateEntity(TComponents&&... components)
+		{
+			Record(
+				[...components = std::forward<TComponents>(components)](Registry& registry) mutable
+				{
+					auto entity = registry.CreateEntity();
+					(registry.AddComponent<std::remove_cvref_t<TComponents>>(entity, std::move(components)), ...);
+				});
+		}
+
+		void KillEntity(Entity entity)
+		{
+			Record([entity](Registry& registry) { registry.KillEntity(entity); });
+		}
+
+		template<typename TComponent, typename...TArgs>
+		void AddComponent(Entity entity, TArgs&&... args)
+		{
+			Record(
+				[entity, component = TComponent{ std::forward<TArgs>(args)... }](Registry& registry) mutable
+				{
+					registry.AddComponent<TComponent>(entity, std::move(component));
+				});
+		}
+
+		template<typename TComponent>
+		void RemoveComponent(Entity entity)
+		{
+			Record([entity](Registry& registry) { registry.RemoveComponent<TComponent>(entity); });
+		}
+
+		// Makes the recorded changes and clears the buffer. If a change
+		// throws, the ones after it are dropped.
+		void Apply(Registry& registry)
+		{
+			auto lock = std::scoped_lock{ mutex };
+			try
+			{
+				for (auto& command : commands)
+					command.apply(command.object, registry);
+			}
+			catch (...)
+			{
+				Clear();
+				throw;
+			}
+			Clear();
+		}
+
+	private:
+		// A recorded command, type erased without std::move_only_function,
+		// which would allocate for the larger ones, such as creating an
+		// entity with several components.
+		struct Command
+		{
+			void (*apply)(void*, Registry&) = nullptr;
+			void (*destroy)(std::pmr::memory_resource&, void*) noexcept = nullptr;
+			void* object = nullptr;
+		};
+
+		template<typename TCommand>
+		void Record(TCommand&& command)
+		{
+			using T = std::remove_cvref_t<TCommand>;
+			auto lock = std::scoped_lock{ mutex };
+			// Grown ahead of constructing the command, so that push_back()
+			// can't throw once it's constructed, and doubled, so that
+			// recording n commands costs O(n).
+			if (commands.size() == commands.capacity())
+				commands.reserve(std::max<std::size_t>(16, commands.capacity() * 2));
+			auto memory = pool.allocate(sizeof(T), alignof(T));
+			auto object = static_cast<void*>(nullptr);
+			try
+			{
+				object = new (memory) T(std::forward<TCommand>(command));
+			}
+			catch (...)
+			{
+				pool.deallocate(memory, sizeof(T), alignof(T));
+				throw;
+			}
+			commands.push_back({
+				[](void* object, Registry& registry) { (*static_cast<T*>(object))(registry); },
+				[](std::pmr::memory_resource& pool, void* object) noexcept
+				{
+					static_cast<T*>(object)->~T();
+					pool.deallocate(object, sizeof(T), alignof(T));
+				},
+				object
+			});
+		}
+
+		// Destroys the commands and gives their memory back to the pool.
+		void Clear() noexcept
+		{
+			for (auto& command : commands)
+				command.destroy(pool, command.object);
+			commands.clear();
+		}
+
+		std::mutex mutex;
+		std::pmr::unsynchronized_pool_resource pool;
+		std::vector<Command> commands;
+	};
+}
@@ -9,7 +9,8 @@ export namespace Engine
 	class IComponent
 	{
 	protected:
-		static inline int nextId = 0;
+		// Atomic, as the first use of a component type may be on any thread.
+		static inline std::atomic<int> nextId = 0;
 	};
 
 	template<typename T>
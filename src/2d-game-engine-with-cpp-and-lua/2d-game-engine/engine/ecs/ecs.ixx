@@ -4,3 +4,6 @@ export import :ecs.entity;
 export import :ecs.system;
 export import :ecs.registry;
 export import :ecs.pool;
+export import :ecs.archetype;
+export import :ecs.view;
+export import :ecs.commandbuffer;
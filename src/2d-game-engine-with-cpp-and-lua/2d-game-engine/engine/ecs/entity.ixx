@@ -8,20 +8,33 @@ export namespace Engine
 	// cyclic design and I really don't like this approach. I have 
 	// elected to avoid it. It's possible to template this and avoid the
 	// cyclic design, but then the System will also need to be templated.
+	//
+	// An entity is a handle: the index of its slot in the registry, and
+	// which of the entities to have had that slot it is. Slots are reused
+	// once their entity is killed, with the generation moved on, so a
+	// handle kept past its entity's death is told apart from the entity
+	// that reuses its slot, rather than quietly referring to it.
 	class Entity
 	{
 	public:
-		constexpr Entity(std::uint64_t id) : id{ id } {}
+		constexpr Entity(std::uint32_t index, std::uint32_t generation = 0) : index{ index }, generation{ generation } {}
 
-		constexpr auto GetId(this auto&& self) noexcept -> std::uint64_t
+		// The entity's index, unique among living entities, for indexing
+		// arrays by entity.
+		constexpr auto GetId(this auto&& self) noexcept -> std::uint32_t
 		{
-			return self.id;
+			return self.index;
+		}
+
+		constexpr auto GetGeneration(this auto&& self) noexcept -> std::uint32_t
+		{
+			return self.generation;
 		}
 
-		// Required for use in std::set
 		constexpr auto operator<=>(const Entity& other) const noexcept = default;
 
 	private:
-		std::uint64_t id = 0;
+		std::uint32_t index = 0;
+		std::uint32_t generation = 0;
 	};
 }
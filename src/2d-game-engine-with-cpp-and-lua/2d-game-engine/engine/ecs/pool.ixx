@@ -1,5 +1,6 @@
 export module engine:ecs.pool;
 import std;
+import :ecs.entity;
 
 export namespace Engine
 {
@@ -7,63 +8,180 @@ export namespace Engine
 	{
 	public:
 		virtual ~IPool() = default;
+
+		// Lets the registry drop a killed entity's components without
+		// knowing their types. Does nothing if the entity has none here.
+		virtual void Remove(Entity entity) = 0;
+		virtual auto Contains(Entity entity) const -> bool = 0;
 	};
 
+	// Sparse set storage for one component type. The components are packed
+	// together in one array, with the entity each belongs to at the same
+	// position in another, so iterating them never visits a hole. A paged
+	// sparse index maps entity IDs to positions; pages are allocated only
+	// for the ranges of IDs that have the component, so memory follows how
+	// many entities have it rather than how many there are.
 	template<typename T>
 	class Pool : public IPool
 	{
 	public:
-		virtual ~Pool() = default;
-
-		constexpr Pool(size_t size = 100) : data(size) {}
+		constexpr Pool() = default;
+		constexpr ~Pool() override = default;
 
 		constexpr auto IsEmpty() const -> bool
 		{
-			return data.empty();
+			return components.empty();
 		}
 
-		constexpr auto GetSize() const -> size_t
+		constexpr auto GetSize() const -> std::size_t
 		{
-			return data.size();
+			return components.size();
 		}
 
-		constexpr void Resize(size_t newSize)
+		constexpr void Clear()
 		{
-			data.resize(newSize);
+			components.clear();
+			entities.clear();
+			pages.clear();
 		}
 
-		constexpr void Clear()
+		constexpr auto Contains(Entity entity) const -> bool override
+		{
+			return IndexOf(entity).has_value();
+		}
+
+		// Adds the entity's component, or replaces the one it already has.
+		constexpr auto Set(Entity entity, T component) -> T&
+		{
+			if (auto index = IndexOf(entity))
+				return components[*index] = std::move(component);
+
+			auto& slot = SlotOf(entity);
+			components.push_back(std::move(component));
+			entities.push_back(entity);
+			slot = static_cast<Index>(components.size());
+			return components.back();
+		}
+
+		// Moves the last component into the removed one's place, so the
+		// arrays stay packed. Changes the order the components iterate in.
+		constexpr void Remove(Entity entity) override
+		{
+			auto index = IndexOf(entity);
+			if (not index)
+				return;
+
+			if (*index != components.size() - 1)
+			{
+				components[*index] = std::move(components.back());
+				entities[*index] = entities.back();
+				SlotOf(entities[*index]) = static_cast<Index>(*index + 1);
+			}
+			components.pop_back();
+			entities.pop_back();
+			SlotOf(entity) = 0;
+		}
+
+		constexpr auto Get(Entity entity) -> T&
 		{
-			data.clear();
+			auto index = IndexOf(entity);
+			if (not index)
+				throw std::out_of_range{ "Entity has no component in this pool" };
+			return components[*index];
 		}
 
-		constexpr void Add(const T& component)
+		constexpr auto Get(Entity entity) const -> const T&
 		{
-			data.push_back(component);
+			auto index = IndexOf(entity);
+			if (not index)
+				throw std::out_of_range{ "Entity has no component in this pool" };
+			return components[*index];
 		}
 
-		constexpr void Set(size_t index, const T& component)
+		constexpr auto operator[](Entity entity) -> T&
 		{
-			if (index >= data.size())
-				throw std::out_of_range{ "Index out of range" };
-			data[index] = component;
+			return Get(entity);
 		}
 
-		constexpr auto Get(size_t index) -> T&
+		// The components and the entities they belong to, in matching order.
+		constexpr auto GetComponents() -> std::span<T>
 		{
-			if (index >= data.size())
-				throw std::out_of_range{ "Index out of range" };
-			return data[index];
+			return components;
 		}
 
-		constexpr auto operator[](size_t index) -> T&
+		constexpr auto GetComponents() const -> std::span<const T>
 		{
-			if (index >= data.size())
-				throw std::out_of_range{ "Index out of range" };
-			return data[index];
+			return components;
+		}
+
+		constexpr auto GetEntities() const -> std::span<const Entity>
+		{
+			return entities;
 		}
 
 	private:
-		std::vector<T> data{};
+		// Sparse slots hold a position in the packed arrays plus one, so
+		// that a freshly zeroed page means no entity in it has the component.
+		using Index = std::uint32_t;
+		static constexpr auto PageSize = std::size_t{ 1024 };
+		using Page = std::array<Index, PageSize>;
+
+		constexpr auto IndexOf(Entity entity) const -> std::optional<std::size_t>
+		{
+			auto page = entity.GetId() / PageSize;
+			if (page >= pages.size() or not pages[page])
+				return std::nullopt;
+			auto slot = (*pages[page])[entity.GetId() % PageSize];
+			if (slot == 0)
+				return std::nullopt;
+			return slot - 1;
+		}
+
+		// Allocates the entity's page if it doesn't have one yet.
+		constexpr auto SlotOf(Entity entity) -> Index&
+		{
+			auto page = entity.GetId() / PageSize;
+			if (page >= pages.size())
+				pages.resize(page + 1);
+			if (not pages[page])
+				pages[page] = std::make_unique<Page>();
+			return (*pages[page])[entity.GetId() % PageSize];
+		}
+
+		std::vector<T> components{};
+		std::vector<Entity> entities{};
+		std::vector<std::unique_ptr<Page>> pages{};
 	};
 }
+
+namespace
+{
+	using namespace Engine;
+
+	// Test that removing keeps the pool packed and the other entities'
+	// components reachable, including across pages.
+	static_assert(
+		[] -> bool
+		{
+			auto pool = Pool<int>{};
+			pool.Set(Entity{ 1 }, 10);
+			pool.Set(Entity{ 5000 }, 50);
+			pool.Set(Entity{ 7 }, 70);
+			pool.Set(Entity{ 1 }, 11);
+			if (pool.GetSize() != 3 or pool.Get(Entity{ 1 }) != 11)
+				throw "Expected setting an existing component to replace it";
+			pool.Remove(Entity{ 1 });
+			pool.Remove(Entity{ 1 });
+			if (pool.GetSize() != 2 or pool.Contains(Entity{ 1 }))
+				throw "Expected 2 components after removing entity 1";
+			if (pool.Get(Entity{ 5000 }) != 50 or pool.Get(Entity{ 7 }) != 70)
+				throw "Expected the remaining components to be unchanged";
+			auto sum = 0;
+			for (auto component : pool.GetComponents())
+				sum += component;
+			if (sum != 120 or pool.GetEntities().size() != 2)
+				throw "Expected iteration to visit only the remaining components";
+			return true;
+		}()
+	);
+}
@@ -1,64 +1,107 @@
 export module engine:ecs.registry;
 import std;
-import :log;
 import :ecs.component;
 import :ecs.system;
 import :ecs.entity;
 import :ecs.pool;
+import :ecs.archetype;
+import :ecs.view;
 
 export namespace Engine
 {
+	enum class StorageMode
+	{
+		// A sparse set per component type. Adding and removing components
+		// is cheapest, but a system reading several components of an entity
+		// looks each up in a different pool.
+		SparseSet,
+		// Entities with the same components are stored together, in chunks
+		// of a column per component, so View() streams through memory.
+		// Adding or removing a component moves the entity's others.
+		Archetype
+	};
+
 	class Registry
 	{
 	public:
+		explicit Registry(StorageMode storageMode = StorageMode::SparseSet)
+			: storageMode{ storageMode }
+		{}
+
+		// Reuses the slot of an entity killed before, if there is one. The
+		// entity joins the systems that want it in the next Update().
 		auto CreateEntity() -> Entity
 		{
-			auto entityId =
-				[this] -> std::uint64_t
-				{
-					// If there are any free IDs, reuse them; otherwise, create a new ID.
-					if (freeIds.empty())
-					{
-						auto id = numEntities++;
-						if (id >= entityComponentSignatures.size())
-							entityComponentSignatures.resize(id + 1);
-						return id;
-					}
-					else
-					{
-						auto id = freeIds.front();
-						freeIds.pop_front();
-						return id;
-					}
-				}();
-			
-			auto entity = Entity{ entityId };
-			entitiesToBeAdded.insert(entity);
-			Log::Info("Created entity with ID: {}", entityId);
+			auto index = firstFreeSlot;
+			if (index == NoSlot)
+			{
+				index = static_cast<std::uint32_t>(slots.size());
+				slots.emplace_back();
+			}
+			else
+				firstFreeSlot = slots[index].nextFreeSlot;
 
+			auto& slot = slots[index];
+			slot.nextFreeSlot = NoSlot;
+			slot.isAlive = true;
+			auto entity = Entity{ index, slot.generation };
+			QueueForSystems(entity);
 			return entity;
 		}
 
+		// The entity stays alive, and in its systems, until the next
+		// Update(). Killing an entity twice, or one that's already dead,
+		// does nothing.
 		void KillEntity(Entity entity)
 		{
-			entitiesToBeKilled.insert(entity);
-			Log::Info("Killed entity with ID: {}", entity.GetId());
+			if (not IsAlive(entity))
+				return;
+			auto& slot = slots[entity.GetId()];
+			if (slot.isPendingKill)
+				return;
+			slot.isPendingKill = true;
+			entitiesToBeKilled.push_back(entity);
+		}
+
+		// True until the Update() after the entity is killed. False for a
+		// handle to an entity whose slot has since been reused.
+		auto IsAlive(Entity entity) const noexcept -> bool
+		{
+			auto index = entity.GetId();
+			return index < slots.size() and slots[index].isAlive and slots[index].generation == entity.GetGeneration();
 		}
 
 		// Add or remove entities after the update loop to avoid modifying collections while iterating
 		void Update()
 		{
 			for (auto entity : entitiesToBeAdded)
+			{
+				slots[entity.GetId()].isPendingAdd = false;
 				AddEntityToSystems(entity);
+			}
 			entitiesToBeAdded.clear();
 
 			// process entities to be killed
 			for (auto entity : entitiesToBeKilled)
 			{
 				RemoveEntityFromSystems(entity);
-				// make the id free for reuse
-				freeIds.push_back(entity.GetId());
-				entityComponentSignatures[entity.GetId()].reset();
+				if (storageMode == StorageMode::Archetype)
+					archetypes.RemoveEntity(entity);
+				else
+					for (auto& pool : componentPools)
+						if (pool)
+							pool->Remove(entity);
+				// The slot goes on the free list, with a new generation, so
+				// that handles to this entity aren't mistaken for the next
+				// one to have it. Generations wrap around after 2^32 uses of
+				// a slot.
+				auto& slot = slots[entity.GetId()];
+				slot.signature.reset();
+				slot.generation++;
+				slot.isAlive = false;
+				slot.isPendingKill = false;
+				slot.nextFreeSlot = firstFreeSlot;
+				firstFreeSlot = entity.GetId();
 			}
 			entitiesToBeKilled.clear();
 		}
@@ -66,44 +109,121 @@ export namespace Engine
 		template<typename TComponent, typename...TArgs>
 		auto AddComponent(Entity entity, TArgs&&... args) -> Registry&
 		{
+			ThrowIfDead(entity);
 			auto componentId = Component<TComponent>::GetId();
-			if (componentId >= componentPools.size())
-				componentPools.resize(componentId + 1, nullptr);
-			if (not componentPools[componentId])
-				componentPools[componentId] = std::make_shared<Pool<TComponent>>();
-				
-			auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-			auto entityId = entity.GetId();
-			if (entityId >= componentPool->GetSize())
-				componentPool->Resize(numEntities);
-
-			componentPool->Set(entityId, TComponent{ std::forward<TArgs>(args)... });
-			entityComponentSignatures[entityId].set(componentId);
+			if (storageMode == StorageMode::Archetype)
+				archetypes.Set(entity, TComponent{ std::forward<TArgs>(args)... });
+			else
+				GetPool<TComponent>().Set(entity, TComponent{ std::forward<TArgs>(args)... });
+			slots[entity.GetId()].signature.set(componentId);
+			// Systems that now want the entity get it in the next Update(),
+			// like a new entity, so a system going through its entities
+			// never has them added underneath it.
+			QueueForSystems(entity);
 			return *this;
 		}
 
 		template<typename T>
 		void RemoveComponent(Entity entity)
 		{
+			ThrowIfDead(entity);
 			auto componentId = Component<T>::GetId();
 			auto entityId = entity.GetId();
-			entityComponentSignatures[entityId].set(componentId, false); //.reset(componentId) also works;
+			if (storageMode == StorageMode::Archetype)
+				archetypes.Remove<T>(entity);
+			else if (componentId < componentPools.size() and componentPools[componentId])
+				componentPools[componentId]->Remove(entity);
+			slots[entityId].signature.set(componentId, false); //.reset(componentId) also works;
+			// The component is gone now, so systems that need it have to
+			// stop seeing the entity now too.
+			for (auto& [_, system] : systems)
+				if (system->GetSignature().test(componentId))
+					system->RemoveEntity(entity);
 		}
 
 		template<typename T>
 		auto HasComponent(Entity entity) -> bool
 		{
 			auto componentId = Component<T>::GetId();
-			auto entityId = entity.GetId();
-			return entityComponentSignatures[entityId].test(componentId);
+			return IsAlive(entity) and slots[entity.GetId()].signature.test(componentId);
 		}
 
 		template<typename T>
 		auto GetComponent(Entity entity) -> T&
 		{
+			ThrowIfDead(entity);
+			if (storageMode == StorageMode::Archetype)
+				return archetypes.Get<T>(entity);
+			// Cast the raw pointer, as copying the shared_ptr would have
+			// systems running at the same time contend for its count.
 			auto componentId = Component<T>::GetId();
-			auto entityId = entity.GetId();
-			return std::static_pointer_cast<Pool<T>>(componentPools[componentId])->Get(entityId);
+			return static_cast<Pool<T>*>(componentPools[componentId].get())->Get(entity);
+		}
+
+		// For iterating every component of a type, packed together, with
+		// the entities they belong to in GetEntities() in the same order.
+		// Only sparse set storage has pools.
+		template<typename T>
+		auto GetPool() -> Pool<T>&
+		{
+			if (storageMode != StorageMode::SparseSet)
+				throw std::logic_error{ "Pools are only used by sparse set storage" };
+			auto componentId = Component<T>::GetId();
+			if (componentId >= componentPools.size())
+				componentPools.resize(componentId + 1, nullptr);
+			if (not componentPools[componentId])
+				componentPools[componentId] = std::make_shared<Pool<T>>();
+			return *std::static_pointer_cast<Pool<T>>(componentPools[componentId]);
+		}
+
+		// Fills chunks with every entity that has all of TComponents, a
+		// chunk at a time:
+		//
+		//	registry.View(chunks); // a std::vector<ViewChunk<TransformComponent, RigidBodyComponent>>
+		//	for (auto chunk : chunks)
+		//		for (auto&& [transform, rigidBody] : chunk.Each())
+		//
+		// With archetype storage each chunk is an archetype chunk, its
+		// components contiguous. Sparse sets have no chunks, so there each
+		// entity comes in a chunk of its own. The vector is cleared first,
+		// not freed, so a caller that keeps it from one frame to the next
+		// allocates nothing once it's grown to fit. Adding or removing
+		// components while going through a view invalidates it.
+		template<typename TFirst, typename...TRest>
+		void View(std::vector<ViewChunk<TFirst, TRest...>>& chunks)
+		{
+			chunks.clear();
+			if (storageMode == StorageMode::Archetype)
+			{
+				auto required = Signature{};
+				required.set(Component<TFirst>::GetId());
+				(required.set(Component<TRest>::GetId()), ...);
+				for (auto& archetype : archetypes.GetArchetypes())
+				{
+					if ((archetype->GetSignature() & required) != required)
+						continue;
+					for (auto chunk = std::size_t{ 0 }; chunk < archetype->GetChunkCount(); chunk++)
+						if (archetype->GetChunkSize(chunk) > 0)
+							chunks.emplace_back(
+								archetype->GetEntities(chunk),
+								archetype->GetColumn<TFirst>(chunk).data(),
+								archetype->GetColumn<TRest>(chunk).data()...);
+				}
+			}
+			else
+			{
+				// Not GetPool(), which creates the pool if there isn't one,
+				// as views are taken by systems running at the same time.
+				auto componentId = Component<TFirst>::GetId();
+				if (componentId >= componentPools.size() or not componentPools[componentId])
+					return;
+				auto& pool = *std::static_pointer_cast<Pool<TFirst>>(componentPools[componentId]);
+				auto entities = pool.GetEntities();
+				auto components = pool.GetComponents();
+				for (auto i = std::size_t{ 0 }; i < entities.size(); i++)
+					if ((HasComponent<TRest>(entities[i]) and ...))
+						chunks.emplace_back(entities.subspan(i, 1), &components[i], &GetComponent<TRest>(entities[i])...);
+			}
 		}
 
 		template<typename TSystem, typename...TArgs>
@@ -138,7 +258,7 @@ export namespace Engine
 
 		void AddEntityToSystems(Entity entity)
 		{
-			auto entitySignature = entityComponentSignatures[entity.GetId()];
+			auto entitySignature = slots[entity.GetId()].signature;
 			for (auto& [_, system] : systems)
 			{
 				auto systemSignature = system->GetSignature();
@@ -155,14 +275,49 @@ export namespace Engine
 		}
 
 	private:
-		unsigned numEntities = 0;
+		static constexpr auto NoSlot = std::numeric_limits<std::uint32_t>::max();
+
+		// What the registry knows of each entity, by index. Slots of
+		// killed entities form a list of free ones, through nextFreeSlot,
+		// so reusing them needs nothing beyond the slots themselves.
+		struct EntitySlot
+		{
+			Signature signature{};
+			std::uint32_t generation = 0;
+			std::uint32_t nextFreeSlot = NoSlot;
+			bool isAlive = false;
+			// So that an entity is queued at most once each, however many
+			// components it's given or times it's killed before Update().
+			bool isPendingAdd = false;
+			bool isPendingKill = false;
+		};
+
+		void QueueForSystems(Entity entity)
+		{
+			auto& slot = slots[entity.GetId()];
+			if (slot.isPendingAdd)
+				return;
+			slot.isPendingAdd = true;
+			entitiesToBeAdded.push_back(entity);
+		}
+
+		void ThrowIfDead(Entity entity) const
+		{
+			if (not IsAlive(entity))
+				throw std::out_of_range{ std::format("Entity {} generation {} is no longer alive", entity.GetId(), entity.GetGeneration()) };
+		}
+
+		StorageMode storageMode;
 		std::vector<std::shared_ptr<IPool>> componentPools{};
-		std::vector<Signature> entityComponentSignatures{};
+		ArchetypeStorage archetypes{};
+		std::vector<EntitySlot> slots{};
+		std::uint32_t firstFreeSlot = NoSlot;
 		std::unordered_map<std::type_index, std::shared_ptr<System>> systems{};
 
-		std::set<Entity> entitiesToBeAdded{};
-		std::set<Entity> entitiesToBeKilled{};
-
-		std::deque<std::uint64_t> freeIds{};
+		// Flat, and cleared rather than freed by Update(), so that once
+		// they've grown to fit, creating and killing entities allocates
+		// nothing.
+		std::vector<Entity> entitiesToBeAdded{};
+		std::vector<Entity> entitiesToBeKilled{};
 	};
 }
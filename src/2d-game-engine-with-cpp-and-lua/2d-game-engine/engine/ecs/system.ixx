@@ -9,19 +9,47 @@ export namespace Engine
 	{
 	public:
 		System() = default;
+		constexpr virtual ~System() {}
 
+		// Keeps one copy if the entity is already in the system, so the
+		// registry can add an entity again when its components change.
 		constexpr auto AddEntity(this auto& self, Entity entity) -> decltype(auto)
 		{
-			self.entities.push_back(entity);
+			auto id = entity.GetId();
+			if (id >= self.positions.size())
+				self.positions.resize(id + 1);
+			if (self.positions[id] == 0)
+			{
+				self.entities.push_back(entity);
+				self.positions[id] = static_cast<std::uint32_t>(self.entities.size());
+			}
+			static_cast<System&>(self).OnEntityAdded(entity);
 			return std::forward_like<decltype(self)>(self);
 		}
+		// Moves the last entity into the removed one's place, so it's
+		// constant time but changes the order of the rest.
 		constexpr void RemoveEntity(this System& self, Entity entity)
 		{
-			auto it = std::ranges::find_if(self.entities, [&](const auto& e) { return e == entity; });
-			if (it != self.entities.end())
-				self.entities.erase(it);
+			if (not self.HasEntity(entity))
+				return;
+			auto id = entity.GetId();
+			auto index = self.positions[id] - 1;
+			self.entities[index] = self.entities.back();
+			self.positions[self.entities[index].GetId()] = index + 1;
+			self.entities.pop_back();
+			self.positions[id] = 0;
+			self.OnEntityRemoved(entity);
 		}
-		constexpr auto GetEntities(this const System& self) -> std::vector<Entity>
+		constexpr auto HasEntity(this const System& self, Entity entity) -> bool
+		{
+			// The entity in the system must be this one, not an earlier one
+			// with the same index.
+			auto id = entity.GetId();
+			return id < self.positions.size() and self.positions[id] != 0 and self.entities[self.positions[id] - 1] == entity;
+		}
+		// Stays valid until the registry next adds entities to systems,
+		// in Registry::Update(), or removes one from this system.
+		constexpr auto GetEntities(this const System& self) -> std::span<const Entity>
 		{
 			return self.entities;
 		}
@@ -36,9 +64,45 @@ export namespace Engine
 			const auto componentId = Component<TComponent>::GetId();
 			self.componentSignature.set(componentId);
 		}
+
+		// Declare which components the system's update reads and writes,
+		// so the scheduler knows which systems can run at the same time.
+		// These are separate from the required components: a system may
+		// read components it doesn't require, or require ones it never reads.
+		template<typename TComponent>
+		constexpr void ReadsComponent(this System& self)
+		{
+			self.reads.set(Component<TComponent>::GetId());
+		}
+		template<typename TComponent>
+		constexpr void WritesComponent(this System& self)
+		{
+			self.writes.set(Component<TComponent>::GetId());
+		}
+		constexpr auto GetReads(this const System& self) -> const Signature&
+		{
+			return self.reads;
+		}
+		constexpr auto GetWrites(this const System& self) -> const Signature&
+		{
+			return self.writes;
+		}
+	protected:
+		// Called when the entity joins the system, and again each time the
+		// registry offers it after it's given a component while already
+		// in it, for systems that keep something about their entities.
+		constexpr virtual void OnEntityAdded(Entity) {}
+		// Called once the entity has left the system.
+		constexpr virtual void OnEntityRemoved(Entity) {}
+
 	private:
 		Signature componentSignature{};
+		Signature reads{};
+		Signature writes{};
 		std::vector<Entity> entities{};
+		// Each entity's position in entities plus one, by ID; zero for
+		// entities not in the system.
+		std::vector<std::uint32_t> positions{};
 	};
 }
 
@@ -62,4 +126,38 @@ namespace
 			return true;
 		}()
 	);
+
+	// Test that adding an entity twice keeps one copy, and that removing
+	// from the middle keeps the rest reachable.
+	static_assert(
+		[] -> bool
+		{
+			auto s = System{};
+			s.AddEntity(Entity{ 4 }).AddEntity(Entity{ 7 }).AddEntity(Entity{ 9 }).AddEntity(Entity{ 7 });
+			if (s.GetEntities().size() != 3)
+				throw "Expected adding an entity again to do nothing";
+			s.RemoveEntity(Entity{ 4 });
+			s.RemoveEntity(Entity{ 4 });
+			s.RemoveEntity(Entity{ 9 });
+			if (s.GetEntities().size() != 1 or not s.HasEntity(Entity{ 7 }) or s.HasEntity(Entity{ 9 }))
+				throw "Expected only entity 7 to be left";
+			return true;
+		}()
+	);
+
+	// Test that a handle to an earlier entity with the same index is
+	// neither found in the system nor removes the entity that's there.
+	static_assert(
+		[] -> bool
+		{
+			auto s = System{};
+			s.AddEntity(Entity{ 3, 1 });
+			if (s.HasEntity(Entity{ 3, 0 }) or not s.HasEntity(Entity{ 3, 1 }))
+				throw "Expected only the current generation to be found";
+			s.RemoveEntity(Entity{ 3, 0 });
+			if (s.GetEntities().size() != 1)
+				throw "Expected removing a stale handle to do nothing";
+			return true;
+		}()
+	);
 }
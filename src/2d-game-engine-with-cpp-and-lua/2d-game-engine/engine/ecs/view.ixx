@@ -0,0 +1,67 @@
+export module engine:ecs.view;
+import std;
+import :ecs.entity;
+
+export namespace Engine
+{
+	// A run of entities that have all of TComponents, and spans of those
+	// components in the same order. With archetype storage each is a whole
+	// chunk, so going through one reads each component's memory in order.
+	template<typename...TComponents>
+	class ViewChunk
+	{
+	public:
+		constexpr ViewChunk(std::span<const Entity> entities, TComponents*... columns)
+			: entities{ entities }, columns{ columns... }
+		{}
+
+		constexpr auto GetSize() const -> std::size_t
+		{
+			return entities.size();
+		}
+
+		constexpr auto GetEntities() const -> std::span<const Entity>
+		{
+			return entities;
+		}
+
+		template<typename T>
+		constexpr auto Get() const -> std::span<T>
+		{
+			return { std::get<T*>(columns), entities.size() };
+		}
+
+		// Each entity's components, as a tuple of references.
+		constexpr auto Each() const
+		{
+			return std::views::zip(Get<TComponents>()...);
+		}
+
+	private:
+		std::span<const Entity> entities;
+		std::tuple<TComponents*...> columns;
+	};
+}
+
+namespace
+{
+	using namespace Engine;
+
+	// Test that a chunk lines its columns up by entity.
+	static_assert(
+		[] -> bool
+		{
+			auto entities = std::array{ Entity{ 3 }, Entity{ 4 } };
+			auto positions = std::array{ 1, 2 };
+			auto speeds = std::array{ 10.0, 20.0 };
+			auto chunk = ViewChunk<int, double>{ entities, positions.data(), speeds.data() };
+			for (auto&& [position, speed] : chunk.Each())
+				position += static_cast<int>(speed);
+			if (chunk.GetSize() != 2 or positions[0] != 11 or positions[1] != 22)
+				throw "Expected each entity's components to be updated together";
+			if (chunk.Get<double>()[1] != 20.0 or chunk.GetEntities()[1].GetId() != 4)
+				throw "Expected the columns to be in the entities' order";
+			return true;
+		}()
+	);
+}
@@ -10,6 +10,9 @@ export import :concepts;
 export import :components;
 export import :ecs;
 export import :systems;
+export import :collision;
+export import :scheduler;
+export import :render;
 export import :assetstore;
 export import :build;
 export import :events;
@@ -1,44 +1,178 @@
 export module engine:eventbus.bus;
 import std;
+import :concepts;
 import :eventbus.eventcallback;
 
 export namespace Engine
 {
-	using HandlerList = std::list<std::unique_ptr<IEventCallback>>;
+	// Identifies a subscription, to unsubscribe with.
+	struct EventSubscription
+	{
+		std::size_t eventId = 0;
+		std::uint64_t id = 0;
+	};
 
-	class EventBus
+	// Delivers events of the types it's declared with to the handlers
+	// subscribed to them. Each type's handlers are kept in a vector of their
+	// own, found by the type's position in TEvents at compile time, so
+	// emitting an event costs no lookup, and subscriptions last until
+	// they're unsubscribed rather than being made again every frame.
+	//
+	// Events can be emitted, calling their handlers at once, or queued and
+	// then dispatched together, e.g. those systems raised during the frame
+	// once the systems have finished. Once the vectors have grown to a
+	// frame's worth of events, neither allocates.
+	//
+	// Events may be queued from any thread; subscribing, unsubscribing,
+	// emitting and dispatching are for one thread at a time.
+	template<typename...TEvents>
+	class BasicEventBus
 	{
 	public:
-		template<typename TEvent, typename TOwner>
-		void SubscribeToEvent(TOwner* owner, EventCallback<TOwner, TEvent>::CallbackFunction callback)
+		// An event type's position in TEvents.
+		template<Concepts::OneOf<TEvents...> TEvent>
+		static constexpr auto EventId = []
+			{
+				auto index = std::size_t{ 0 };
+				((std::same_as<TEvent, TEvents> ? false : (index++, true)) and ...);
+				return index;
+			}();
+
+		// Subscribes owner->*Method to the events its parameter takes, e.g.
+		// Subscribe<&DamageSystem::OnCollision>(this).
+		template<auto Method, typename TOwner>
+		auto Subscribe(TOwner* owner) -> EventSubscription
 		{
-			if (not subscribers.contains(typeid(TEvent)))
-				subscribers[typeid(TEvent)] = HandlerList{};
+			using TEvent = std::remove_cvref_t<typename MethodTraits<decltype(Method)>::Event>;
+			return Subscribe<TEvent>(EventCallback<TEvent>::template Bind<Method>(owner));
+		}
 
-			auto subscriber = std::make_unique<EventCallback<TOwner, TEvent>>(owner, callback);
-			subscribers[typeid(TEvent)].push_back(std::move(subscriber));
+		template<Concepts::OneOf<TEvents...> TEvent>
+		auto Subscribe(EventCallback<TEvent> callback) -> EventSubscription
+		{
+			auto id = ++lastSubscriptionId;
+			GetChannel<TEvent>().handlers.push_back({ id, callback });
+			return { EventId<TEvent>, id };
+		}
+
+		// Handlers unsubscribed while events are dispatched to them aren't
+		// called again, even for the rest of the batch.
+		void Unsubscribe(const EventSubscription& subscription)
+		{
+			((subscription.eventId == EventId<TEvents> ? GetChannel<TEvents>().Remove(subscription.id) : void()), ...);
 		}
 
-		template<typename TEvent, typename...TArgs>
+		// Calls the event's handlers now.
+		template<Concepts::OneOf<TEvents...> TEvent, typename...TArgs>
 		void EmitEvent(TArgs&&... args)
 		{
-			//auto handlers = subscribers[typeid(TEvent)];//  subscribers.find(typeid(TEvent));
-			auto handlers = subscribers.find(typeid(TEvent));
-			if (handlers == subscribers.end())
-				return;
-			for (auto& handler : handlers->second)
+			GetChannel<TEvent>().Deliver(TEvent{ std::forward<TArgs>(args)... });
+		}
+
+		// Keeps the event until its type is next dispatched.
+		template<Concepts::OneOf<TEvents...> TEvent, typename...TArgs>
+		void QueueEvent(TArgs&&... args)
+		{
+			auto& channel = GetChannel<TEvent>();
+			auto lock = std::scoped_lock{ channel.queueMutex };
+			channel.queue.emplace_back(std::forward<TArgs>(args)...);
+		}
+
+		// Delivers the queued events of the type, in the order they were
+		// queued. Events queued by their handlers wait for the next dispatch.
+		template<Concepts::OneOf<TEvents...> TEvent>
+		void DispatchEvents()
+		{
+			auto& channel = GetChannel<TEvent>();
 			{
-				auto event = TEvent{std::forward<TArgs>(args)...};
-				handler->Execute(event);
+				auto lock = std::scoped_lock{ channel.queueMutex };
+				std::swap(channel.queue, channel.dispatching);
 			}
+			for (auto& event : channel.dispatching)
+				channel.Deliver(event);
+			channel.dispatching.clear();
 		}
 
-		void Reset()
+		// Delivers the queued events of every type.
+		void DispatchEvents()
 		{
-			subscribers.clear();
+			(DispatchEvents<TEvents>(), ...);
 		}
 
 	private:
-		std::map<std::type_index, HandlerList> subscribers{};
+		template<typename TMethod>
+		struct MethodTraits;
+		template<typename TOwner, typename TParameter>
+		struct MethodTraits<void (TOwner::*)(TParameter)>
+		{
+			using Event = TParameter;
+		};
+
+		template<typename TEvent>
+		struct Channel
+		{
+			struct Handler
+			{
+				std::uint64_t id = 0;
+				EventCallback<TEvent> callback;
+			};
+
+			std::vector<Handler> handlers;
+			// Deliver() calls nested in a handler, so that removals wait
+			// until nothing is going through the handlers.
+			int delivering = 0;
+			bool hasRemovals = false;
+
+			std::mutex queueMutex;
+			std::vector<TEvent> queue;
+			// Swapped with the queue when dispatching, keeping both their
+			// capacities.
+			std::vector<TEvent> dispatching;
+
+			void Deliver(const TEvent& event)
+			{
+				delivering++;
+				// By index, as handlers may subscribe others, which only get
+				// the next event.
+				for (auto i = std::size_t{ 0 }, count = handlers.size(); i < count; i++)
+					if (handlers[i].callback)
+						handlers[i].callback(event);
+				if (--delivering == 0 and hasRemovals)
+				{
+					std::erase_if(handlers, [](const Handler& handler) { return not handler.callback; });
+					hasRemovals = false;
+				}
+			}
+
+			void Remove(std::uint64_t id)
+			{
+				auto handler = std::ranges::find(handlers, id, &Handler::id);
+				if (handler == handlers.end())
+					return;
+				if (delivering > 0)
+				{
+					handler->callback = {};
+					hasRemovals = true;
+				}
+				else
+					handlers.erase(handler);
+			}
+		};
+
+		template<typename TEvent>
+		auto GetChannel() -> Channel<TEvent>&
+		{
+			return std::get<EventId<TEvent>>(channels);
+		}
+
+		std::tuple<Channel<TEvents>...> channels;
+		std::uint64_t lastSubscriptionId = 0;
 	};
-}
\ No newline at end of file
+}
+
+namespace
+{
+	// Test that event types get consecutive IDs in the order they're declared.
+	static_assert(Engine::BasicEventBus<int, float, char>::EventId<int> == 0);
+	static_assert(Engine::BasicEventBus<int, float, char>::EventId<char> == 2);
+}
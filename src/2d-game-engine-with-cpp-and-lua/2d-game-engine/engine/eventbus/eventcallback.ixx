@@ -1,35 +1,43 @@
 export module engine:eventbus.eventcallback;
 import std;
-import :eventbus.event;
 
 export namespace Engine
 {
-	class IEventCallback
+	// A handler for events of type TEvent: an object and a function to call
+	// on it. Two pointers, so storing one never allocates and calling one
+	// is an indirect call rather than a virtual one.
+	template<typename TEvent>
+	class EventCallback
 	{
 	public:
-		virtual ~IEventCallback() = default;
-		void Execute(const Event& event)
+		// Calls owner->*Method(event), with the method fixed at compile time
+		// so it needn't be stored.
+		template<auto Method, typename TOwner>
+		static constexpr auto Bind(TOwner* owner) noexcept -> EventCallback
 		{
-			Call(event);
+			return {
+				owner,
+				[](void* owner, const TEvent& event) { std::invoke(Method, static_cast<TOwner*>(owner), event); }
+			};
 		}
-	private:
-		virtual void Call(const Event& event) = 0;
-	};
 
-	template<typename TOwner, typename TEvent>
-	class EventCallback : public IEventCallback
-	{
-	public:
-		using CallbackFunction = auto(TOwner::*)(const TEvent&)->void;
-		EventCallback(TOwner* owner, CallbackFunction callback)
-			: owner(owner), callback(callback)
+		constexpr EventCallback() = default;
+		constexpr EventCallback(void* owner, void (*function)(void*, const TEvent&)) noexcept
+			: owner{ owner }, function{ function }
 		{}
-	private:
-		TOwner* owner = nullptr;
-		CallbackFunction callback = nullptr;
-		void Call(const Event& event) override
+
+		constexpr void operator()(const TEvent& event) const
 		{
-			std::invoke(callback, owner, static_cast<const TEvent&>(event));
+			function(owner, event);
 		}
+
+		constexpr explicit operator bool() const noexcept
+		{
+			return function != nullptr;
+		}
+
+	private:
+		void* owner = nullptr;
+		void (*function)(void*, const TEvent&) = nullptr;
 	};
-}
\ No newline at end of file
+}
@@ -1,3 +1,11 @@
 export module engine:events;
 export import :events.collisionevent;
 export import :events.keypressedevent;
+import :eventbus.bus;
+
+export namespace Engine
+{
+	// Every event type the game raises. Adding one here gives it an ID and
+	// a place in the bus.
+	using EventBus = BasicEventBus<CollisionEvent, KeyPressedEvent>;
+}
@@ -10,6 +10,8 @@ import :components;
 import :systems;
 import :assetstore;
 import :events;
+import :scheduler;
+import :render;
 
 export namespace Engine
 {
@@ -57,6 +59,16 @@ export namespace Engine
 
 		void LoadLevel(this Game& self, int level)
 		{
+			// Textures are loaded first, as sprites and the systems that
+			// create them refer to textures by handle.
+			auto chopperImage = self.assetStore.AddTexture(self.renderer.get(), "chopper-image", "./assets/images/chopper-spritesheet.png");
+			auto tankImage = self.assetStore.AddTexture(self.renderer.get(), "tank-image", "./assets/images/tank-panther-right.png");
+			auto truckImage = self.assetStore.AddTexture(self.renderer.get(), "truck-image", "./assets/images/truck-ford-right.png");
+			auto radarImage = self.assetStore.AddTexture(self.renderer.get(), "radar-image", "./assets/images/radar.png");
+			// parse tileset, there are 30 tiles in 3 rows of 10 columns, each tile is 32x32 pixels, index is 0-29
+			auto tilemapImage = self.assetStore.AddTexture(self.renderer.get(), "tilemap-image", "./assets/tilemaps/jungle.png");
+			auto bulletImage = self.assetStore.AddTexture(self.renderer.get(), "bullet-image", "./assets/images/bullet.png");
+
 			self.registry
 				.AddSystem<MovementSystem>(self.registry)
 				.AddSystem<RenderSystem>(self.registry)
@@ -66,39 +78,37 @@ export namespace Engine
 				.AddSystem<DebugRenderSystem>(self.registry)
 				.AddSystem<KeyboardControlSystem>(self.registry)
 				.AddSystem<CameraMovementSystem>(self.registry)
-				.AddSystem<ProjectileEmitSystem>();
+				.AddSystem<ProjectileEmitSystem>(bulletImage);
 
-			self.assetStore.AddTexture(self.renderer.get(), "chopper-image", "./assets/images/chopper-spritesheet.png");
-			self.assetStore.AddTexture(self.renderer.get(), "tank-image", "./assets/images/tank-panther-right.png");
-			self.assetStore.AddTexture(self.renderer.get(), "truck-image", "./assets/images/truck-ford-right.png");
-			self.assetStore.AddTexture(self.renderer.get(), "radar-image", "./assets/images/radar.png");
-			// parse tileset, there are 30 tiles in 3 rows of 10 columns, each tile is 32x32 pixels, index is 0-29
-			self.assetStore.AddTexture(self.renderer.get(), "tilemap-image", "./assets/tilemaps/jungle.png");
-			self.assetStore.AddTexture(self.renderer.get(), "bullet-image", "./assets/images/bullet.png");
+			// Subscriptions last for the rest of the game.
+			self.registry.GetSystem<DamageSystem>().SubscribeToEvents(self.eventBus);
+			self.registry.GetSystem<KeyboardControlSystem>().SubscribeToEvents(self.eventBus);
+
+			// Each tile in the map file is its row then its column in the
+			// tileset, as two digits.
 			auto tileSize = 32;
-			auto tileScale = 3.0;
+			auto tileScale = 3.0f;
 			auto mapNumCols = 25;
 			auto mapNumRows = 20;
+			auto tilesetNumCols = 10;
 			auto mapFile = std::fstream{ "./assets/tilemaps/jungle.map" };
+			auto tiles = std::vector<TileMap::Tile>{};
+			tiles.reserve(mapNumCols * mapNumRows);
 			for (int y = 0; y < mapNumRows; y++)
 			{
 				for (int x = 0; x < mapNumCols; x++)
 				{
-					auto ch = char{};
-					mapFile.get(ch);
-					auto srcRectY = std::atoi(&ch) * tileSize;
-					mapFile.get(ch);
-					auto srcRectX = std::atoi(&ch) * tileSize;
+					auto row = char{};
+					auto column = char{};
+					mapFile.get(row);
+					mapFile.get(column);
 					mapFile.ignore();
-
-					auto tile = Entity{ self.registry.CreateEntity() };
-					self.registry
-						.AddComponent<TransformComponent>(tile, glm::vec2{ x * (tileScale * tileSize), y * (tileScale * tileSize) }, glm::vec2{ tileScale, tileScale }, 0.0)
-						.AddComponent<SpriteComponent>(tile, "tilemap-image", tileSize, tileSize, 0, srcRectX, srcRectY);
+					tiles.push_back(static_cast<TileMap::Tile>((row - '0') * tilesetNumCols + (column - '0')));
 				}
 			}
-			MapWidth = mapNumCols * tileSize * tileScale;
-			MapHeight = mapNumRows * tileSize * tileScale;
+			self.tileMap = TileMap{ tilemapImage, tilesetNumCols, tileSize, tileScale, mapNumCols, mapNumRows, std::move(tiles) };
+			MapWidth = static_cast<int>(self.tileMap.GetWidth());
+			MapHeight = static_cast<int>(self.tileMap.GetHeight());
 
 			auto chopper = Entity{ self.registry.CreateEntity() };
 			constexpr auto Speed = 1500.f;
@@ -106,7 +116,7 @@ export namespace Engine
 				.AddComponent<TransformComponent>(chopper, glm::vec2{ 10.0f, 10.0f }, glm::vec2{ 1.0f, 1.0f }, 0.0)
 				.AddComponent<RigidBodyComponent>(chopper, glm::vec2{ 100.0f, 0.0f }, 1.0f)
 				// Since the initial velocity is to the right, the initial srcRect.y should be 32 * 1 (the second row of the spritesheet)
-				.AddComponent<SpriteComponent>(chopper, "chopper-image", 32, 32, 1, 0, 32*1)
+				.AddComponent<SpriteComponent>(chopper, chopperImage, 32, 32, 1, 0, 32*1)
 				.AddComponent<AnimationComponent>(chopper, 2, 15, true)
 				.AddComponent<KeyboardControlledComponent>(chopper, glm::vec2{0, -Speed}, glm::vec2{Speed, 0}, glm::vec2{0, Speed}, glm::vec2{-Speed, 0})
 				.AddComponent<CameraFollowComponent>(chopper);
@@ -115,14 +125,14 @@ export namespace Engine
 			self.registry
 				.AddComponent<TransformComponent>(radar, glm::vec2{ WindowWidth* tileScale - 74, 10 }, glm::vec2{ 1.0f, 1.0f }, 0.0)
 				.AddComponent<RigidBodyComponent>(radar, glm::vec2{ 0, 0.0f }, 1.0f)
-				.AddComponent<SpriteComponent>(radar, "radar-image", 64, 64, 2, 0, 0, true)
+				.AddComponent<SpriteComponent>(radar, radarImage, 64, 64, 2, 0, 0, true)
 				.AddComponent<AnimationComponent>(radar, 8, 5, true);
 
 			auto tank = Entity{ self.registry.CreateEntity() };
 			self.registry
 				.AddComponent<TransformComponent>(tank, glm::vec2{ 500.0f, 10.0f }, glm::vec2{ 1.0f, 1.0f }, 0.0)
 				.AddComponent<RigidBodyComponent>(tank, glm::vec2{ -0, 0.0f }, 1.0f)
-				.AddComponent<SpriteComponent>(tank, "tank-image", 32, 32, 1)
+				.AddComponent<SpriteComponent>(tank, tankImage, 32, 32, 1)
 				.AddComponent<BoxColliderComponent>(tank, 32, 32)
 				.AddComponent<ProjectileEmitterComponent>(tank, glm::vec2{ 500.0f, 0.0f }, 5000, 10000, 0)
 				;
@@ -131,7 +141,7 @@ export namespace Engine
 			self.registry
 				.AddComponent<TransformComponent>(truck, glm::vec2{ 10.0f, 10.0f }, glm::vec2{ 1.0f, 1.0f }, 0.0)
 				.AddComponent<RigidBodyComponent>(truck, glm::vec2{ 200.0f, 0.0f }, 1.0f)
-				.AddComponent<SpriteComponent>(truck, "truck-image", 32, 32, 1)
+				.AddComponent<SpriteComponent>(truck, truckImage, 32, 32, 1)
 				.AddComponent<BoxColliderComponent>(truck, 32, 32)
 				.AddComponent<ProjectileEmitterComponent>(truck, glm::vec2{ 0, 500.0f }, 3000, 10000, 0)
 				;
@@ -180,6 +190,12 @@ export namespace Engine
 						self.eventBus.EmitEvent<KeyPressedEvent>(sdlEvent.key);
 						break;
 					}
+					case SDL::SDL_EventType::SDL_EVENT_RENDER_TARGETS_RESET:
+					{
+						// What was drawn into the tile map's chunks is gone.
+						self.tileMap.Invalidate();
+						break;
+					}
 				}
 			}
 		}
@@ -194,25 +210,36 @@ export namespace Engine
 			auto deltaTime = double{ static_cast<double>(elapsedTicks) } / 1000.0;
 
 			self.millisecsPreviousFrame = SDL::SDL_GetTicks(); // ms since SDL was initialized
-			
-			// Reset all events for the current frame
-			self.eventBus.Reset();
-
-			// Perform the subscription of the events for all systems.
-			self.registry.GetSystem<DamageSystem>().SubscribeToEvents(self.eventBus);
-			self.registry.GetSystem<KeyboardControlSystem>().SubscribeToEvents(self.eventBus);
 
 			// Add or remove entities from systems after the update loop
 			self.registry.Update(); 
 
 			// Should this be done before Update()? Course doesn't do that.
-			self.registry.GetSystem<MovementSystem>().Update(deltaTime);
-			self.registry.GetSystem<AnimationSystem>().Update();
-			self.registry.GetSystem<CollisionSystem>().Update(self.eventBus);
-			self.registry.GetSystem<DamageSystem>().Update(self.eventBus);
-			self.registry.GetSystem<KeyboardControlSystem>().Update(deltaTime);
-			self.registry.GetSystem<ProjectileEmitSystem>().Update(deltaTime, self.registry);
-			self.registry.GetSystem<CameraMovementSystem>().Update(self.camera, WindowWidth, WindowHeight, MapWidth, MapHeight);
+			// Systems run in this order, except that ones that don't touch
+			// the same components run at the same time, e.g. movement and
+			// animation.
+			auto& movementSystem = self.registry.GetSystem<MovementSystem>();
+			auto& animationSystem = self.registry.GetSystem<AnimationSystem>();
+			auto& collisionSystem = self.registry.GetSystem<CollisionSystem>();
+			auto& damageSystem = self.registry.GetSystem<DamageSystem>();
+			auto& keyboardControlSystem = self.registry.GetSystem<KeyboardControlSystem>();
+			auto& projectileEmitSystem = self.registry.GetSystem<ProjectileEmitSystem>();
+			auto& cameraMovementSystem = self.registry.GetSystem<CameraMovementSystem>();
+			auto steps = std::array{
+				SystemScheduler::Step{ &movementSystem, [&] { movementSystem.Update(deltaTime, self.jobs); } },
+				SystemScheduler::Step{ &animationSystem, [&] { animationSystem.Update(self.jobs); } },
+				SystemScheduler::Step{ &collisionSystem, [&] { collisionSystem.Update(self.eventBus); } },
+				SystemScheduler::Step{ &damageSystem, [&] { damageSystem.Update(self.eventBus); } },
+				SystemScheduler::Step{ &keyboardControlSystem, [&] { keyboardControlSystem.Update(static_cast<float>(deltaTime)); } },
+				SystemScheduler::Step{ &projectileEmitSystem, [&] { projectileEmitSystem.Update(static_cast<float>(deltaTime), self.registry, self.commands); } },
+				SystemScheduler::Step{ &cameraMovementSystem, [&] { cameraMovementSystem.Update(self.camera, WindowWidth, WindowHeight, MapWidth, MapHeight); } }
+			};
+			self.scheduler.Run(steps);
+			// Events the systems queued, e.g. collisions, are handled on this
+			// thread once they've all finished.
+			self.eventBus.DispatchEvents();
+			// Projectiles emitted this frame join the systems in the next.
+			self.commands.Apply(self.registry);
 		}
 
 		void Render(this Game& self)
@@ -223,7 +250,9 @@ export namespace Engine
 
 			SDL::SDL_SetRenderDrawColor(self.renderer.get(), clearColor.r, clearColor.g, clearColor.b, clearColor.a);
 			SDL::SDL_RenderClear(self.renderer.get());
-			self.registry.GetSystem<RenderSystem>().Update(self.renderer.get(), self.assetStore, self.camera);
+			self.tileMap.Render(self.renderer.get(), self.assetStore, self.camera);
+			auto movedEntities = self.registry.GetSystem<MovementSystem>().GetMovedEntities();
+			self.registry.GetSystem<RenderSystem>().Update(self.renderer.get(), self.assetStore, self.camera, movedEntities);
 			self.registry.GetSystem<DebugRenderSystem>().Update(self.renderer.get(), self.camera);
 			SDL::SDL_RenderPresent(self.renderer.get());
 
@@ -256,8 +285,12 @@ export namespace Engine
 		SDL::WindowUniquePtr window = nullptr;
 		SDL::RendererUniquePtr renderer = nullptr;
 		// Course code allocates this on the heap, but there's no actual reason to do that.
-		Registry registry;
+		Registry registry{ StorageMode::Archetype };
+		JobPool jobs;
+		SystemScheduler scheduler{ jobs };
+		CommandBuffer commands;
 		AssetStore assetStore;
+		TileMap tileMap;
 		EventBus eventBus;
 		SDL::SDL_Rect camera{ .x = 0, .y = 0, .w = WindowWidth, .h = WindowHeight };
 	};
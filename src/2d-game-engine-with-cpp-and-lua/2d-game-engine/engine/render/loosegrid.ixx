@@ -0,0 +1,201 @@
+export module engine:render.loosegrid;
+import std;
+import :collision;
+
+export namespace Engine
+{
+	// Finds which boxes overlap an area, such as what the camera sees,
+	// without going through every box. Unlike SpatialHash, it's kept up to
+	// date a box at a time rather than rebuilt, so boxes that don't move
+	// cost nothing, and a box that does only moves between cells when its
+	// centre crosses into another.
+	//
+	// The grid is loose: each box is kept in the one cell its centre is in,
+	// and may hang over into the cells around it by up to half a cell, so
+	// queries look that much further. Boxes larger than a cell are kept
+	// apart, and checked by every query. Cells are hashed into a fixed
+	// number of buckets, so the grid covers an unbounded map.
+	class LooseGrid
+	{
+	public:
+		constexpr explicit LooseGrid(float cellSize = 256, std::size_t bucketCount = 1024)
+			: cellSize(cellSize),
+			  buckets(std::bit_ceil(std::max(bucketCount, std::size_t{ 1 })) + 1)
+		{ }
+
+		// Adds the box with the ID, or moves it if it's already there.
+		constexpr void Set(std::uint64_t id, const Bounds& bounds)
+		{
+			auto isLarge = bounds.right - bounds.left > cellSize or bounds.bottom - bounds.top > cellSize;
+			auto x = isLarge ? 0 : CellOf((bounds.left + bounds.right) / 2);
+			auto y = isLarge ? 0 : CellOf((bounds.top + bounds.bottom) / 2);
+			auto bucket = isLarge ? LargeBucket() : Hash(x, y);
+
+			if (Contains(id))
+			{
+				auto& location = locations[id];
+				auto& entry = buckets[location.bucket][location.index];
+				if (location.bucket == bucket and entry.x == x and entry.y == y)
+				{
+					entry.bounds = bounds;
+					return;
+				}
+				Remove(id);
+			}
+			if (id >= locations.size())
+				locations.resize(id + 1);
+			locations[id] = { static_cast<std::uint32_t>(bucket), static_cast<std::uint32_t>(buckets[bucket].size()) };
+			buckets[bucket].push_back({ id, bounds, x, y });
+			size++;
+		}
+
+		// Moves the last box in the ID's bucket into its place, so it's
+		// constant time.
+		constexpr void Remove(std::uint64_t id)
+		{
+			if (not Contains(id))
+				return;
+			auto [bucket, index] = locations[id];
+			auto& entries = buckets[bucket];
+			entries[index] = entries.back();
+			locations[entries[index].id].index = index;
+			entries.pop_back();
+			locations[id] = {};
+			size--;
+		}
+
+		constexpr auto Contains(std::uint64_t id) const noexcept -> bool
+		{
+			return id < locations.size() and locations[id].bucket != NotStored;
+		}
+
+		constexpr auto GetSize() const noexcept -> std::size_t
+		{
+			return size;
+		}
+
+		// Calls callback(id) once for each box that overlaps the area.
+		// The callback mustn't add, move or remove boxes.
+		template<typename TCallback>
+		constexpr void Query(const Bounds& area, TCallback&& callback) const
+		{
+			auto visit = [&](const Entry& entry)
+			{
+				if (entry.bounds.Overlaps(area))
+					callback(entry.id);
+			};
+			for (auto& entry : buckets[LargeBucket()])
+				visit(entry);
+
+			auto margin = cellSize / 2;
+			auto left = CellOf(area.left - margin);
+			auto top = CellOf(area.top - margin);
+			auto right = CellOf(area.right + margin);
+			auto bottom = CellOf(area.bottom + margin);
+			// An area with more cells than there are buckets is quicker to
+			// check by going through every bucket once.
+			auto cellCount = (static_cast<double>(right) - left + 1) * (static_cast<double>(bottom) - top + 1);
+			if (cellCount >= static_cast<double>(LargeBucket()))
+			{
+				for (auto bucket = std::size_t{ 0 }; bucket < LargeBucket(); bucket++)
+					for (auto& entry : buckets[bucket])
+						visit(entry);
+				return;
+			}
+			// Cells that hash to the same bucket share it, so each cell only
+			// takes its own boxes, and none is visited twice.
+			for (auto y = top; y <= bottom; y++)
+				for (auto x = left; x <= right; x++)
+					for (auto& entry : buckets[Hash(x, y)])
+						if (entry.x == x and entry.y == y)
+							visit(entry);
+		}
+
+	private:
+		static constexpr auto NotStored = std::numeric_limits<std::uint32_t>::max();
+
+		struct Entry
+		{
+			std::uint64_t id = 0;
+			Bounds bounds;
+			std::int32_t x = 0;
+			std::int32_t y = 0;
+		};
+
+		struct Location
+		{
+			std::uint32_t bucket = NotStored;
+			std::uint32_t index = 0;
+		};
+
+		constexpr auto CellOf(float coordinate) const noexcept -> std::int32_t
+		{
+			// Rounds down, including for negative coordinates.
+			auto scaled = coordinate / cellSize;
+			auto cell = static_cast<std::int32_t>(scaled);
+			return static_cast<float>(cell) > scaled ? cell - 1 : cell;
+		}
+
+		constexpr auto Hash(std::int32_t x, std::int32_t y) const noexcept -> std::size_t
+		{
+			auto hash = static_cast<std::uint32_t>(x) * 73856093u ^ static_cast<std::uint32_t>(y) * 19349663u;
+			return hash & (LargeBucket() - 1);
+		}
+
+		// The last bucket, after the power of two hashed ones.
+		constexpr auto LargeBucket() const noexcept -> std::size_t
+		{
+			return buckets.size() - 1;
+		}
+
+		float cellSize;
+		std::vector<std::vector<Entry>> buckets;
+		// Where each box is, by ID.
+		std::vector<Location> locations;
+		std::size_t size = 0;
+	};
+}
+
+namespace
+{
+	using namespace Engine;
+
+	// Test that a query finds the boxes that overlap it, including ones
+	// over a cell's edge and ones larger than a cell, and follows boxes as
+	// they move and go.
+	static_assert(
+		[] -> bool
+		{
+			auto grid = LooseGrid{ 100, 4 };
+			grid.Set(1, { 10, 10, 20, 20 });
+			grid.Set(2, { 95, 95, 140, 140 });
+			grid.Set(3, { -500, -500, 500, 500 });
+			grid.Set(4, { 1000, 1000, 1010, 1010 });
+			grid.Set(5, { -210, 10, -190, 20 });
+
+			auto found = [&](Bounds area) -> std::uint64_t
+			{
+				auto ids = std::uint64_t{ 0 };
+				auto count = 0;
+				grid.Query(area, [&](std::uint64_t id) { ids |= std::uint64_t{ 1 } << id; count++; });
+				if (count != std::popcount(ids))
+					throw "Expected each box to be found once";
+				return ids;
+			};
+			if (found({ 0, 0, 99, 99 }) != (1 << 1 | 1 << 2 | 1 << 3))
+				throw "Expected the boxes in the area, and those hanging into it";
+			if (found({ -250, 0, -150, 50 }) != (1 << 3 | 1 << 5))
+				throw "Expected boxes in negative cells to be found";
+			if (found({ -10000, -10000, 10000, 10000 }) != 0b111110)
+				throw "Expected every box in an area larger than the grid";
+
+			grid.Set(1, { 1000, 1005, 1010, 1015 });
+			grid.Remove(4);
+			if (found({ 0, 0, 50, 50 }) != (1 << 3) or found({ 990, 990, 1020, 1020 }) != (1 << 1))
+				throw "Expected a moved box to be found where it is now, and a removed one not at all";
+			if (grid.GetSize() != 4 or grid.Contains(4))
+				throw "Expected the removed box to be gone";
+			return true;
+		}()
+	);
+}
@@ -0,0 +1,4 @@
+export module engine:render;
+export import :render.loosegrid;
+export import :render.renderqueue;
+export import :render.tilemap;
@@ -0,0 +1,167 @@
+export module engine:render.renderqueue;
+import std;
+
+export namespace Engine
+{
+	// Orders what's drawn: by layer, then by texture, so that sprites on a
+	// layer that share a texture are drawn together, then by depth, which
+	// keeps the order of the rest stable. Packed into one integer, so that
+	// comparing two is one compare.
+	using RenderSortKey = std::uint64_t;
+
+	constexpr auto MakeRenderSortKey(std::int32_t layer, std::uint32_t texture, std::uint32_t depth) noexcept -> RenderSortKey
+	{
+		// The layer is offset so negative layers sort before positive ones,
+		// and clamped to 16 bits, as is the texture.
+		auto biasedLayer = static_cast<std::uint64_t>(std::clamp(layer, -32768, 32767) + 32768);
+		return biasedLayer << 48 | std::uint64_t{ std::min(texture, 0xffffu) } << 32 | depth;
+	}
+
+	// Keeps what's drawn sorted from one frame to the next. Each frame,
+	// everything to draw is submitted with its sort key; items whose key is
+	// the same as last frame keep their place, and only new items and those
+	// whose key changed are sorted, then merged into the rest. Items not
+	// submitted are dropped. A frame where nothing is added, removed or
+	// changes key costs no sorting at all.
+	//
+	// Items are identified by an integer ID, e.g. an entity's, and carry a
+	// payload, such as pointers to what to draw them with, that's replaced
+	// every frame.
+	template<typename TPayload>
+	class RenderQueue
+	{
+	public:
+		struct Item
+		{
+			RenderSortKey key = 0;
+			std::uint64_t id = 0;
+			TPayload payload{};
+			std::uint32_t lastSubmitted = 0;
+		};
+
+		constexpr void BeginFrame()
+		{
+			frame++;
+		}
+
+		constexpr void Submit(std::uint64_t id, RenderSortKey key, const TPayload& payload)
+		{
+			if (id < positions.size() and positions[id] < items.size() and items[positions[id]].id == id)
+			{
+				auto& item = items[positions[id]];
+				if (item.key == key)
+				{
+					item.payload = payload;
+					item.lastSubmitted = frame;
+					return;
+				}
+				// Left for EndFrame() to drop, as it isn't submitted for
+				// this frame under its old key.
+				positions[id] = NotQueued;
+			}
+			added.push_back({ key, id, payload, frame });
+		}
+
+		// Returns everything submitted this frame, in order.
+		constexpr auto EndFrame() -> std::span<const Item>
+		{
+			// Dropped items are forgotten along with their positions, so that
+			// submitting their IDs again adds them anew.
+			auto removed = std::erase_if(items, [this](const Item& item)
+			{
+				if (item.lastSubmitted == frame)
+					return false;
+				positions[item.id] = NotQueued;
+				return true;
+			});
+			if (removed == 0 and added.empty())
+				return items;
+
+			std::ranges::sort(added, std::less{}, &Item::key);
+			merged.clear();
+			std::ranges::merge(items, added, std::back_inserter(merged), std::less{}, &Item::key, &Item::key);
+			std::swap(items, merged);
+			added.clear();
+
+			for (auto position = std::size_t{ 0 }; position < items.size(); position++)
+			{
+				auto id = items[position].id;
+				if (id >= positions.size())
+					positions.resize(id + 1, NotQueued);
+				positions[id] = static_cast<std::uint32_t>(position);
+			}
+			return items;
+		}
+
+		// How many items were drawn last frame.
+		constexpr auto GetSize() const noexcept -> std::size_t
+		{
+			return items.size();
+		}
+
+	private:
+		static constexpr auto NotQueued = std::numeric_limits<std::uint32_t>::max();
+
+		std::vector<Item> items;
+		std::vector<Item> added;
+		// The previous frame's items once merged, kept for their capacity.
+		std::vector<Item> merged;
+		// Each ID's position in items, or NotQueued.
+		std::vector<std::uint32_t> positions;
+		std::uint32_t frame = 0;
+	};
+}
+
+namespace
+{
+	using namespace Engine;
+
+	// Test that items come out by layer, then texture, then depth, that
+	// changing an item's key moves it, and that items not submitted go.
+	static_assert(
+		[] -> bool
+		{
+			auto queue = RenderQueue<int>{};
+			queue.BeginFrame();
+			queue.Submit(1, MakeRenderSortKey(1, 0, 1), 10);
+			queue.Submit(2, MakeRenderSortKey(0, 5, 2), 20);
+			queue.Submit(3, MakeRenderSortKey(0, 2, 3), 30);
+			queue.Submit(4, MakeRenderSortKey(-1, 9, 4), 40);
+			auto items = queue.EndFrame();
+			if (items.size() != 4 or items[0].id != 4 or items[1].id != 3 or items[2].id != 2 or items[3].id != 1)
+				throw "Expected items sorted by layer, then texture";
+
+			queue.BeginFrame();
+			queue.Submit(1, MakeRenderSortKey(1, 0, 1), 11);
+			queue.Submit(2, MakeRenderSortKey(-2, 5, 2), 21);
+			queue.Submit(4, MakeRenderSortKey(-1, 9, 4), 41);
+			items = queue.EndFrame();
+			if (items.size() != 3 or items[0].id != 2 or items[1].id != 4 or items[2].id != 1)
+				throw "Expected the changed item to move and the missing one to go";
+			if (items[0].payload != 21 or items[2].payload != 11)
+				throw "Expected the payloads submitted this frame";
+
+			queue.BeginFrame();
+			queue.Submit(1, MakeRenderSortKey(1, 0, 1), 12);
+			queue.Submit(2, MakeRenderSortKey(-2, 5, 2), 22);
+			queue.Submit(4, MakeRenderSortKey(-1, 9, 4), 42);
+			items = queue.EndFrame();
+			if (items.size() != 3 or items[1].payload != 42)
+				throw "Expected an unchanged frame to keep every item";
+
+			// A dropped item, and one whose key changed, are queued again
+			// when submitted again, rather than found where they were.
+			queue.BeginFrame();
+			queue.Submit(1, MakeRenderSortKey(1, 0, 1), 13);
+			queue.EndFrame();
+			queue.BeginFrame();
+			queue.Submit(1, MakeRenderSortKey(1, 0, 1), 14);
+			queue.Submit(4, MakeRenderSortKey(-1, 9, 4), 44);
+			queue.Submit(2, MakeRenderSortKey(3, 5, 2), 24);
+			items = queue.EndFrame();
+			if (items.size() != 3 or items[0].id != 4 or items[1].id != 1 or items[2].id != 2 or items[2].payload != 24)
+				throw "Expected dropped items to come back where they sort";
+			return true;
+		}()
+	);
+}
@@ -0,0 +1,276 @@
+export module engine:render.tilemap;
+import std;
+import :sdl3;
+import :assetstore;
+
+export namespace Engine
+{
+	// A block of chunks, as half-open ranges of chunk columns and rows.
+	struct ChunkRange
+	{
+		int firstColumn = 0;
+		int firstRow = 0;
+		int endColumn = 0;
+		int endRow = 0;
+	};
+
+	// The chunks of a map of columns by rows chunks, each chunkSize across,
+	// that the view overlaps. Parts of the view off the map are ignored.
+	constexpr auto ChunksOverlapping(const SDL::SDL_FRect& view, float chunkSize, int columns, int rows) noexcept -> ChunkRange
+	{
+		if (chunkSize <= 0 or view.w <= 0 or view.h <= 0)
+			return {};
+		// Chunk coordinates are clamped to the map before they're truncated,
+		// so truncating rounds down, and rounding up only has to check for a
+		// remainder.
+		auto first = [=](float position, int count) -> int
+		{
+			return static_cast<int>(std::clamp(position / chunkSize, 0.f, static_cast<float>(count)));
+		};
+		auto end = [=](float position, int count) -> int
+		{
+			auto chunks = std::clamp(position / chunkSize, 0.f, static_cast<float>(count));
+			auto whole = static_cast<int>(chunks);
+			return static_cast<float>(whole) < chunks ? whole + 1 : whole;
+		};
+		return {
+			first(view.x, columns),
+			first(view.y, rows),
+			end(view.x + view.w, columns),
+			end(view.y + view.h, rows)
+		};
+	}
+
+	// A grid of tiles from a tileset, drawn as the background of a level.
+	// Tiles aren't entities: the map only keeps each tile's index in the
+	// tileset, and draws them in square chunks of ChunkTiles tiles a side.
+	// A chunk is drawn once into a texture of its own the first time it's
+	// seen, then drawn from that texture, so a frame costs one draw call for
+	// each chunk the camera overlaps, whatever the size of the map. Setting
+	// a tile redraws its chunk the next time it's seen.
+	//
+	// Only chunks seen recently keep their textures; once more than
+	// MaxCachedChunks have one, those seen longest ago give theirs up.
+	class TileMap
+	{
+	public:
+		using Tile = std::uint16_t;
+
+		static constexpr auto EmptyTile = std::numeric_limits<Tile>::max();
+		static constexpr auto ChunkTiles = 16;
+		static constexpr auto MaxCachedChunks = std::size_t{ 64 };
+
+		TileMap() = default;
+
+		// Tiles are indices into the tileset, row by row, with tilesetColumns
+		// tiles in each of its rows. tileSize is in the tileset's pixels, and
+		// scale is how many world units each of those covers.
+		TileMap(TextureHandle tileset, int tilesetColumns, int tileSize, float scale, int columns, int rows, std::vector<Tile> tiles)
+			: tileset(tileset),
+			  tilesetColumns(tilesetColumns),
+			  tileSize(tileSize),
+			  scale(scale),
+			  columns(columns),
+			  rows(rows),
+			  chunkColumns((columns + ChunkTiles - 1) / ChunkTiles),
+			  chunkRows((rows + ChunkTiles - 1) / ChunkTiles),
+			  tiles(std::move(tiles))
+		{
+			if (this->tiles.size() != static_cast<std::size_t>(columns) * rows)
+				throw std::invalid_argument{ std::format("Expected {} tiles for a {}x{} map, got {}", columns * rows, columns, rows, this->tiles.size()) };
+			chunks.resize(static_cast<std::size_t>(chunkColumns) * chunkRows);
+		}
+
+		auto GetColumns() const noexcept -> int { return columns; }
+		auto GetRows() const noexcept -> int { return rows; }
+
+		// In world units.
+		auto GetWidth() const noexcept -> float { return columns * tileSize * scale; }
+		auto GetHeight() const noexcept -> float { return rows * tileSize * scale; }
+
+		auto GetTile(int column, int row) const -> Tile
+		{
+			return tiles.at(IndexOf(column, row));
+		}
+
+		void SetTile(int column, int row, Tile tile)
+		{
+			auto& current = tiles.at(IndexOf(column, row));
+			if (current == tile)
+				return;
+			current = tile;
+			chunks[static_cast<std::size_t>(row / ChunkTiles) * chunkColumns + column / ChunkTiles].isStale = true;
+		}
+
+		// Redraws every chunk the next time it's seen, e.g. after the
+		// renderer lost what was drawn into its textures.
+		void Invalidate() noexcept
+		{
+			for (auto& chunk : chunks)
+				chunk.isStale = true;
+		}
+
+		void Render(SDL::SDL_Renderer* renderer, const AssetStore& assetStore, const SDL::SDL_Rect& camera)
+		{
+			frame++;
+			auto chunkSize = ChunkTiles * tileSize * scale;
+			auto view = SDL::SDL_FRect{
+				static_cast<float>(camera.x),
+				static_cast<float>(camera.y),
+				static_cast<float>(camera.w),
+				static_cast<float>(camera.h)
+			};
+			auto visible = ChunksOverlapping(view, chunkSize, chunkColumns, chunkRows);
+			for (auto chunkRow = visible.firstRow; chunkRow < visible.endRow; chunkRow++)
+			{
+				for (auto chunkColumn = visible.firstColumn; chunkColumn < visible.endColumn; chunkColumn++)
+				{
+					auto& chunk = chunks[static_cast<std::size_t>(chunkRow) * chunkColumns + chunkColumn];
+					if (not chunk.texture or chunk.isStale)
+						Bake(renderer, assetStore, chunkColumn, chunkRow);
+					chunk.lastSeen = frame;
+
+					auto size = ChunkSizeInTiles(chunkColumn, chunkRow);
+					auto destination = SDL::SDL_FRect{
+						chunkColumn * chunkSize - view.x,
+						chunkRow * chunkSize - view.y,
+						size.x * tileSize * scale,
+						size.y * tileSize * scale
+					};
+					SDL::SDL_RenderTexture(renderer, chunk.texture.get(), nullptr, &destination);
+				}
+			}
+			EvictChunks();
+		}
+
+	private:
+		struct Chunk
+		{
+			SDL::TextureUniquePtr texture;
+			bool isStale = true;
+			std::uint32_t lastSeen = 0;
+		};
+
+		auto IndexOf(int column, int row) const -> std::size_t
+		{
+			if (column < 0 or column >= columns or row < 0 or row >= rows)
+				throw std::out_of_range{ std::format("Tile ({}, {}) is outside the {}x{} map", column, row, columns, rows) };
+			return static_cast<std::size_t>(row) * columns + column;
+		}
+
+		// Chunks on the right and bottom edges of the map may be smaller.
+		auto ChunkSizeInTiles(int chunkColumn, int chunkRow) const noexcept -> SDL::SDL_Point
+		{
+			return {
+				std::min(ChunkTiles, columns - chunkColumn * ChunkTiles),
+				std::min(ChunkTiles, rows - chunkRow * ChunkTiles)
+			};
+		}
+
+		void Bake(SDL::SDL_Renderer* renderer, const AssetStore& assetStore, int chunkColumn, int chunkRow)
+		{
+			auto& chunk = chunks[static_cast<std::size_t>(chunkRow) * chunkColumns + chunkColumn];
+			auto size = ChunkSizeInTiles(chunkColumn, chunkRow);
+			if (not chunk.texture)
+			{
+				chunk.texture = SDL::TextureUniquePtr{ SDL::SDL_CreateTexture(
+					renderer,
+					SDL::SDL_PixelFormat::SDL_PIXELFORMAT_RGBA8888,
+					SDL::SDL_TextureAccess::SDL_TEXTUREACCESS_TARGET,
+					size.x * tileSize,
+					size.y * tileSize
+				) };
+				if (not chunk.texture)
+					throw SDL::SdlError{ "Failed to create a texture for a tile map chunk" };
+				// Tiles are scaled up when drawn, and should stay sharp.
+				SDL::SDL_SetTextureScaleMode(chunk.texture.get(), SDL::SDL_ScaleMode::SDL_SCALEMODE_NEAREST);
+				cachedChunks.push_back(&chunk);
+			}
+
+			// Whatever was being drawn into, and with, is put back after.
+			auto previousTarget = SDL::SDL_GetRenderTarget(renderer);
+			auto previousColor = SDL::SDL_Color{};
+			SDL::SDL_GetRenderDrawColor(renderer, &previousColor.r, &previousColor.g, &previousColor.b, &previousColor.a);
+			SDL::SDL_SetRenderTarget(renderer, chunk.texture.get());
+			SDL::SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+			SDL::SDL_RenderClear(renderer);
+
+			auto texture = assetStore.GetTexture(tileset);
+			auto tileExtent = static_cast<float>(tileSize);
+			for (auto y = 0; y < size.y; y++)
+			{
+				for (auto x = 0; x < size.x; x++)
+				{
+					auto tile = tiles[IndexOf(chunkColumn * ChunkTiles + x, chunkRow * ChunkTiles + y)];
+					if (tile == EmptyTile)
+						continue;
+					auto source = SDL::SDL_FRect{
+						static_cast<float>(tile % tilesetColumns) * tileExtent,
+						static_cast<float>(tile / tilesetColumns) * tileExtent,
+						tileExtent,
+						tileExtent
+					};
+					auto destination = SDL::SDL_FRect{ x * tileExtent, y * tileExtent, tileExtent, tileExtent };
+					SDL::SDL_RenderTexture(renderer, texture, &source, &destination);
+				}
+			}
+
+			SDL::SDL_SetRenderTarget(renderer, previousTarget);
+			SDL::SDL_SetRenderDrawColor(renderer, previousColor.r, previousColor.g, previousColor.b, previousColor.a);
+			chunk.isStale = false;
+		}
+
+		// Chunks seen this frame always keep their textures, so a view that
+		// overlaps more than MaxCachedChunks can still be drawn.
+		void EvictChunks()
+		{
+			if (cachedChunks.size() <= MaxCachedChunks)
+				return;
+			std::ranges::sort(cachedChunks, std::less{}, &Chunk::lastSeen);
+			auto evicted = std::size_t{ 0 };
+			while (cachedChunks.size() - evicted > MaxCachedChunks and cachedChunks[evicted]->lastSeen != frame)
+				cachedChunks[evicted++]->texture.reset();
+			cachedChunks.erase(cachedChunks.begin(), cachedChunks.begin() + evicted);
+		}
+
+		TextureHandle tileset = TextureHandle::Invalid;
+		int tilesetColumns = 1;
+		int tileSize = 0;
+		float scale = 1;
+		int columns = 0;
+		int rows = 0;
+		int chunkColumns = 0;
+		int chunkRows = 0;
+		std::vector<Tile> tiles;
+		std::vector<Chunk> chunks;
+		// The chunks that have a texture.
+		std::vector<Chunk*> cachedChunks;
+		std::uint32_t frame = 0;
+	};
+}
+
+namespace
+{
+	using namespace Engine;
+
+	// Test that the chunks overlapped include those the view only partly
+	// covers, and stop at the edges of the map.
+	static_assert(
+		[] -> bool
+		{
+			auto inside = ChunksOverlapping({ 100, 100, 800, 600 }, 512, 10, 10);
+			if (inside.firstColumn != 0 or inside.firstRow != 0 or inside.endColumn != 2 or inside.endRow != 2)
+				throw "Expected the chunks partly covered to be included";
+			auto aligned = ChunksOverlapping({ 512, 1024, 512, 512 }, 512, 10, 10);
+			if (aligned.firstColumn != 1 or aligned.firstRow != 2 or aligned.endColumn != 2 or aligned.endRow != 3)
+				throw "Expected a view on chunk edges to overlap one chunk";
+			auto edge = ChunksOverlapping({ -300, 4800, 800, 600 }, 512, 10, 10);
+			if (edge.firstColumn != 0 or edge.firstRow != 9 or edge.endColumn != 1 or edge.endRow != 10)
+				throw "Expected the view to be clamped to the map";
+			auto outside = ChunksOverlapping({ 6000, 0, 800, 600 }, 512, 10, 10);
+			if (outside.firstColumn != outside.endColumn)
+				throw "Expected no chunks for a view off the map";
+			return true;
+		}()
+	);
+}
@@ -0,0 +1,240 @@
+export module engine:scheduler.jobpool;
+import std;
+
+export namespace Engine
+{
+	// Counts the jobs submitted to it that haven't finished, so that they
+	// can be waited for together, and keeps the first exception any threw.
+	class JobGroup
+	{
+	public:
+		JobGroup() = default;
+		JobGroup(const JobGroup&) = delete;
+		auto operator=(const JobGroup&) -> JobGroup& = delete;
+
+	private:
+		friend class JobPool;
+		std::atomic<std::size_t> pending = 0;
+		std::mutex failureMutex;
+		std::exception_ptr failure;
+	};
+
+	// A set of worker threads that run jobs from queues of their own. A
+	// thread takes the jobs it submitted itself last in, first out, which
+	// keeps the data they use in its cache, and when it has none left it
+	// steals the oldest job of another thread, which tends to be the
+	// largest piece of work left.
+	//
+	// Waiting for a group runs other jobs meanwhile, so jobs can submit and
+	// wait for jobs of their own without tying up a thread.
+	class JobPool
+	{
+	public:
+		// Threads other than the workers, such as the main thread, share
+		// one more queue.
+		explicit JobPool(unsigned workers = std::max(std::thread::hardware_concurrency(), 1u) - 1)
+			: queues(workers + 1)
+		{
+			threads.reserve(workers);
+			for (auto i = 0u; i < workers; i++)
+				threads.emplace_back([this, i](std::stop_token stop) { WorkLoop(stop, i + 1); });
+		}
+
+		JobPool(const JobPool&) = delete;
+		auto operator=(const JobPool&) -> JobPool& = delete;
+
+		~JobPool()
+		{
+			for (auto& thread : threads)
+				thread.request_stop();
+			wake.notify_all();
+		}
+
+		auto GetWorkerCount() const noexcept -> std::size_t
+		{
+			return threads.size();
+		}
+
+		// Most of the largest number of jobs a ForEach() submits.
+		auto GetMaxBatches() const noexcept -> std::size_t
+		{
+			return (threads.size() + 1) * 4;
+		}
+
+		// Makes room in every queue for count more jobs than it holds, so
+		// that submitting up to that many allocates nothing and can't throw,
+		// as long as the job's function is small enough to be stored in the
+		// move_only_function itself. Queues don't shrink.
+		void Reserve(std::size_t count)
+		{
+			for (auto& queue : queues)
+			{
+				auto lock = std::scoped_lock{ queue.mutex };
+				queue.Reserve(queue.size + count);
+			}
+		}
+
+		void Submit(JobGroup& group, std::move_only_function<void()> job)
+		{
+			group.pending++;
+			auto& queue = queues[QueueIndex()];
+			{
+				auto lock = std::scoped_lock{ queue.mutex };
+				queue.PushBack({ std::move(job), &group });
+			}
+			{
+				// Under the mutex the workers sleep on, so none can miss it
+				// between checking for jobs and going to sleep.
+				auto lock = std::scoped_lock{ sleepMutex };
+				queued++;
+			}
+			wake.notify_one();
+		}
+
+		// Returns once every job in the group has finished, running jobs in
+		// the meantime. Rethrows the first exception a job of the group threw.
+		void Wait(JobGroup& group)
+		{
+			while (group.pending > 0)
+				if (not TryRunOne(QueueIndex()))
+					std::this_thread::yield();
+			if (group.failure)
+				std::rethrow_exception(std::exchange(group.failure, nullptr));
+		}
+
+		// Calls function(begin, end) over ranges that together cover
+		// [0, count), spread over the workers and the calling thread. The
+		// ranges are a few per thread, so that threads that finish early
+		// can steal from the rest.
+		template<typename TFunction>
+		void ForEach(std::size_t count, TFunction&& function)
+		{
+			if (count == 0)
+				return;
+			auto batches = std::min(count, GetMaxBatches());
+			auto group = JobGroup{};
+			for (auto batch = std::size_t{ 0 }; batch < batches; batch++)
+				Submit(group, [&function, begin = count * batch / batches, end = count * (batch + 1) / batches] { function(begin, end); });
+			Wait(group);
+		}
+
+	private:
+		struct Job
+		{
+			std::move_only_function<void()> function;
+			JobGroup* group = nullptr;
+		};
+
+		// A ring buffer rather than a deque, so that once it's grown to fit
+		// the jobs queued at a time, queueing one allocates nothing.
+		struct Queue
+		{
+			std::mutex mutex;
+			std::vector<Job> jobs;
+			std::size_t first = 0;
+			std::size_t size = 0;
+
+			void Reserve(std::size_t capacity)
+			{
+				if (capacity <= jobs.size())
+					return;
+				auto grown = std::vector<Job>(capacity);
+				for (auto i = std::size_t{ 0 }; i < size; i++)
+					grown[i] = std::move(jobs[(first + i) % jobs.size()]);
+				jobs = std::move(grown);
+				first = 0;
+			}
+
+			void PushBack(Job job)
+			{
+				if (size == jobs.size())
+					Reserve(std::max(jobs.size() * 2, std::size_t{ 16 }));
+				jobs[(first + size) % jobs.size()] = std::move(job);
+				size++;
+			}
+
+			auto PopBack() -> Job
+			{
+				size--;
+				return std::exchange(jobs[(first + size) % jobs.size()], Job{});
+			}
+
+			auto PopFront() -> Job
+			{
+				auto job = std::exchange(jobs[first], Job{});
+				first = (first + 1) % jobs.size();
+				size--;
+				return job;
+			}
+		};
+
+		// Which queue the calling thread's jobs go in: a worker's own, or
+		// the shared one for everything else.
+		static inline thread_local const JobPool* currentPool = nullptr;
+		static inline thread_local std::size_t currentQueue = 0;
+
+		auto QueueIndex() const noexcept -> std::size_t
+		{
+			return currentPool == this ? currentQueue : 0;
+		}
+
+		void WorkLoop(std::stop_token stop, std::size_t queue)
+		{
+			currentPool = this;
+			currentQueue = queue;
+			while (not stop.stop_requested())
+			{
+				if (TryRunOne(queue))
+					continue;
+				auto lock = std::unique_lock{ sleepMutex };
+				wake.wait(lock, stop, [this] { return queued > 0; });
+			}
+		}
+
+		auto TryRunOne(std::size_t own) -> bool
+		{
+			auto job = TryTake(own);
+			if (not job)
+				return false;
+			try
+			{
+				job->function();
+			}
+			catch (...)
+			{
+				auto lock = std::scoped_lock{ job->group->failureMutex };
+				if (not job->group->failure)
+					job->group->failure = std::current_exception();
+			}
+			job->group->pending--;
+			return true;
+		}
+
+		auto TryTake(std::size_t own) -> std::optional<Job>
+		{
+			if (queued == 0)
+				return std::nullopt;
+			for (auto offset = std::size_t{ 0 }; offset < queues.size(); offset++)
+			{
+				auto& queue = queues[(own + offset) % queues.size()];
+				auto lock = std::scoped_lock{ queue.mutex };
+				if (queue.size == 0)
+					continue;
+				auto job = std::optional<Job>{ offset == 0 ? queue.PopBack() : queue.PopFront() };
+				queued--;
+				return job;
+			}
+			return std::nullopt;
+		}
+
+		std::vector<Queue> queues;
+		// Jobs in any queue, which the workers sleep until there are.
+		std::atomic<std::size_t> queued = 0;
+		std::mutex sleepMutex;
+		std::condition_variable_any wake;
+
+		// Last, so they're stopped and joined before anything they use is
+		// destroyed.
+		std::vector<std::jthread> threads;
+	};
+}
@@ -0,0 +1,3 @@
+export module engine:scheduler;
+export import :scheduler.jobpool;
+export import :scheduler.systemscheduler;
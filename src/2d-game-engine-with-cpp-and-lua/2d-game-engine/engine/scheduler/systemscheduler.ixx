@@ -0,0 +1,183 @@
+export module engine:scheduler.systemscheduler;
+import std;
+import :ecs;
+import :scheduler.jobpool;
+
+export namespace Engine
+{
+	// Whether two systems with the given accesses can't run at the same
+	// time: one writes a component that the other reads or writes.
+	constexpr auto AccessesConflict(
+		const Signature& readsA, const Signature& writesA,
+		const Signature& readsB, const Signature& writesB
+	) noexcept -> bool
+	{
+		return (writesA & (readsB | writesB)).any() or (writesB & readsA).any();
+	}
+
+	// Runs a frame's systems on a job pool, as many at a time as their
+	// declared reads and writes allow. A system waits for every system
+	// before it in the frame that it conflicts with, so the result is the
+	// same as running them one after another in that order.
+	//
+	// Systems must only read and write the components they declare, and
+	// leave creating and killing entities and adding and removing
+	// components to a CommandBuffer.
+	class SystemScheduler
+	{
+	public:
+		struct Step
+		{
+			const System* system = nullptr;
+			std::move_only_function<void()> update;
+		};
+
+		explicit SystemScheduler(JobPool& jobs)
+			: jobs{ jobs }
+		{}
+
+		// Returns once every step has run or been skipped. Steps that wait
+		// for one that throws are skipped, and so are the steps waiting for
+		// them, as they'd see what it left half done. The first exception a
+		// step threw is rethrown once the rest have finished.
+		void Run(std::span<Step> steps)
+		{
+			// The graph is rebuilt every frame, as it's a handful of systems
+			// and which ones run can change from frame to frame.
+			if (steps.size() > capacity)
+			{
+				capacity = steps.size();
+				waitingFor = std::make_unique<std::atomic<std::size_t>[]>(capacity);
+				skipped = std::make_unique<std::atomic<bool>[]>(capacity);
+			}
+			dependents.resize(steps.size());
+			for (auto step = std::size_t{ 0 }; step < steps.size(); step++)
+			{
+				dependents[step].clear();
+				// Run() holds one of each step's counts, so that a step that
+				// earlier ones release while it's still submitting them
+				// isn't submitted twice.
+				waitingFor[step] = 1;
+				skipped[step] = false;
+			}
+			for (auto later = std::size_t{ 0 }; later < steps.size(); later++)
+			{
+				for (auto earlier = std::size_t{ 0 }; earlier < later; earlier++)
+				{
+					auto& a = *steps[earlier].system;
+					auto& b = *steps[later].system;
+					if (AccessesConflict(a.GetReads(), a.GetWrites(), b.GetReads(), b.GetWrites()))
+					{
+						dependents[earlier].push_back(later);
+						waitingFor[later]++;
+					}
+				}
+			}
+
+			// Releasing a step's dependents submits them from inside a job,
+			// where there's no one to throw to, so the queues are made big
+			// enough up front: a job for each step, and the batches of a
+			// ForEach() in each step that could be running at the same time.
+			jobs.Reserve(steps.size() * (1 + jobs.GetMaxBatches()));
+
+			auto group = JobGroup{};
+			running = { &group, steps };
+			for (auto step = std::size_t{ 0 }; step < steps.size(); step++)
+				if (--waitingFor[step] == 0)
+					Submit(step);
+			jobs.Wait(group);
+			running = {};
+			if (failure)
+				std::rethrow_exception(std::exchange(failure, nullptr));
+		}
+
+	private:
+		// Only captures what fits in the move_only_function itself, so that
+		// submitting allocates nothing once the queues have room.
+		void Submit(std::size_t step) noexcept
+		{
+			jobs.Submit(*running.group,
+				[this, step]
+				{
+					auto failed = skipped[step].load();
+					if (not failed)
+					{
+						try
+						{
+							running.steps[step].update();
+						}
+						catch (...)
+						{
+							auto lock = std::scoped_lock{ failureMutex };
+							if (not failure)
+								failure = std::current_exception();
+							failed = true;
+						}
+					}
+					Release(step, failed);
+				});
+		}
+
+		// Submits the dependents of a step that has finished, or been
+		// skipped, once they wait for nothing else. The steps waiting for a
+		// failed one are marked to be skipped first, which the decrement
+		// then publishes to whichever thread submits them.
+		void Release(std::size_t step, bool failed) noexcept
+		{
+			for (auto dependent : dependents[step])
+			{
+				if (failed)
+					skipped[dependent] = true;
+				if (--waitingFor[dependent] == 0)
+					Submit(dependent);
+			}
+		}
+
+		struct Running
+		{
+			JobGroup* group = nullptr;
+			std::span<Step> steps;
+		};
+
+		JobPool& jobs;
+		// The group and steps of the Run() in progress.
+		Running running;
+		// For each step, the later steps that wait for it, how many earlier
+		// steps it's still waiting for, and whether one of those failed.
+		std::vector<std::vector<std::size_t>> dependents;
+		std::unique_ptr<std::atomic<std::size_t>[]> waitingFor;
+		std::unique_ptr<std::atomic<bool>[]> skipped;
+		std::size_t capacity = 0;
+		// The first exception a step threw in the Run() in progress.
+		std::mutex failureMutex;
+		std::exception_ptr failure;
+	};
+}
+
+namespace
+{
+	using namespace Engine;
+
+	// Test that systems touching different components, or only reading the
+	// same ones, don't conflict, and that a write conflicts with any access.
+	static_assert(
+		[] -> bool
+		{
+			auto transform = Signature{}.set(0);
+			auto rigidBody = Signature{}.set(1);
+			auto sprite = Signature{}.set(2);
+			auto animation = Signature{}.set(3);
+			// Movement reads rigid bodies and writes transforms; animation
+			// writes sprites and animations; collision reads transforms.
+			if (AccessesConflict(rigidBody, transform, sprite | animation, sprite | animation))
+				throw "Expected movement and animation not to conflict";
+			if (not AccessesConflict(rigidBody, transform, transform, {}))
+				throw "Expected movement and collision to conflict";
+			if (not AccessesConflict(transform, {}, {}, transform))
+				throw "Expected a write after a read to conflict";
+			if (AccessesConflict(transform, {}, transform, {}))
+				throw "Expected reads of the same component not to conflict";
+			return true;
+		}()
+	);
+}
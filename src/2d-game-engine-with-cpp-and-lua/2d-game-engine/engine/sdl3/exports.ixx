@@ -17,9 +17,15 @@ export namespace SDL
 		::SDL_Color,
 		::SDL_PixelFormat,
 		::SDL_Rect,
+		::SDL_Point,
 		::SDL_FRect,
+		::SDL_FPoint,
+		::SDL_FColor,
+		::SDL_Vertex,
 		::SDL_Surface,
 		::SDL_Texture,
+		::SDL_TextureAccess,
+		::SDL_ScaleMode,
 		::SDL_InitFlags,
 		::SDL_FlipMode,
 		::SDL_WindowFlags,
@@ -32,8 +38,15 @@ export namespace SDL
 		::SDL_DestroyTexture,
 		::SDL_RenderTexture, // replacement for SDL_RenderCopy, which was removed in SDL3
 		::SDL_RenderTextureRotated, // replacement for SDL_RenderCopyEx, which was removed in SDL3
+		::SDL_RenderGeometry,
+		::SDL_GetTextureSize,
 		::SDL_DestroySurface,
 		::SDL_CreateTextureFromSurface,
+		::SDL_CreateTexture,
+		::SDL_SetTextureScaleMode,
+		::SDL_GetRenderTarget,
+		::SDL_SetRenderTarget,
+		::SDL_GetRenderDrawColor,
 		::SDL_RenderFillRect,
 		::SDL_CreateWindowAndRenderer,
 		::SDL_SetWindowPosition,
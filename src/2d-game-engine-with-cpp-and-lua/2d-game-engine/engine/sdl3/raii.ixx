@@ -27,4 +27,5 @@ namespace SDL
 
 	using RendererUniquePtr = Engine::UniquePtr<SDL::SDL_Renderer, SDL::SDL_DestroyRenderer>;
 	using WindowUniquePtr = Engine::UniquePtr<SDL::SDL_Window, SDL::SDL_DestroyWindow>;
+	using TextureUniquePtr = Engine::UniquePtr<SDL::SDL_Texture, SDL::SDL_DestroyTexture>;
 }
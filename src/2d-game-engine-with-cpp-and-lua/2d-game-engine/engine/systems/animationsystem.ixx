@@ -1,7 +1,9 @@
 export module engine:systems.animationsystem;
+import std;
 import :sdl3;
 import :ecs;
 import :components;
+import :scheduler;
 
 export namespace Engine
 {
@@ -13,21 +15,33 @@ export namespace Engine
 		{
 			RequireComponent<SpriteComponent>();
 			RequireComponent<AnimationComponent>();
+			WritesComponent<AnimationComponent>();
+			WritesComponent<SpriteComponent>();
 		}
 
-		void Update()
+		// The chunks are split between the job pool's threads.
+		void Update(JobPool& jobs)
 		{
-			for (auto entity : GetEntities())
-			{
-				auto& animation = registry.GetComponent<AnimationComponent>(entity);
-				auto& sprite = registry.GetComponent<SpriteComponent>(entity);
-				animation.CurrentFrame = 
-					(((SDL::SDL_GetTicks() - animation.StartTime) 
-						* animation.FrameSpeedRate) / 1000) % animation.NumFrames;
-				sprite.srcRect.x = static_cast<float>(animation.CurrentFrame * sprite.width);
-			}
+			auto ticks = SDL::SDL_GetTicks();
+			registry.View(chunks);
+			jobs.ForEach(chunks.size(),
+				[&](std::size_t begin, std::size_t end)
+				{
+					for (auto& chunk : std::span{ chunks }.subspan(begin, end - begin))
+					{
+						for (auto&& [animation, sprite] : chunk.Each())
+						{
+							animation.CurrentFrame = 
+								(((ticks - animation.StartTime) 
+									* animation.FrameSpeedRate) / 1000) % animation.NumFrames;
+							sprite.srcRect.x = static_cast<float>(animation.CurrentFrame * sprite.width);
+						}
+					}
+				});
 		}
 	private:
 		Registry& registry;
+		// Kept from one frame to the next, for its capacity.
+		std::vector<ViewChunk<AnimationComponent, SpriteComponent>> chunks;
 	};
 }
\ No newline at end of file
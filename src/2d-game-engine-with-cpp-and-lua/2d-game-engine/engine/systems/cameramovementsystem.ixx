@@ -15,6 +15,8 @@ export namespace Engine
 		{
 			RequireComponent<CameraFollowComponent>();
 			RequireComponent<TransformComponent>();
+			ReadsComponent<CameraFollowComponent>();
+			ReadsComponent<TransformComponent>();
 		}
 
 		void Update(SDL::SDL_Rect& camera, std::uint32_t windowWidth, std::uint32_t windowHeight, std::uint32_t mapWidth, std::uint32_t mapHeight)
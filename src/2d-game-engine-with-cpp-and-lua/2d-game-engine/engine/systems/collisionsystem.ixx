@@ -2,9 +2,9 @@ export module engine:systems.collisionsystem;
 import std;
 import :ecs;
 import :components;
-import :log;
 import :eventbus;
 import :events;
+import :collision;
 
 export namespace Engine
 {
@@ -16,47 +16,56 @@ export namespace Engine
 		{
 			RequireComponent<TransformComponent>();
 			RequireComponent<BoxColliderComponent>();
+			ReadsComponent<TransformComponent>();
+			ReadsComponent<BoxColliderComponent>();
 		}
 		void Update(EventBus& eventBus)
 		{
+			// Axis-Aligned Bounding Box (AABB) collision detection, in two
+			// phases. The broad phase finds the pairs of entities whose boxes
+			// overlap without testing each against every other, which grew
+			// quadratically with the bullets in flight; only those pairs get
+			// the exact test.
 			auto entities = GetEntities();
+			bounds.clear();
+			for (auto entity : entities)
+				bounds.push_back(BoundsOf(registry.GetComponent<TransformComponent>(entity), registry.GetComponent<BoxColliderComponent>(entity)));
 
-			// Axis-Aligned Bounding Box (AABB) collision detection
-			// We use iterators to avoid checking the same pair of entities twice and 
-			// to avoid checking an entity against itself. This works because the data 
-			// structure is linear, so each entity is only checked against the entities 
-			// that come after it in the list. This is a slightly modified version of
-			// the implementation provided in the course.
-			//
-			// Some comments from Copilot when I asked it about this approach:
-			// 
-			// That loop pattern is usually called pairwise iteration over unique 
-			// unordered pairs. It avoids duplicate checks like(A, B) and (B, A)  by 
-			// starting the inner loop at std::next(i), and it avoids self-checks 
-			// like(A, A). It does not reduce the algorithmic complexity below quadratic, 
-			// though: it’s still O(n²), just roughly half as many comparisons: n*(n-1)/2.
-			// For collision detection, this is still considered a brute - force broad 
-			// phase using unique pair generation.To truly avoid O(n²), you’d use spatial 
-			// partitioning techniques like a uniform grid, quadtree, spatial hash, sweep 
-			// and prune, or a BVH.
-			for (auto i = entities.begin(); i != entities.end(); ++i)
-			{
-				auto entityA = *i;
-				auto& transformA = registry.GetComponent<TransformComponent>(entityA);
-				auto& colliderA = registry.GetComponent<BoxColliderComponent>(entityA);
-				for (auto j = std::next(i); j != entities.end(); ++j)
+			// The events are queued once all the pairs are found, and their
+			// handlers run when the game dispatches them after the systems.
+			collisions.clear();
+			auto checkPair =
+				[&](std::uint32_t a, std::uint32_t b)
 				{
-					auto entityB = *j;
+					auto entityA = entities[a];
+					auto entityB = entities[b];
+					auto& transformA = registry.GetComponent<TransformComponent>(entityA);
+					auto& colliderA = registry.GetComponent<BoxColliderComponent>(entityA);
 					auto& transformB = registry.GetComponent<TransformComponent>(entityB);
 					auto& colliderB = registry.GetComponent<BoxColliderComponent>(entityB);
 					if (CheckAABBCollision(transformA, colliderA, transformB, colliderB))
-					{
-						Log::Info("Collision detected between entities {} and {}", entityA.GetId(), entityB.GetId());
-						eventBus.EmitEvent<CollisionEvent>(entityA, entityB);
-					}
-				}
+						collisions.emplace_back(entityA, entityB);
+				};
+			if (broadPhase == BroadPhaseKind::SpatialHash)
+			{
+				spatialHash.Build(bounds);
+				spatialHash.ForEachPair(checkPair);
+			}
+			else
+			{
+				sweepAndPrune.Build(bounds);
+				sweepAndPrune.ForEachPair(checkPair);
 			}
+
+			for (auto [entityA, entityB] : collisions)
+				eventBus.QueueEvent<CollisionEvent>(entityA, entityB);
+		}
+
+		void SetBroadPhase(BroadPhaseKind kind)
+		{
+			broadPhase = kind;
 		}
+
 	private:
 		auto CheckAABBCollision(
 			const TransformComponent& transformA, const BoxColliderComponent& colliderA,
@@ -70,6 +79,23 @@ export namespace Engine
 					((transformA.position.y + colliderA.Offset.y) + colliderA.Height) > transformB.position.y);
 		}
 
+		// Covers the collider both with and without its offset, as
+		// CheckAABBCollision only offsets the first of the two.
+		static auto BoundsOf(const TransformComponent& transform, const BoxColliderComponent& collider) -> Bounds
+		{
+			auto left = transform.position.x + std::min(collider.Offset.x, 0.0f);
+			auto top = transform.position.y + std::min(collider.Offset.y, 0.0f);
+			auto right = transform.position.x + std::max(collider.Offset.x, 0.0f) + collider.Width;
+			auto bottom = transform.position.y + std::max(collider.Offset.y, 0.0f) + collider.Height;
+			return { left, top, right, bottom };
+		}
+
 		Registry& registry;
+		BroadPhaseKind broadPhase = BroadPhaseKind::SpatialHash;
+		SpatialHash spatialHash;
+		SweepAndPrune sweepAndPrune;
+		// Kept between updates so that they don't allocate once warmed up.
+		std::vector<Bounds> bounds;
+		std::vector<std::pair<Entity, Entity>> collisions;
 	};
 }
\ No newline at end of file
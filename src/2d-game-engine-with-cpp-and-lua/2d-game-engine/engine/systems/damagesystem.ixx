@@ -18,7 +18,7 @@ export namespace Engine
 		}
 		void SubscribeToEvents(EventBus& eventBus)
 		{
-			eventBus.SubscribeToEvent<CollisionEvent>(this, &DamageSystem::OnCollision);
+			eventBus.Subscribe<&DamageSystem::OnCollision>(this);
 		}
 		void Update(EventBus& eventBus)
 		{
@@ -23,7 +23,7 @@ export namespace Engine
 		void SubscribeToEvents(EventBus& eventBus)
 		{
 			// Subscribe to keyboard events if needed
-			eventBus.SubscribeToEvent<KeyPressedEvent>(this, &KeyboardControlSystem::OnKeyPressedEvent);
+			eventBus.Subscribe<&KeyboardControlSystem::OnKeyPressedEvent>(this);
 		}
 	private:
 		void OnKeyPressedEvent(const KeyPressedEvent& event)
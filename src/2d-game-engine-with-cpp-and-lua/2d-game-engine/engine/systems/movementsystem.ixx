@@ -1,7 +1,9 @@
 export module engine:systems.movementsystem;
+import std;
 import :glm;
 import :ecs;
 import :components;
+import :scheduler;
 
 export namespace Engine
 {
@@ -12,23 +14,74 @@ export namespace Engine
 		{
 			RequireComponent<TransformComponent>();
 			RequireComponent<RigidBodyComponent>();
+			ReadsComponent<RigidBodyComponent>();
+			WritesComponent<TransformComponent>();
 		}
 
-		void Update(double deltaTime)
+		// The chunks are split between the job pool's threads. Each chunk
+		// notes the entities it moves in its own part of movedEntities,
+		// starting where its entities would, so the threads share nothing,
+		// and the parts are packed together once they're done.
+		void Update(double deltaTime, JobPool& jobs)
 		{
-			for (auto entity : GetEntities())
+			registry.View(chunks);
+			chunkStarts.clear();
+			auto entityCount = std::size_t{ 0 };
+			for (auto& chunk : chunks)
 			{
-				auto& transform = registry.GetComponent<TransformComponent>(entity);
-				auto& rigidbody = registry.GetComponent<RigidBodyComponent>(entity);
+				chunkStarts.push_back(entityCount);
+				entityCount += chunk.GetSize();
+			}
+			movedEntities.resize(entityCount, Entity{ 0 });
+			movedCounts.assign(chunks.size(), 0);
+
+			jobs.ForEach(chunks.size(),
+				[&](std::size_t begin, std::size_t end)
+				{
+					for (auto index = begin; index < end; index++)
+					{
+						auto& chunk = chunks[index];
+						auto entities = chunk.GetEntities();
+						auto transforms = chunk.Get<TransformComponent>();
+						auto rigidBodies = chunk.Get<RigidBodyComponent>();
+						auto moved = chunkStarts[index];
+						for (auto i = std::size_t{ 0 }; i < chunk.GetSize(); i++)
+						{
+							if (rigidBodies[i].velocity == glm::vec2{ 0.0f, 0.0f })
+								continue;
+							transforms[i].position += glm::vec2{
+								rigidBodies[i].velocity.x * static_cast<float>(deltaTime),
+								rigidBodies[i].velocity.y * static_cast<float>(deltaTime)
+							};
+							movedEntities[moved++] = entities[i];
+						}
+						movedCounts[index] = moved - chunkStarts[index];
+					}
+				});
 
-				transform.position += glm::vec2{
-					rigidbody.velocity.x * static_cast<float>(deltaTime),
-					rigidbody.velocity.y * static_cast<float>(deltaTime)
-				};
+			auto packed = movedEntities.begin();
+			for (auto index = std::size_t{ 0 }; index < chunks.size(); index++)
+			{
+				auto start = movedEntities.begin() + chunkStarts[index];
+				packed = std::move(start, start + movedCounts[index], packed);
 			}
+			movedEntities.erase(packed, movedEntities.end());
+		}
+
+		// The entities whose transforms the last Update() changed, for
+		// keeping what's derived from them up to date. Valid until the
+		// next Update().
+		auto GetMovedEntities() const noexcept -> std::span<const Entity>
+		{
+			return movedEntities;
 		}
 
 	private:
 		Registry& registry;
+		// Kept from one frame to the next, for their capacity.
+		std::vector<ViewChunk<TransformComponent, RigidBodyComponent>> chunks;
+		std::vector<std::size_t> chunkStarts;
+		std::vector<std::size_t> movedCounts;
+		std::vector<Entity> movedEntities;
 	};
 }
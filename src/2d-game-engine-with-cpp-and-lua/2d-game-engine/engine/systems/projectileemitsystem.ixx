@@ -1,20 +1,27 @@
 export module engine:systems.projectileemitsystem;
+import std;
 import :ecs;
 import :components;
 import :sdl3;
+import :assetstore;
 
 export namespace Engine
 {
 	class ProjectileEmitSystem : public System
 	{
 	public:
-		ProjectileEmitSystem()
+		ProjectileEmitSystem(TextureHandle projectileTexture) : projectileTexture(projectileTexture)
 		{
 			RequireComponent<ProjectileEmitterComponent>();
 			RequireComponent<TransformComponent>();
+			ReadsComponent<TransformComponent>();
+			ReadsComponent<SpriteComponent>();
+			WritesComponent<ProjectileEmitterComponent>();
 		}
 
-		void Update(float deltaTime, Registry& registry)
+		// The projectiles are created through the command buffer, as other
+		// systems may be running.
+		void Update(float deltaTime, Registry& registry, CommandBuffer& commands)
 		{
 			for(auto entity : GetEntities())
 			{
@@ -23,7 +30,6 @@ export namespace Engine
 
 				if (SDL::SDL_GetTicks() - projectileEmitter.LastEmissionTime >= projectileEmitter.RepeatFrequency)
 				{
-					auto projectile = registry.CreateEntity();
 					auto projectilePosition = transform.position;
 					if (registry.HasComponent<RigidBodyComponent>(entity))
 					{
@@ -32,13 +38,17 @@ export namespace Engine
 						projectilePosition.y += (transform.scale.y * sprite.height) / 2.0f;
 					}
 
-					registry.AddComponent<TransformComponent>(projectile, projectilePosition, glm::vec2{ 1.0f, 1.0f }, 0.0f)
-						.AddComponent<RigidBodyComponent>(projectile, projectileEmitter.ProjectileVelocity, 1.0f)
-						.AddComponent<SpriteComponent>(projectile, "bullet-image", 4, 4, 4)
-						.AddComponent<BoxColliderComponent>(projectile, 4, 4);
+					commands.CreateEntity(
+						TransformComponent{ projectilePosition, glm::vec2{ 1.0f, 1.0f }, 0.0f },
+						RigidBodyComponent{ projectileEmitter.ProjectileVelocity, 1.0f },
+						SpriteComponent{ projectileTexture, 4, 4, 4 },
+						BoxColliderComponent{ 4, 4 });
 					projectileEmitter.LastEmissionTime = SDL::SDL_GetTicks();
 				}
 			}
 		}
+
+	private:
+		TextureHandle projectileTexture;
 	};
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 export module engine:systems.rendersystem;
+import std;
 import :ecs;
 import :components;
 import :sdl3;
-import :ecs;
 import :assetstore;
+import :render;
+import :collision;
 
 export namespace Engine
 {
@@ -16,7 +18,23 @@ export namespace Engine
 			RequireComponent<SpriteComponent>();
 		}
 
-		void Update(SDL::SDL_Renderer* renderer, AssetStore& assetStore, SDL::SDL_Rect& camera)
+		// Sprites are kept sorted by layer, then texture, from one frame to
+		// the next, and each run of sprites that share a texture is drawn
+		// with one call, as a list of quads. Sprites that keep their z-index
+		// and texture cost no sorting, and the vertices are built into
+		// buffers that are kept, so a frame allocates nothing once they've
+		// grown to fit.
+		//
+		// Only sprites whose bounds overlap the camera, give or take a
+		// margin, are drawn. They're found through a grid of every sprite's
+		// bounds, which is only updated for the sprites that joined the
+		// system or moved, so a frame's cost depends on what's on screen and
+		// what moved, not on the size of the world. Fixed sprites, such as
+		// the HUD, are always drawn, and aren't in the grid.
+		//
+		// movedEntities are those whose transforms changed since the last
+		// frame; MovementSystem::GetMovedEntities() gives them.
+		void Update(SDL::SDL_Renderer* renderer, AssetStore& assetStore, SDL::SDL_Rect& camera, std::span<const Entity> movedEntities)
 		{
 			constexpr auto darkSapphire = SDL::SDL_Color{ 31, 48, 94, 255 };
 			constexpr auto royalBlue = SDL::SDL_Color{ 48, 92, 222, 255 };
@@ -25,43 +43,257 @@ export namespace Engine
 			/*SDL::SDL_SetRenderDrawColor(renderer, clearColor.r, clearColor.g, clearColor.b, clearColor.a);
 			SDL::SDL_RenderClear(renderer);*/
 
-			// Sort by z-index before rendering to ensure correct layering.
-			// This is not efficient, as sorting happens every frame, there
-			// may be better ways of doing things, such as sorting at the
-			// time of entity creation.
-			auto basicEntities = GetEntities();
-			struct RenderableEntity
-			{
-				TransformComponent transformComponent;
-				SpriteComponent spriteComponent;
+			for (auto entity : movedEntities)
+				UpdateBounds(entity);
+			for (auto entity : changedSprites)
+				UpdateBounds(entity);
+			changedSprites.clear();
+
+			auto area = Bounds{
+				camera.x - CullingMargin,
+				camera.y - CullingMargin,
+				camera.x + camera.w + CullingMargin,
+				camera.y + camera.h + CullingMargin
 			};
-			auto renderableEntities = basicEntities
-				| std::views::transform(
-					[this](auto entity) -> RenderableEntity
-					{
-						return { registry.GetComponent<TransformComponent>(entity), registry.GetComponent<SpriteComponent>(entity) };
-					})
-				| std::ranges::to<std::vector<RenderableEntity>>();
-			std::ranges::sort(renderableEntities, [](auto& lhs, auto& rhs) -> bool { return lhs.spriteComponent.zIndex < rhs.spriteComponent.zIndex; });
-
-			for (const auto& renderableEntity : renderableEntities)
+			queue.BeginFrame();
+			visibility.Query(area, [&](std::uint64_t id) { Submit(indexedSprites[id].entity); });
+			for (auto entity : fixedSprites)
+				Submit(entity);
+			auto items = queue.EndFrame();
+
+			vertices.clear();
+			indices.clear();
+			auto batchTexture = TextureHandle::Invalid;
+			for (const auto& item : items)
 			{
-				auto& transform = renderableEntity.transformComponent;
-				auto& sprite = renderableEntity.spriteComponent;
-
-				auto texture = assetStore.GetTexture(sprite.assetId);
-				auto rect = SDL::SDL_FRect{
-					sprite.isFixed ? transform.position.x : transform.position.x - camera.x,
-					sprite.isFixed ? transform.position.y : transform.position.y - camera.y,
-					static_cast<float>(sprite.width * transform.scale.x),
-					static_cast<float>(sprite.height * transform.scale.y)
-				};
-				auto srcRect = sprite.srcRect;
-				SDL::SDL_RenderTextureRotated(renderer, texture, &srcRect, &rect, transform.rotation, nullptr, SDL::SDL_FlipMode::SDL_FLIP_NONE);
+				auto& transform = *item.payload.transformComponent;
+				auto& sprite = *item.payload.spriteComponent;
+				if (sprite.texture != batchTexture)
+				{
+					DrawBatch(renderer, assetStore, batchTexture);
+					batchTexture = sprite.texture;
+				}
+				AddQuad(transform, sprite, assetStore.GetTextureSize(sprite.texture), sprite.isFixed ? SDL::SDL_FPoint{} : SDL::SDL_FPoint{ static_cast<float>(camera.x), static_cast<float>(camera.y) });
 			}
+			DrawBatch(renderer, assetStore, batchTexture);
 			//SDL::SDL_RenderPresent(renderer);
 		}
+
+		// For code that changes a sprite's bounds, or whether it's fixed,
+		// other than by moving it with MovementSystem or by giving it a
+		// new component.
+		void MarkChanged(Entity entity)
+		{
+			changedSprites.push_back(entity);
+		}
+
+	protected:
+		void OnEntityAdded(Entity entity) override
+		{
+			changedSprites.push_back(entity);
+		}
+
+		void OnEntityRemoved(Entity entity) override
+		{
+			visibility.Remove(entity.GetId());
+			RemoveFixed(entity.GetId());
+		}
+
 	private:
+		// Sprites this far outside the camera are still drawn, so that one
+		// going back and forth over the edge of the screen stays in the
+		// render queue rather than being merged in and dropped each frame.
+		static constexpr auto CullingMargin = 64.f;
+
+		// The components are pointed to rather than copied, and are only
+		// used in the frame they were submitted in.
+		struct RenderableEntity
+		{
+			const TransformComponent* transformComponent = nullptr;
+			const SpriteComponent* spriteComponent = nullptr;
+		};
+
+		struct IndexedSprite
+		{
+			Entity entity{ 0 };
+			// The sprite's position in fixedSprites plus one, or zero for
+			// sprites in the grid, or not indexed at all.
+			std::uint32_t fixedPosition = 0;
+		};
+
+		// Puts the sprite in the grid where it is now, or in fixedSprites
+		// if it's fixed. It only moves between the grid's cells when its
+		// centre crosses into another.
+		void UpdateBounds(Entity entity)
+		{
+			if (not HasEntity(entity))
+				return;
+			auto id = entity.GetId();
+			if (id >= indexedSprites.size())
+				indexedSprites.resize(id + 1);
+			indexedSprites[id].entity = entity;
+
+			auto& sprite = registry.GetComponent<SpriteComponent>(entity);
+			if (sprite.isFixed)
+			{
+				visibility.Remove(id);
+				if (indexedSprites[id].fixedPosition == 0)
+				{
+					fixedSprites.push_back(entity);
+					indexedSprites[id].fixedPosition = static_cast<std::uint32_t>(fixedSprites.size());
+				}
+				return;
+			}
+			RemoveFixed(id);
+			visibility.Set(id, BoundsOf(registry.GetComponent<TransformComponent>(entity), sprite));
+		}
+
+		void RemoveFixed(std::uint32_t id)
+		{
+			if (id >= indexedSprites.size() or indexedSprites[id].fixedPosition == 0)
+				return;
+			auto index = indexedSprites[id].fixedPosition - 1;
+			fixedSprites[index] = fixedSprites.back();
+			indexedSprites[fixedSprites[index].GetId()].fixedPosition = index + 1;
+			fixedSprites.pop_back();
+			indexedSprites[id].fixedPosition = 0;
+		}
+
+		// Where the sprite is drawn in the world, including when it's
+		// rotated about its centre.
+		static auto BoundsOf(const TransformComponent& transform, const SpriteComponent& sprite) -> Bounds
+		{
+			auto width = static_cast<float>(sprite.width * transform.scale.x);
+			auto height = static_cast<float>(sprite.height * transform.scale.y);
+			auto halfWidth = width / 2;
+			auto halfHeight = height / 2;
+			if (transform.rotation != 0)
+			{
+				auto radians = static_cast<float>(transform.rotation) * std::numbers::pi_v<float> / 180.f;
+				auto cos = std::abs(std::cos(radians));
+				auto sin = std::abs(std::sin(radians));
+				halfWidth = (width * cos + height * sin) / 2;
+				halfHeight = (width * sin + height * cos) / 2;
+			}
+			auto centreX = transform.position.x + width / 2;
+			auto centreY = transform.position.y + height / 2;
+			return { centreX - halfWidth, centreY - halfHeight, centreX + halfWidth, centreY + halfHeight };
+		}
+
+		// Looks the components up again, as they may have moved in storage
+		// since the sprite was indexed.
+		void Submit(Entity entity)
+		{
+			auto& transform = registry.GetComponent<TransformComponent>(entity);
+			auto& sprite = registry.GetComponent<SpriteComponent>(entity);
+			auto key = MakeRenderSortKey(sprite.zIndex, std::to_underlying(sprite.texture), entity.GetId());
+			queue.Submit(entity.GetId(), key, { &transform, &sprite });
+		}
+
+		// Adds the sprite's destination rectangle, rotated about its centre
+		// as SDL_RenderTextureRotated would, to the batch.
+		void AddQuad(const TransformComponent& transform, const SpriteComponent& sprite, SDL::SDL_FPoint textureSize, SDL::SDL_FPoint cameraOffset)
+		{
+			auto width = static_cast<float>(sprite.width * transform.scale.x);
+			auto height = static_cast<float>(sprite.height * transform.scale.y);
+			auto centre = SDL::SDL_FPoint{
+				transform.position.x - cameraOffset.x + width / 2,
+				transform.position.y - cameraOffset.y + height / 2
+			};
+			// Clockwise, in degrees, as the y axis points down.
+			auto radians = static_cast<float>(transform.rotation) * std::numbers::pi_v<float> / 180.f;
+			auto cos = std::cos(radians);
+			auto sin = std::sin(radians);
+
+			auto& src = sprite.srcRect;
+			auto left = src.x / textureSize.x;
+			auto top = src.y / textureSize.y;
+			auto right = (src.x + src.w) / textureSize.x;
+			auto bottom = (src.y + src.h) / textureSize.y;
+
+			constexpr auto white = SDL::SDL_FColor{ 1, 1, 1, 1 };
+			auto vertex = [&](float x, float y, float u, float v) -> SDL::SDL_Vertex
+			{
+				return {
+					{ centre.x + x * cos - y * sin, centre.y + x * sin + y * cos },
+					white,
+					{ u, v }
+				};
+			};
+			auto first = static_cast<int>(vertices.size());
+			vertices.push_back(vertex(-width / 2, -height / 2, left, top));
+			vertices.push_back(vertex(width / 2, -height / 2, right, top));
+			vertices.push_back(vertex(width / 2, height / 2, right, bottom));
+			vertices.push_back(vertex(-width / 2, height / 2, left, bottom));
+			for (auto corner : { 0, 1, 2, 0, 2, 3 })
+				indices.push_back(first + corner);
+		}
+
+		void DrawBatch(SDL::SDL_Renderer* renderer, const AssetStore& assetStore, TextureHandle texture)
+		{
+			if (vertices.empty())
+				return;
+			SDL::SDL_RenderGeometry(
+				renderer,
+				assetStore.GetTexture(texture),
+				vertices.data(),
+				static_cast<int>(vertices.size()),
+				indices.data(),
+				static_cast<int>(indices.size())
+			);
+			vertices.clear();
+			indices.clear();
+		}
+
 		Registry& registry;
+		RenderQueue<RenderableEntity> queue;
+		LooseGrid visibility;
+		// By entity ID.
+		std::vector<IndexedSprite> indexedSprites;
+		std::vector<Entity> fixedSprites;
+		// Sprites to put in the grid, or in fixedSprites, in the next frame.
+		std::vector<Entity> changedSprites;
+		std::vector<SDL::SDL_Vertex> vertices;
+		std::vector<int> indices;
 	};
 }
+
+namespace
+{
+	using namespace Engine;
+
+	// Test that a sprite that leaves the camera, and is dropped from the
+	// render queue, is drawn again once it comes back, as RenderSystem
+	// does it: the grid is queried with the camera, and what it finds is
+	// submitted. Reading a dropped sprite's old place in the queue would
+	// stop this from compiling.
+	static_assert(
+		[] -> bool
+		{
+			auto grid = LooseGrid{ 64, 16 };
+			auto queue = RenderQueue<int>{};
+			auto camera = Bounds{ 0, 0, 800, 600 };
+			auto drawFrame = [&] -> std::span<const RenderQueue<int>::Item>
+			{
+				queue.BeginFrame();
+				grid.Query(camera, [&](std::uint64_t id) { queue.Submit(id, MakeRenderSortKey(1, 0, static_cast<std::uint32_t>(id)), static_cast<int>(id)); });
+				return queue.EndFrame();
+			};
+			for (auto id = std::uint64_t{ 0 }; id < 10; id++)
+				grid.Set(id, { id * 50.f, 10, id * 50.f + 32, 42 });
+			if (drawFrame().size() != 10)
+				throw "Expected every sprite on screen to be drawn";
+
+			for (auto id = std::uint64_t{ 3 }; id < 10; id++)
+				grid.Set(id, { 5000, 10, 5032, 42 });
+			if (drawFrame().size() != 3)
+				throw "Expected sprites off screen not to be drawn";
+
+			grid.Set(9, { 100, 300, 132, 332 });
+			auto items = drawFrame();
+			if (items.size() != 4 or items.back().id != 9)
+				throw "Expected a sprite back on screen to be drawn again";
+			return true;
+		}()
+	);
+}
\ No newline at end of file
@@ -0,0 +1,4 @@
+export module batchrender;
+export import :turntable;
+export import :imagewriter;
+export import :renderjob;
@@ -0,0 +1,38 @@
+export module batchrender:imagewriter;
+import std;
+import renderer;
+
+export namespace batchrender
+{
+	// The path of a frame in an image sequence, e.g. frames/frame_00042.ppm.
+	auto frame_path(const std::filesystem::path& directory, std::uint32_t frame) -> std::filesystem::path
+	{
+		return directory / std::format("frame_{:05}.ppm", frame);
+	}
+
+	// Writes a colour buffer as a binary PPM (P6), which most image tools
+	// and ffmpeg read directly. Alpha is dropped.
+	void write_ppm(const std::filesystem::path& path, const renderer::color_buffer& buffer)
+	{
+		auto file = std::ofstream{ path, std::ios::binary };
+		if (not file)
+			throw std::runtime_error(std::format("Failed to create {}", path.string()));
+
+		file << std::format("P6\n{} {}\n255\n", buffer.width(), buffer.height());
+		auto row_bytes = std::vector<char>(std::size_t{ buffer.width() } * 3);
+		for (std::uint32_t row = 0; row < buffer.height(); row++)
+		{
+			auto out = row_bytes.begin();
+			for (auto pixel : buffer.row(row))
+			{
+				// 0xAARRGGBB
+				*out++ = static_cast<char>((pixel >> 16) & 0xff);
+				*out++ = static_cast<char>((pixel >> 8) & 0xff);
+				*out++ = static_cast<char>(pixel & 0xff);
+			}
+			file.write(row_bytes.data(), static_cast<std::streamsize>(row_bytes.size()));
+		}
+		if (not file)
+			throw std::runtime_error(std::format("Failed to write {}", path.string()));
+	}
+}
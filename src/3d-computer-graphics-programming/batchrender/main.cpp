@@ -0,0 +1,175 @@
+// Renders a turntable image sequence of a mesh without opening a window.
+//
+//   batchrender --mesh <file.obj> [--texture <file.png>] [--output <dir>]
+//               [--frames <count>] [--size <width>x<height>]
+//               [--rotation <x>,<y>,<z>] [--start <x>,<y>,<z>]
+//               [--camera <x>,<y>,<z>] [--distance <z>] [--fov <degrees>]
+//               [--mode <render mode>] [--threads <count>]
+//               [--depth float|unorm24|unorm16]
+//
+// The mesh turns by --rotation degrees (0,360,0 by default) over the
+// sequence, starting from --start, and each frame is written to
+// <output>/frame_NNNNN.ppm. Without a texture, the built-in red brick
+// texture is used. Frames are rendered in parallel, on one thread per
+// hardware thread unless --threads says otherwise; the images don't
+// depend on the thread count. --depth picks the depth buffer's format;
+// the compact ones save memory traffic at the cost of depth precision.
+import std;
+import renderer;
+import batchrender;
+
+namespace
+{
+	struct options
+	{
+		std::filesystem::path mesh;
+		std::optional<std::filesystem::path> texture;
+		batchrender::job job;
+	};
+
+	auto parse_floats(std::string_view text, std::size_t count) -> std::vector<float>
+	{
+		auto values = std::vector<float>{};
+		for (auto&& part : text | std::views::split(','))
+		{
+			auto value = 0.f;
+			auto [end, error] = std::from_chars(part.data(), part.data() + part.size(), value);
+			if (error != std::errc{} or end != part.data() + part.size())
+				throw std::invalid_argument(std::format("'{}' is not a number", std::string_view{ part }));
+			values.push_back(value);
+		}
+		if (values.size() != count)
+			throw std::invalid_argument(std::format("Expected {} comma-separated numbers, got '{}'", count, text));
+		return values;
+	}
+
+	auto parse_vector(std::string_view text) -> renderer::vector_3f
+	{
+		auto values = parse_floats(text, 3);
+		return { values[0], values[1], values[2] };
+	}
+
+	auto parse_render_mode(std::string_view text) -> renderer::render_mode
+	{
+		using enum renderer::render_mode;
+		constexpr auto modes = std::array{
+			std::pair{ "wireframe_with_dot", wireframe_with_dot },
+			std::pair{ "wireframe", wireframe },
+			std::pair{ "filled", filled },
+			std::pair{ "filled_wireframe", filled_wireframe },
+			std::pair{ "textured", textured },
+			std::pair{ "textured_wireframe", textured_wireframe }
+		};
+		for (auto&& [name, mode] : modes)
+			if (text == name)
+				return mode;
+		throw std::invalid_argument(std::format("Unknown render mode {}", text));
+	}
+
+	auto parse_depth_format(std::string_view text) -> renderer::depth_encoding
+	{
+		using enum renderer::depth_encoding;
+		constexpr auto formats = std::array{
+			std::pair{ "float", float32 },
+			std::pair{ "unorm24", unorm24 },
+			std::pair{ "unorm16", unorm16 }
+		};
+		for (auto&& [name, format] : formats)
+			if (text == name)
+				return format;
+		throw std::invalid_argument(std::format("Unknown depth format {}", text));
+	}
+
+	auto parse_options(std::span<char*> arguments) -> options
+	{
+		auto result = options{};
+		for (auto i = std::size_t{ 1 }; i < arguments.size(); i++)
+		{
+			auto argument = std::string_view{ arguments[i] };
+			auto value = [&]() -> std::string_view
+			{
+				if (i + 1 == arguments.size())
+					throw std::invalid_argument(std::format("{} requires a value", argument));
+				return arguments[++i];
+			};
+
+			if (argument == "--mesh")
+				result.mesh = value();
+			else if (argument == "--texture")
+				result.texture = value();
+			else if (argument == "--output")
+				result.job.output_directory = value();
+			else if (argument == "--frames")
+				result.job.path.frame_count = static_cast<std::uint32_t>(std::stoul(std::string{ value() }));
+			else if (argument == "--size")
+			{
+				auto size = std::string{ value() };
+				std::ranges::replace(size, 'x', ',');
+				auto values = parse_floats(size, 2);
+				result.job.width = static_cast<std::uint32_t>(values[0]);
+				result.job.height = static_cast<std::uint32_t>(values[1]);
+			}
+			else if (argument == "--rotation")
+				result.job.path.total_rotation = parse_vector(value());
+			else if (argument == "--start")
+				result.job.path.start_rotation = parse_vector(value());
+			else if (argument == "--camera")
+				result.job.path.camera.position = parse_vector(value());
+			else if (argument == "--distance")
+				result.job.path.translation.z = parse_floats(value(), 1)[0];
+			else if (argument == "--fov")
+				result.job.field_of_view = renderer::degrees{ parse_floats(value(), 1)[0] };
+			else if (argument == "--mode")
+				result.job.settings.rendering_mode = parse_render_mode(value());
+			else if (argument == "--threads")
+				result.job.threads = static_cast<unsigned>(std::stoul(std::string{ value() }));
+			else if (argument == "--depth")
+				result.job.depth = parse_depth_format(value());
+			else
+				throw std::invalid_argument(std::format("Unknown argument {}", argument));
+		}
+		if (result.mesh.empty())
+			throw std::invalid_argument("--mesh is required");
+		if (result.job.width == 0 or result.job.height == 0)
+			throw std::invalid_argument("--size must be at least 1x1");
+		return result;
+	}
+}
+
+auto main(int argc, char* argv[]) -> int
+try
+{
+	auto options = parse_options(std::span{ argv, static_cast<std::size_t>(argc) });
+
+	options.job.mesh = renderer::mesh{ options.mesh };
+	// Kept alive for the whole job, as the job only points at its pixels.
+	auto texture = std::optional<upng::upng_texture>{};
+	if (options.texture)
+	{
+		texture.emplace(*options.texture);
+		options.job.texture = {
+			.buffer = texture->uint32_buffer(),
+			.width = texture->width(),
+			.height = texture->height()
+		};
+	}
+
+	auto summary = batchrender::render_sequence(options.job);
+	std::println(
+		std::cerr,
+		"Rendered {} frames of {}x{} to {} in {:.2f}s on {} threads: {:.1f} frames/s",
+		summary.frames,
+		options.job.width,
+		options.job.height,
+		options.job.output_directory.string(),
+		std::chrono::duration<double>{ summary.elapsed }.count(),
+		summary.threads,
+		summary.frames_per_second()
+	);
+	return 0;
+}
+catch (const std::exception& e)
+{
+	std::cerr << "An exception occurred: " << e.what() << std::endl;
+	return 1;
+}
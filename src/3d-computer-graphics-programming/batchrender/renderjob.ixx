@@ -0,0 +1,128 @@
+export module batchrender:renderjob;
+import std;
+import renderer;
+import :turntable;
+import :imagewriter;
+
+export namespace batchrender
+{
+	struct job
+	{
+		renderer::mesh mesh;
+		renderer::texture::selected_texture texture = renderer::texture::red_brick();
+		turntable path;
+		std::uint32_t width = 1920;
+		std::uint32_t height = 1080;
+		renderer::degrees field_of_view{ 60.f };
+		renderer::settings settings{ .rendering_mode = renderer::render_mode::textured };
+		renderer::depth_encoding depth = renderer::depth_encoding::float32;
+		std::filesystem::path output_directory = "frames";
+		// Zero uses one thread per hardware thread.
+		unsigned threads = 0;
+	};
+
+	struct summary
+	{
+		std::uint32_t frames = 0;
+		unsigned threads = 0;
+		std::chrono::nanoseconds elapsed{};
+
+		auto frames_per_second() const noexcept -> double
+		{
+			auto seconds = std::chrono::duration<double>{ elapsed }.count();
+			return seconds > 0 ? frames / seconds : 0.0;
+		}
+	};
+
+	// Renders every frame of a job's path and writes each to its own
+	// image in the output directory.
+	//
+	// Frames don't depend on each other, so they're handed out to a pool
+	// of threads one at a time from a shared counter, which keeps every
+	// thread busy however long individual frames take. Each thread renders
+	// into its own frame buffer and arena and poses its own copy of the
+	// mesh, and a frame's pose comes from its number alone, so the images
+	// are the same whatever the thread count or the order frames finish in.
+	auto render_sequence(const job& job) -> summary
+	{
+		std::filesystem::create_directories(job.output_directory);
+
+		const auto threads = std::max(1u, job.threads == 0 ? std::thread::hardware_concurrency() : job.threads);
+		const auto frame_count = job.path.frame_count;
+		constexpr auto near_plane = 0.1f;
+		const auto view = renderer::view_parameters{
+			.camera = job.path.camera,
+			.projection = renderer::projective_perspective_divide_matrix{
+				renderer::radians{ job.field_of_view },
+				static_cast<float>(job.width) / static_cast<float>(job.height),
+				near_plane,
+				100.f
+			},
+			.width = job.width,
+			.height = job.height,
+			.culling = job.settings.culling_mode
+		};
+
+		auto next_frame = std::atomic<std::uint32_t>{ 0 };
+		auto failure = std::exception_ptr{};
+		auto failure_mutex = std::mutex{};
+
+		auto render_frames = [&]<typename TDepth>(TDepth format)
+		{
+			try
+			{
+				auto mesh = job.mesh;
+				mesh.translation = job.path.translation;
+				auto frame_buffer = renderer::frame_buffer_with_depth<TDepth>{ job.width, job.height, format };
+				auto arena = renderer::frame_arena{ 1 << 20 };
+
+				for (auto frame = next_frame++; frame < frame_count; frame = next_frame++)
+				{
+					arena.reset();
+					mesh.rotation = job.path.rotation_at(frame);
+					auto triangles = renderer::project_mesh(mesh, view, arena);
+					frame_buffer.clear_color_buffer(0xff000000).clear_z_buffer();
+					renderer::draw_triangles(triangles, job.texture, job.settings, frame_buffer);
+					write_ppm(frame_path(job.output_directory, frame), frame_buffer.color);
+				}
+			}
+			catch (...)
+			{
+				// Stop handing out frames, and report the first error.
+				next_frame = frame_count;
+				auto lock = std::scoped_lock{ failure_mutex };
+				if (not failure)
+					failure = std::current_exception();
+			}
+		};
+		auto render_frames_in_job_format = [&]
+		{
+			switch (job.depth)
+			{
+			case renderer::depth_encoding::unorm24:
+				render_frames(renderer::unorm24_depth{ .near_plane = near_plane });
+				break;
+			case renderer::depth_encoding::unorm16:
+				render_frames(renderer::unorm16_depth{ .near_plane = near_plane });
+				break;
+			default:
+				render_frames(renderer::float_depth{});
+				break;
+			}
+		};
+
+		auto start = std::chrono::steady_clock::now();
+		{
+			auto workers = std::vector<std::jthread>{};
+			workers.reserve(threads - 1);
+			for (auto i = 1u; i < threads; i++)
+				workers.emplace_back(render_frames_in_job_format);
+			render_frames_in_job_format();
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+
+		if (failure)
+			std::rethrow_exception(failure);
+		return { .frames = frame_count, .threads = threads, .elapsed = elapsed };
+	}
+}
@@ -0,0 +1,48 @@
+export module batchrender:turntable;
+import std;
+import renderer;
+
+export namespace batchrender
+{
+	// The camera/rotation path of a sequence: the camera stays put while
+	// the mesh, placed at translation, turns from start_rotation through
+	// total_rotation (both in degrees about x, y and z) over frame_count
+	// frames. The last frame stops one step short of the full rotation, so
+	// a 360 degree sequence loops without repeating a frame.
+	struct turntable
+	{
+		renderer::camera_t camera{};
+		renderer::vector_4f translation{ .x = 0.f, .y = 0.f, .z = 4.f };
+		renderer::vector_3f start_rotation{ 0.f, 0.f, 0.f };
+		renderer::vector_3f total_rotation{ 0.f, 360.f, 0.f };
+		std::uint32_t frame_count = 120;
+
+		// The mesh's rotation in radians at a frame. It's worked out from
+		// the frame number alone, so frames can be rendered in any order
+		// and on any thread and still come out the same.
+		constexpr auto rotation_at(this const turntable& self, std::uint32_t frame) noexcept -> renderer::vector_4f
+		{
+			auto progress = self.frame_count == 0 ? 0.f : static_cast<float>(frame) / static_cast<float>(self.frame_count);
+			auto angle = [progress](float start, float total)
+			{
+				return static_cast<float>(renderer::radians{ renderer::degrees{ start + total * progress } });
+			};
+			return {
+				.x = angle(self.start_rotation.x, self.total_rotation.x),
+				.y = angle(self.start_rotation.y, self.total_rotation.y),
+				.z = angle(self.start_rotation.z, self.total_rotation.z)
+			};
+		}
+	};
+}
+
+static_assert(
+	[]{
+		auto path = batchrender::turntable{ .total_rotation{ 0.f, 360.f, 0.f }, .frame_count = 4 };
+		auto quarter = path.rotation_at(1);
+		return path.rotation_at(0).y == 0.f
+			and quarter.x == 0.f
+			and quarter.y == static_cast<float>(renderer::radians{ renderer::degrees{ 90.f } });
+	}(),
+	"A turntable is expected to turn by an equal step each frame."
+);
@@ -0,0 +1,4 @@
+export module benchmarks;
+export import :harness;
+export import :json;
+export import :suite;
@@ -0,0 +1,130 @@
+export module benchmarks:harness;
+import std;
+
+export namespace benchmarks
+{
+	// Keeps the optimiser from discarding a value that a benchmark
+	// computes but never otherwise uses.
+	template<typename T>
+	void do_not_optimize(const T& value) noexcept
+	{
+		static const void* volatile sink = nullptr;
+		sink = std::addressof(value);
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+
+	// A benchmark runs its operation the given number of times. Any setup
+	// (loading assets, building inputs) is done when the benchmark is
+	// created, so that only the operation itself is timed.
+	struct benchmark
+	{
+		std::string name;
+		std::function<void(std::uint64_t iterations)> run;
+		// Anything measured while setting up that belongs next to the
+		// time, such as the quality a lossy operation gives up for it.
+		std::string note;
+	};
+
+	struct result
+	{
+		std::string name;
+		std::uint64_t iterations = 0; // per sample
+		std::size_t samples = 0;
+		// Nanoseconds per iteration.
+		double median_ns = 0;
+		double min_ns = 0;
+		double mean_ns = 0;
+		double stddev_ns = 0;
+		std::string note;
+	};
+
+	struct run_options
+	{
+		// Each sample runs for at least this long, so that the clock's
+		// resolution is negligible against it.
+		std::chrono::nanoseconds min_sample_time = std::chrono::milliseconds{ 20 };
+		std::size_t samples = 15;
+	};
+
+	auto run(const benchmark& bench, const run_options& options) -> result
+	{
+		using clock = std::chrono::steady_clock;
+		auto time = [&](std::uint64_t iterations) -> std::chrono::nanoseconds
+		{
+			auto begin = clock::now();
+			bench.run(iterations);
+			return clock::now() - begin;
+		};
+
+		// Find an iteration count that makes a sample long enough. This
+		// also warms up caches, the branch predictor and lazy statics.
+		auto iterations = std::uint64_t{ 1 };
+		for (auto elapsed = time(iterations); elapsed < options.min_sample_time; elapsed = time(iterations))
+		{
+			auto scale = elapsed.count() > 0
+				? static_cast<double>(options.min_sample_time.count()) / static_cast<double>(elapsed.count()) * 1.2
+				: 10.0;
+			iterations = static_cast<std::uint64_t>(static_cast<double>(iterations) * std::clamp(scale, 2.0, 10.0));
+		}
+
+		auto per_iteration = std::vector<double>(std::max(options.samples, std::size_t{ 1 }));
+		for (auto& sample : per_iteration)
+			sample = static_cast<double>(time(iterations).count()) / static_cast<double>(iterations);
+
+		auto sorted = per_iteration;
+		std::ranges::sort(sorted);
+		auto mean = std::ranges::fold_left(per_iteration, 0.0, std::plus{}) / static_cast<double>(per_iteration.size());
+		auto variance = std::ranges::fold_left(
+			per_iteration,
+			0.0,
+			[mean](double sum, double sample) { return sum + (sample - mean) * (sample - mean); }
+		) / static_cast<double>(per_iteration.size());
+
+		return {
+			.name = bench.name,
+			.iterations = iterations,
+			.samples = per_iteration.size(),
+			.median_ns = sorted[sorted.size() / 2],
+			.min_ns = sorted.front(),
+			.mean_ns = mean,
+			.stddev_ns = std::sqrt(variance),
+			.note = bench.note
+		};
+	}
+
+	struct comparison
+	{
+		std::string name;
+		double baseline_ns = 0;
+		double current_ns = 0;
+		// The relative change in median time, e.g. 0.1 is 10% slower.
+		double change = 0;
+		bool regressed = false;
+	};
+
+	// Compares medians against a baseline. Benchmarks that aren't in the
+	// baseline are skipped, so new benchmarks don't fail a comparison.
+	auto compare(
+		std::span<const result> results,
+		const std::unordered_map<std::string, double>& baseline_median_ns,
+		double threshold
+	) -> std::vector<comparison>
+	{
+		auto comparisons = std::vector<comparison>{};
+		for (auto&& current : results)
+		{
+			auto baseline = baseline_median_ns.find(current.name);
+			if (baseline == baseline_median_ns.end() or baseline->second <= 0)
+				continue;
+			auto change = current.median_ns / baseline->second - 1.0;
+			comparisons.push_back({
+				.name = current.name,
+				.baseline_ns = baseline->second,
+				.current_ns = current.median_ns,
+				.change = change,
+				.regressed = change > threshold
+			});
+		}
+		return comparisons;
+	}
+}
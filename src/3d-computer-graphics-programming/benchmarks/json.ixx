@@ -0,0 +1,254 @@
+export module benchmarks:json;
+import std;
+import :harness;
+
+// Results are written as
+// {
+//   "schema": 1,
+//   "benchmarks": [
+//     { "name": "...", "iterations": 1000, "samples": 15, "median_ns": 12.5, ... },
+//     { "name": "...", ..., "note": "..." },
+//     ...
+//   ]
+// }
+// and read back for comparisons. The reader only needs to understand what
+// the writer produces, but accepts any well-formed JSON so that baselines
+// can be edited by hand or by other tools.
+namespace
+{
+	auto escape(std::string_view text) -> std::string
+	{
+		auto escaped = std::string{};
+		for (char c : text)
+		{
+			switch (c)
+			{
+				case '"': escaped += "\\\""; break;
+				case '\\': escaped += "\\\\"; break;
+				case '\n': escaped += "\\n"; break;
+				case '\t': escaped += "\\t"; break;
+				default: escaped += c; break;
+			}
+		}
+		return escaped;
+	}
+
+	class reader
+	{
+	public:
+		reader(std::string_view text) : m_text{ text } {}
+
+		// Calls on_benchmark(name, median_ns) for each entry of the
+		// top-level "benchmarks" array.
+		void read_results(auto&& on_benchmark)
+		{
+			expect('{');
+			for_each_member(
+				[&](std::string_view key)
+				{
+					if (key != "benchmarks")
+						return skip_value();
+					expect('[');
+					for_each_element([&] { read_benchmark(on_benchmark); });
+				}
+			);
+		}
+
+	private:
+		void read_benchmark(auto&& on_benchmark)
+		{
+			auto name = std::string{};
+			auto median_ns = 0.0;
+			expect('{');
+			for_each_member(
+				[&](std::string_view key)
+				{
+					if (key == "name")
+						name = read_string();
+					else if (key == "median_ns")
+						median_ns = read_number();
+					else
+						skip_value();
+				}
+			);
+			if (name.empty())
+				fail("benchmark without a name");
+			on_benchmark(std::move(name), median_ns);
+		}
+
+		// Expects the opening '{' to have been consumed.
+		void for_each_member(auto&& on_member)
+		{
+			if (consume('}'))
+				return;
+			do
+			{
+				auto key = read_string();
+				expect(':');
+				on_member(key);
+			} while (consume(','));
+			expect('}');
+		}
+
+		// Expects the opening '[' to have been consumed.
+		void for_each_element(auto&& on_element)
+		{
+			if (consume(']'))
+				return;
+			do
+			{
+				on_element();
+			} while (consume(','));
+			expect(']');
+		}
+
+		void skip_value()
+		{
+			switch (peek())
+			{
+				case '{':
+					m_position++;
+					return for_each_member([this](std::string_view) { skip_value(); });
+				case '[':
+					m_position++;
+					return for_each_element([this] { skip_value(); });
+				case '"':
+					read_string();
+					return;
+				case 't':
+					return expect_word("true");
+				case 'f':
+					return expect_word("false");
+				case 'n':
+					return expect_word("null");
+				default:
+					read_number();
+			}
+		}
+
+		auto read_string() -> std::string
+		{
+			expect('"');
+			auto text = std::string{};
+			while (m_position < m_text.size() and m_text[m_position] != '"')
+			{
+				auto c = m_text[m_position++];
+				if (c == '\\' and m_position < m_text.size())
+				{
+					c = m_text[m_position++];
+					switch (c)
+					{
+						case 'n': c = '\n'; break;
+						case 't': c = '\t'; break;
+						case 'r': c = '\r'; break;
+						case 'b': c = '\b'; break;
+						case 'f': c = '\f'; break;
+						case 'u': fail("\\u escapes are not supported");
+						default: break; // '"', '\\' and '/' stand for themselves
+					}
+				}
+				text += c;
+			}
+			expect('"');
+			return text;
+		}
+
+		auto read_number() -> double
+		{
+			skip_whitespace();
+			auto value = 0.0;
+			auto [end, error] = std::from_chars(m_text.data() + m_position, m_text.data() + m_text.size(), value);
+			if (error != std::errc{})
+				fail("expected a number");
+			m_position = static_cast<std::size_t>(end - m_text.data());
+			return value;
+		}
+
+		void expect_word(std::string_view word)
+		{
+			if (not m_text.substr(m_position).starts_with(word))
+				fail(std::format("expected '{}'", word));
+			m_position += word.size();
+		}
+
+		auto peek() -> char
+		{
+			skip_whitespace();
+			if (m_position == m_text.size())
+				fail("unexpected end of input");
+			return m_text[m_position];
+		}
+
+		auto consume(char c) -> bool
+		{
+			if (peek() != c)
+				return false;
+			m_position++;
+			return true;
+		}
+
+		void expect(char c)
+		{
+			if (not consume(c))
+				fail(std::format("expected '{}'", c));
+		}
+
+		void skip_whitespace() noexcept
+		{
+			while (m_position < m_text.size() and std::isspace(static_cast<unsigned char>(m_text[m_position])))
+				m_position++;
+		}
+
+		[[noreturn]] void fail(std::string_view what) const
+		{
+			throw std::runtime_error(std::format("Malformed benchmark results at offset {}: {}", m_position, what));
+		}
+
+		std::string_view m_text;
+		std::size_t m_position = 0;
+	};
+}
+
+export namespace benchmarks
+{
+	void write_json(std::ostream& out, std::span<const result> results)
+	{
+		out << "{\n  \"schema\": 1,\n  \"benchmarks\": [";
+		for (auto i = std::size_t{ 0 }; i < results.size(); i++)
+		{
+			const auto& r = results[i];
+			out << std::format(
+				"{}\n    {{ \"name\": \"{}\", \"iterations\": {}, \"samples\": {}, "
+				"\"median_ns\": {:.3f}, \"min_ns\": {:.3f}, \"mean_ns\": {:.3f}, \"stddev_ns\": {:.3f}{} }}",
+				i == 0 ? "" : ",",
+				escape(r.name),
+				r.iterations,
+				r.samples,
+				r.median_ns,
+				r.min_ns,
+				r.mean_ns,
+				r.stddev_ns,
+				r.note.empty() ? std::string{} : std::format(", \"note\": \"{}\"", escape(r.note))
+			);
+		}
+		out << "\n  ]\n}\n";
+	}
+
+	// Reads the median time of each benchmark from a results file.
+	auto read_baseline(const std::filesystem::path& path) -> std::unordered_map<std::string, double>
+	{
+		auto file = std::ifstream{ path, std::ios::binary };
+		if (not file)
+			throw std::runtime_error(std::format("Failed to open baseline {}", path.string()));
+		auto text = std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+
+		auto baseline = std::unordered_map<std::string, double>{};
+		reader{ text }.read_results(
+			[&](std::string name, double median_ns)
+			{
+				baseline.insert_or_assign(std::move(name), median_ns);
+			}
+		);
+		return baseline;
+	}
+}
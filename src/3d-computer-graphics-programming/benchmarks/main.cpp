@@ -0,0 +1,112 @@
+// Runs the renderer's benchmarks and writes the results as JSON.
+//
+//   benchmarks [--assets <dir>] [--filter <text>] [--output <file>]
+//              [--compare <baseline.json>] [--threshold <fraction>]
+//              [--samples <count>]
+//
+// With --compare, each benchmark's median is checked against the baseline
+// and the process exits with 1 if any is slower by more than the threshold
+// (0.1, i.e. 10%, by default). A baseline is just an earlier --output.
+import std;
+import benchmarks;
+
+namespace
+{
+	struct options
+	{
+		std::filesystem::path assets = "../assets";
+		std::string filter;
+		std::optional<std::filesystem::path> output;
+		std::optional<std::filesystem::path> baseline;
+		double threshold = 0.1;
+		benchmarks::run_options run;
+	};
+
+	auto parse_options(std::span<char*> arguments) -> options
+	{
+		auto result = options{};
+		for (auto i = std::size_t{ 1 }; i < arguments.size(); i++)
+		{
+			auto argument = std::string_view{ arguments[i] };
+			auto value = [&]() -> std::string_view
+			{
+				if (i + 1 == arguments.size())
+					throw std::invalid_argument(std::format("{} requires a value", argument));
+				return arguments[++i];
+			};
+
+			if (argument == "--assets")
+				result.assets = value();
+			else if (argument == "--filter")
+				result.filter = value();
+			else if (argument == "--output")
+				result.output = value();
+			else if (argument == "--compare")
+				result.baseline = value();
+			else if (argument == "--threshold")
+				result.threshold = std::stod(std::string{ value() });
+			else if (argument == "--samples")
+				result.run.samples = std::stoul(std::string{ value() });
+			else
+				throw std::invalid_argument(std::format("Unknown argument {}", argument));
+		}
+		return result;
+	}
+}
+
+auto main(int argc, char* argv[]) -> int
+try
+{
+	auto options = parse_options(std::span{ argv, static_cast<std::size_t>(argc) });
+
+	auto results = std::vector<benchmarks::result>{};
+	for (auto&& bench : benchmarks::make_suite(options.assets))
+	{
+		if (not bench.name.contains(options.filter))
+			continue;
+		auto& result = results.emplace_back(benchmarks::run(bench, options.run));
+		std::println(
+			std::cerr,
+			"{:<48} {:>14.1f} ns  (min {:.1f}, stddev {:.1f}){}{}",
+			result.name,
+			result.median_ns,
+			result.min_ns,
+			result.stddev_ns,
+			result.note.empty() ? "" : "  ",
+			result.note
+		);
+	}
+
+	if (options.output)
+	{
+		auto file = std::ofstream{ *options.output };
+		benchmarks::write_json(file, results);
+	}
+	else
+	{
+		benchmarks::write_json(std::cout, results);
+	}
+
+	if (not options.baseline)
+		return 0;
+
+	auto regressions = 0;
+	for (auto&& comparison : benchmarks::compare(results, benchmarks::read_baseline(*options.baseline), options.threshold))
+	{
+		std::println(
+			std::cerr,
+			"{:<48} {:>+7.1f}%  {}",
+			comparison.name,
+			comparison.change * 100,
+			comparison.regressed ? "REGRESSION" : ""
+		);
+		regressions += comparison.regressed;
+	}
+	std::println(std::cerr, "{} regression(s) beyond {:.0f}%", regressions, options.threshold * 100);
+	return regressions > 0 ? 1 : 0;
+}
+catch (const std::exception& e)
+{
+	std::cerr << "An exception occurred: " << e.what() << std::endl;
+	return 2;
+}
@@ -0,0 +1,559 @@
+export module benchmarks:suite;
+import std;
+import renderer;
+import :harness;
+
+namespace
+{
+	constexpr auto screen_width = std::uint32_t{ 1920 };
+	constexpr auto screen_height = std::uint32_t{ 1080 };
+
+	// Fixed seeds, so that every run measures the same inputs.
+	auto random_screen_triangles(std::size_t count, float max_extent) -> std::vector<renderer::triangle>
+	{
+		auto random = std::mt19937{ 1234 };
+		auto x = std::uniform_real_distribution<float>{ 0.f, static_cast<float>(screen_width) - max_extent };
+		auto y = std::uniform_real_distribution<float>{ 0.f, static_cast<float>(screen_height) - max_extent };
+		auto offset = std::uniform_real_distribution<float>{ 0.f, max_extent };
+		auto depth = std::uniform_real_distribution<float>{ 1.f, 10.f };
+
+		auto triangles = std::vector<renderer::triangle>(count);
+		for (auto& triangle : triangles)
+		{
+			auto origin_x = x(random);
+			auto origin_y = y(random);
+			for (auto& vertex : triangle.vertices)
+				vertex = { origin_x + offset(random), origin_y + offset(random), 0.f, depth(random) };
+			triangle.texcoords[0] = { 0.f, 0.f };
+			triangle.texcoords[1] = { 1.f, 0.f };
+			triangle.texcoords[2] = { 0.f, 1.f };
+		}
+		return triangles;
+	}
+
+	auto fullscreen_triangle() -> renderer::triangle
+	{
+		return {
+			.vertices {
+				{ 0.f, 0.f, 0.f, 1.f },
+				{ static_cast<float>(screen_width - 1), 0.f, 0.f, 1.f },
+				{ 0.f, static_cast<float>(screen_height - 1), 0.f, 1.f }
+			},
+			.texcoords { { 0.f, 0.f }, { 1.f, 0.f }, { 0.f, 1.f } }
+		};
+	}
+
+	auto files_with_extension(const std::filesystem::path& directory, std::string_view extension) -> std::vector<std::filesystem::path>
+	{
+		auto files = std::vector<std::filesystem::path>{};
+		if (not std::filesystem::is_directory(directory))
+			return files;
+		for (auto&& entry : std::filesystem::directory_iterator{ directory })
+			if (entry.is_regular_file() and entry.path().extension() == extension)
+				files.push_back(entry.path());
+		std::ranges::sort(files);
+		return files;
+	}
+
+	auto read_bytes(const std::filesystem::path& path) -> std::vector<unsigned char>
+	{
+		auto file = std::ifstream{ path, std::ios::binary };
+		if (not file)
+			throw std::runtime_error(std::format("Failed to open {}", path.string()));
+		return { std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	}
+
+	void add_math_benchmarks(std::vector<benchmarks::benchmark>& suite)
+	{
+		suite.push_back({
+			"matrix4x4_f/multiply",
+			[a = renderer::matrix4x4_f{ renderer::rotation_matrix{ renderer::y_rotation{ 0.3f } } },
+			 b = renderer::matrix4x4_f{ renderer::translate_matrix{ renderer::vector_4f{ 1.f, 2.f, 3.f } } }]
+			(std::uint64_t iterations) mutable
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					a = a * b;
+					benchmarks::do_not_optimize(a);
+				}
+			}
+		});
+
+		suite.push_back({
+			"matrix4x4_f/multiply_vector/4096",
+			[matrix = renderer::matrix4x4_f{ renderer::rotation_matrix{ renderer::y_rotation{ 0.3f } } },
+			 vertices = std::vector<renderer::vector_4f>(4096, renderer::vector_4f{ 1.f, 2.f, 3.f, 1.f })]
+			(std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					for (auto&& vertex : vertices)
+					{
+						auto transformed = matrix * vertex;
+						benchmarks::do_not_optimize(transformed);
+					}
+				}
+			}
+		});
+
+		suite.push_back({
+			"barycentric_weights/64x64",
+			[](std::uint64_t iterations)
+			{
+				constexpr auto a = renderer::vector_2f{ 0.f, 0.f };
+				constexpr auto b = renderer::vector_2f{ 64.f, 0.f };
+				constexpr auto c = renderer::vector_2f{ 0.f, 64.f };
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					for (auto y = 0; y < 64; y++)
+					{
+						for (auto x = 0; x < 64; x++)
+						{
+							auto weights = renderer::barycentric_weights(a, b, c, renderer::vector_2f{ static_cast<float>(x), static_cast<float>(y) });
+							benchmarks::do_not_optimize(weights);
+						}
+					}
+				}
+			}
+		});
+	}
+
+	void add_raster_benchmarks(std::vector<benchmarks::benchmark>& suite)
+	{
+		auto buffer = std::make_shared<renderer::frame_buffer>(screen_width, screen_height);
+
+		suite.push_back({
+			"draw_line/fullscreen_diagonal",
+			[buffer](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					renderer::draw_line(0, 0, screen_width - 1, screen_height - 1, 0xffffffff, *buffer);
+			}
+		});
+
+		suite.push_back({
+			"draw_line/1000_random",
+			[buffer, triangles = random_screen_triangles(1000, 100.f)](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					for (auto&& [a, b, _] : triangles | std::views::transform(&renderer::triangle::vertices))
+					{
+						renderer::draw_line(
+							static_cast<int>(a.x), static_cast<int>(a.y),
+							static_cast<int>(b.x), static_cast<int>(b.y),
+							0xffffffff,
+							*buffer
+						);
+					}
+				}
+			}
+		});
+
+		suite.push_back({
+			"draw_filled_triangle/fullscreen",
+			[buffer, triangle = fullscreen_triangle()](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					buffer->clear_z_buffer();
+					renderer::draw_filled_triangle(triangle, 0xffadd8e6, *buffer);
+				}
+			}
+		});
+
+		suite.push_back({
+			"draw_filled_triangle/1000_small",
+			[buffer, triangles = random_screen_triangles(1000, 32.f)](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					buffer->clear_z_buffer();
+					for (auto&& triangle : triangles)
+						renderer::draw_filled_triangle(triangle, 0xffadd8e6, *buffer);
+				}
+			}
+		});
+
+		// A procedural checkerboard, so that textured rasterization can be
+		// measured without any assets.
+		auto texture = std::make_shared<std::vector<std::uint32_t>>(256 * 256);
+		for (auto y = 0; y < 256; y++)
+			for (auto x = 0; x < 256; x++)
+				(*texture)[y * 256 + x] = ((x / 32 + y / 32) % 2) ? 0xffffffff : 0xff000000;
+
+		suite.push_back({
+			"draw_textured_triangle/fullscreen",
+			[buffer, texture, triangle = fullscreen_triangle()](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					buffer->clear_z_buffer();
+					renderer::draw_textured_triangle(triangle, texture->data(), 256, 256, *buffer);
+				}
+			}
+		});
+
+		suite.push_back({
+			"draw_textured_triangle/fullscreen_bc1",
+			[buffer, compressed = renderer::block_compressed_texture{ texture->data(), 256, 256 }, triangle = fullscreen_triangle()](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					buffer->clear_z_buffer();
+					auto sampler = renderer::block_cache<>{};
+					sampler.bind(compressed);
+					renderer::draw_textured_triangle(triangle, sampler, *buffer);
+				}
+			}
+		});
+
+		suite.push_back({
+			"draw_textured_triangle/1000_small",
+			[buffer, texture, triangles = random_screen_triangles(1000, 32.f)](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					buffer->clear_z_buffer();
+					for (auto&& triangle : triangles)
+						renderer::draw_textured_triangle(triangle, texture->data(), 256, 256, *buffer);
+				}
+			}
+		});
+
+		suite.push_back({
+			"buffer_2d::fill/color_1920x1080",
+			[buffer](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					buffer->color.fill(0xff000000 + static_cast<std::uint32_t>(i & 0xff));
+					benchmarks::do_not_optimize(buffer->color);
+				}
+			}
+		});
+
+		suite.push_back({
+			"buffer_2d::fill/depth_1920x1080",
+			[buffer](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					buffer->depth.fill(static_cast<float>(i & 0xff));
+					benchmarks::do_not_optimize(buffer->depth);
+				}
+			}
+		});
+	}
+
+	// The depth-tested raster paths and the depth clear, with the depth
+	// plane in TDepth, to set the compact formats against float_depth.
+	// Each is noted with the plane's size at 1920x1080.
+	template<typename TDepth>
+	void add_depth_format_benchmarks(std::vector<benchmarks::benchmark>& suite, std::string_view format_name)
+	{
+		auto buffer = std::make_shared<renderer::frame_buffer_with_depth<TDepth>>(screen_width, screen_height);
+		auto note = std::format("{} depth bytes", buffer->depth.total_elements() * sizeof(typename TDepth::value_type));
+		auto texture = std::make_shared<std::vector<std::uint32_t>>(256 * 256, 0xffadd8e6);
+
+		suite.push_back({
+			std::format("draw_filled_triangle/1000_small/{}", format_name),
+			[buffer, triangles = random_screen_triangles(1000, 32.f)](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					buffer->clear_z_buffer();
+					for (auto&& triangle : triangles)
+						renderer::draw_filled_triangle(triangle, 0xffadd8e6, *buffer);
+				}
+			},
+			note
+		});
+
+		suite.push_back({
+			std::format("draw_textured_triangle/1000_small/{}", format_name),
+			[buffer, texture, triangles = random_screen_triangles(1000, 32.f)](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					buffer->clear_z_buffer();
+					for (auto&& triangle : triangles)
+						renderer::draw_textured_triangle(triangle, texture->data(), 256, 256, *buffer);
+				}
+			},
+			note
+		});
+
+		suite.push_back({
+			std::format("clear_z_buffer/{}", format_name),
+			[buffer](std::uint64_t iterations)
+			{
+				for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+				{
+					buffer->clear_z_buffer();
+					benchmarks::do_not_optimize(buffer->depth);
+				}
+			},
+			note
+		});
+	}
+
+	// A whole frame of each mesh, projected once and rasterized textured
+	// with the depth plane in TDepth.
+	template<typename TDepth>
+	void add_depth_format_frame_benchmarks(std::vector<benchmarks::benchmark>& suite, const std::filesystem::path& assets, std::string_view format_name)
+	{
+		for (auto&& path : files_with_extension(assets, ".obj"))
+		{
+			auto mesh = renderer::mesh{ path };
+			mesh.translation = { 0.f, 0.f, 5.f };
+			mesh.rotation = { 0.3f, 0.6f, 0.f };
+			auto arena = renderer::frame_arena{ 1 << 20 };
+			auto triangles = renderer::project_mesh(
+				mesh,
+				{
+					.projection = renderer::projective_perspective_divide_matrix{
+						renderer::radians{ renderer::degrees{ 60.f } },
+						static_cast<float>(screen_width) / static_cast<float>(screen_height),
+						0.1f,
+						100.f
+					},
+					.width = screen_width,
+					.height = screen_height
+				},
+				arena
+			);
+			auto buffer = std::make_shared<renderer::frame_buffer_with_depth<TDepth>>(screen_width, screen_height);
+
+			suite.push_back({
+				std::format("draw_triangles/{}/{}", path.filename().string(), format_name),
+				[buffer, triangles = renderer::triangle_list{ triangles, std::pmr::new_delete_resource() }](std::uint64_t iterations)
+				{
+					for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					{
+						buffer->clear_color_buffer(0xff000000).clear_z_buffer();
+						renderer::draw_triangles(triangles, renderer::texture::red_brick(), { .rendering_mode = renderer::render_mode::textured }, *buffer);
+					}
+				}
+			});
+		}
+	}
+
+	// Four 960x540 views of each mesh, as the app's inspection layout
+	// renders them, against one: one after another on one thread, and
+	// concurrently on a worker pool, which with a core per view should
+	// take about as long as one view.
+	void add_viewport_benchmarks(std::vector<benchmarks::benchmark>& suite, const std::filesystem::path& assets)
+	{
+		struct shared_state
+		{
+			renderer::mesh mesh;
+			std::vector<renderer::viewport> viewports;
+			renderer::frame_arena_pool arenas{ 1 << 20 };
+			renderer::worker_pool workers{ 3 };
+
+			void render(std::size_t index)
+			{
+				viewports[index].render(mesh, renderer::texture::red_brick(), { .rendering_mode = renderer::render_mode::textured }, arenas.local());
+			}
+		};
+
+		for (auto&& path : files_with_extension(assets, ".obj"))
+		{
+			auto state = std::make_shared<shared_state>();
+			state->mesh = renderer::mesh{ path };
+			state->mesh.translation = { 0.f, 0.f, 4.f };
+			auto field_of_view = renderer::radians{ renderer::degrees{ 60.f } };
+			auto rects = renderer::quad_layout(screen_width, screen_height);
+			state->viewports = {
+				renderer::viewport{ { .position = { 0.f, 0.f, 0.f } }, field_of_view, rects[0] },
+				renderer::viewport{ { .position = { -4.f, 0.f, 4.f }, .yaw = std::numbers::pi_v<float> / 2 }, field_of_view, rects[1] },
+				renderer::viewport{ { .position = { 0.f, 4.f, 4.f }, .pitch = std::numbers::pi_v<float> / 2 }, field_of_view, rects[2] },
+				renderer::viewport{ { .position = { 2.f, 2.f, 1.f }, .yaw = -0.5f, .pitch = 0.4f }, field_of_view, rects[3] }
+			};
+			auto name = path.filename().string();
+
+			suite.push_back({
+				std::format("viewports/{}/1_view", name),
+				[state](std::uint64_t iterations)
+				{
+					for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					{
+						state->arenas.reset();
+						state->render(0);
+					}
+				}
+			});
+
+			suite.push_back({
+				std::format("viewports/{}/4_views_sequential", name),
+				[state](std::uint64_t iterations)
+				{
+					for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					{
+						state->arenas.reset();
+						for (auto index = std::size_t{ 0 }; index < state->viewports.size(); index++)
+							state->render(index);
+					}
+				}
+			});
+
+			suite.push_back({
+				std::format("viewports/{}/4_views_concurrent", name),
+				[state](std::uint64_t iterations)
+				{
+					for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					{
+						state->arenas.reset();
+						state->workers.run(state->viewports.size(), [&](std::size_t index) { state->render(index); });
+					}
+				},
+				std::format("{} hardware threads", std::thread::hardware_concurrency())
+			});
+		}
+	}
+
+	void add_asset_benchmarks(std::vector<benchmarks::benchmark>& suite, const std::filesystem::path& assets)
+	{
+		for (auto&& path : files_with_extension(assets, ".obj"))
+		{
+			suite.push_back({
+				std::format("mesh::from_file/{}", path.filename().string()),
+				[path](std::uint64_t iterations)
+				{
+					for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					{
+						auto mesh = renderer::mesh::from_file(path);
+						benchmarks::do_not_optimize(mesh);
+					}
+				}
+			});
+		}
+
+		// Decoding from memory, so that file I/O isn't measured.
+		for (auto&& path : files_with_extension(assets, ".png"))
+		{
+			suite.push_back({
+				std::format("upng_decode/{}", path.filename().string()),
+				[bytes = read_bytes(path)](std::uint64_t iterations)
+				{
+					for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					{
+						auto png = upng::upng_unique_ptr{ upng_new_from_bytes(bytes.data(), static_cast<unsigned long>(bytes.size())) };
+						if (not png or upng_decode(png.get()) != UPNG_EOK)
+							throw std::runtime_error("Failed to decode PNG");
+						benchmarks::do_not_optimize(upng_get_buffer(png.get()));
+					}
+				}
+			});
+		}
+
+#ifndef RENDERER_PORTABLE
+		// Loading a texture decoded before, from the on-disk cache, to set
+		// against upng_decode. Every page of the pixels is touched, so this
+		// is the cost of mapping and paging them in from the file cache.
+		auto disk_cache = std::make_shared<upng::decoded_texture_cache>(
+			std::filesystem::temp_directory_path() / "3d-computer-graphics-programming" / "benchmark-textures",
+			64 << 20
+		);
+		for (auto&& path : files_with_extension(assets, ".png"))
+		{
+			disk_cache->load(path);
+			suite.push_back({
+				std::format("decoded_texture_cache/warm_load/{}", path.filename().string()),
+				[disk_cache, path](std::uint64_t iterations)
+				{
+					for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					{
+						auto texture = disk_cache->load(path);
+						auto pixels = std::size_t{ texture.width() } * texture.height();
+						auto sum = std::uint32_t{ 0 };
+						for (auto pixel = std::size_t{ 0 }; pixel < pixels; pixel += 4096 / sizeof(std::uint32_t))
+							sum += texture.uint32_buffer()[pixel];
+						benchmarks::do_not_optimize(sum);
+					}
+				}
+			});
+		}
+#endif
+
+		// The block-compressed texture format against the decoded pixels:
+		// what compressing costs at load time, and how a fullscreen
+		// triangle samples each, with the compressed one's quality and
+		// size noted alongside.
+		auto buffer = std::make_shared<renderer::frame_buffer>(screen_width, screen_height);
+		for (auto&& path : files_with_extension(assets, ".png"))
+		{
+			auto name = path.filename().string();
+			auto pixels = std::make_shared<upng::upng_texture>(path);
+			auto compressed = std::make_shared<renderer::block_compressed_texture>(pixels->uint32_buffer(), pixels->width(), pixels->height());
+			auto note = std::format(
+				"PSNR {:.2f} dB, {} -> {} bytes",
+				renderer::peak_signal_to_noise(pixels->uint32_buffer(), *compressed),
+				std::size_t{ pixels->width() } * pixels->height() * sizeof(std::uint32_t),
+				compressed->size_in_bytes()
+			);
+
+			suite.push_back({
+				std::format("bc1_encode/{}", name),
+				[pixels](std::uint64_t iterations)
+				{
+					for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					{
+						auto texture = renderer::block_compressed_texture{ pixels->uint32_buffer(), pixels->width(), pixels->height() };
+						benchmarks::do_not_optimize(texture);
+					}
+				},
+				note
+			});
+
+			suite.push_back({
+				std::format("draw_textured_triangle/fullscreen_argb/{}", name),
+				[buffer, pixels, triangle = fullscreen_triangle()](std::uint64_t iterations)
+				{
+					for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					{
+						buffer->clear_z_buffer();
+						renderer::draw_textured_triangle(triangle, pixels->uint32_buffer(), pixels->width(), pixels->height(), *buffer);
+					}
+				}
+			});
+
+			suite.push_back({
+				std::format("draw_textured_triangle/fullscreen_bc1/{}", name),
+				[buffer, compressed, triangle = fullscreen_triangle()](std::uint64_t iterations)
+				{
+					for (auto i = std::uint64_t{ 0 }; i < iterations; i++)
+					{
+						buffer->clear_z_buffer();
+						auto sampler = renderer::block_cache<>{};
+						sampler.bind(*compressed);
+						renderer::draw_textured_triangle(triangle, sampler, *buffer);
+					}
+				},
+				note
+			});
+		}
+	}
+}
+
+export namespace benchmarks
+{
+	// Every benchmark, in a stable order. Asset benchmarks are created
+	// for each .obj and .png file found in assets.
+	auto make_suite(const std::filesystem::path& assets) -> std::vector<benchmark>
+	{
+		auto suite = std::vector<benchmark>{};
+		add_math_benchmarks(suite);
+		add_raster_benchmarks(suite);
+		add_depth_format_benchmarks<renderer::float_depth>(suite, "float");
+		add_depth_format_benchmarks<renderer::unorm24_depth>(suite, "unorm24");
+		add_depth_format_benchmarks<renderer::unorm16_depth>(suite, "unorm16");
+		add_asset_benchmarks(suite, assets);
+		add_depth_format_frame_benchmarks<renderer::float_depth>(suite, assets, "float");
+		add_depth_format_frame_benchmarks<renderer::unorm24_depth>(suite, assets, "unorm24");
+		add_depth_format_frame_benchmarks<renderer::unorm16_depth>(suite, assets, "unorm16");
+		add_viewport_benchmarks(suite, assets);
+		return suite;
+	}
+}
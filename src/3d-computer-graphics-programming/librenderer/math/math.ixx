@@ -4,3 +4,4 @@ export import :math.matrix;
 export import :math.degreesradians;
 export import :math.vector;
 export import :math.functions;
+export import :math.simd;
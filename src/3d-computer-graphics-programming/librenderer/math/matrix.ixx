@@ -3,6 +3,7 @@ import std;
 import :concepts;
 import :math.vector;
 import :math.degreesradians;
+import :math.simd;
 
 export namespace renderer
 {
@@ -28,6 +29,9 @@ export namespace renderer
 	struct matrix
 	{
 		static_assert(VRows > 0 and VColumns > 0, "Matrix must have at least one row and one column.");
+
+		// 4x4 float matrices have SSE paths, which need their rows 16-byte aligned.
+		static constexpr bool is_simd_4x4 = std::same_as<TArithmetic, float> and VRows == 4 and VColumns == 4;
 		constexpr matrix() = default;
 
 		constexpr matrix(std::convertible_to<TArithmetic> auto...values)
@@ -73,6 +77,14 @@ export namespace renderer
 
 		constexpr auto operator*(this matrix self, const matrix& other) noexcept -> matrix
 		{
+			if constexpr (is_simd_4x4)
+			{
+				if not consteval
+				{
+					simd::multiply_4x4(&self.Values[0][0], &other.Values[0][0], &self.Values[0][0]);
+					return self;
+				}
+			}
 			matrix result{};
 			for (std::uint32_t r = 0; r < VRows; ++r)
 				for (std::uint32_t c = 0; c < VColumns; ++c)
@@ -93,7 +105,7 @@ export namespace renderer
 		constexpr auto operator==(const matrix& other) const noexcept -> bool = default;
 		constexpr auto operator!=(const matrix& other) const noexcept -> bool = default;
 
-		TArithmetic Values[VRows][VColumns]{};
+		alignas(is_simd_4x4 ? 16 : alignof(TArithmetic)) TArithmetic Values[VRows][VColumns]{};
 	};
 
 	using matrix4x4_f = matrix<float, 4, 4>;
@@ -239,6 +251,12 @@ export namespace renderer
 	constexpr auto operator*(const matrix4x4_f& self, const vector_4f& other)
 		noexcept -> vector_4f
 	{
+		if not consteval
+		{
+			auto result = vector_4f{};
+			simd::transform(&self.Values[0][0], &other.x, &result.x);
+			return result;
+		}
 		return vector_4f{
 			.x = self[0][0] * other.x + self[0][1] * other.y + self[0][2] * other.z + self[0][3] * other.w,
 			.y = self[1][0] * other.x + self[1][1] * other.y + self[1][2] * other.z + self[1][3] * other.w,
@@ -247,6 +265,18 @@ export namespace renderer
 		};
 	}
 
+	// Transforms every vector in in and writes the results to out, which
+	// must be at least as long. in and out may be the same span.
+	constexpr void transform(const matrix4x4_f& self, std::span<const vector_4f> in, std::span<vector_4f> out) noexcept
+	{
+		if not consteval
+		{
+			return simd::transform_batch(&self.Values[0][0], &in.data()->x, &out.data()->x, std::min(in.size(), out.size()));
+		}
+		for (auto i = std::size_t{ 0 }; i < std::min(in.size(), out.size()); i++)
+			out[i] = self * in[i];
+	}
+
 	[[deprecated("Use the projection_matrix type.")]]
 	auto project(float fov_factor, vector_4f vec) -> vector_4f
 	{
@@ -363,4 +393,18 @@ namespace
 			return true;
 		}(),
 		"Matrix scaling did not produce the expected results.");
+
+	static_assert(
+		[] -> bool
+		{
+			auto translation = renderer::matrix4x4_f{ renderer::translate_matrix{ renderer::vector_3f{ 1, 2, 3 } } };
+			auto scale = renderer::matrix4x4_f{ renderer::scale_matrix{ renderer::vector_3f{ 2, 2, 2 } } };
+			auto product = translation * scale;
+			auto vectors = std::array{ renderer::vector_4f{ 1, 1, 1, 1 }, renderer::vector_4f{ 0, 0, 0, 1 } };
+			renderer::transform(product, vectors, vectors);
+			return product * renderer::vector_4f{ 1, 1, 1, 1 } == renderer::vector_4f{ 3, 4, 5, 1 }
+				and vectors[0] == renderer::vector_4f{ 3, 4, 5, 1 }
+				and vectors[1] == renderer::vector_4f{ 1, 2, 3, 1 };
+		}(),
+		"Matrix products and batch transforms are expected to match the scalar definitions.");
 }
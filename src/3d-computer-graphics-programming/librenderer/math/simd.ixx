@@ -0,0 +1,199 @@
+module;
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+
+// GCC and Clang only accept intrinsics beyond the target's baseline in
+// functions that ask for them; MSVC accepts them anywhere.
+#ifdef _MSC_VER
+#define RENDERER_TARGET(isa)
+#else
+#define RENDERER_TARGET(isa) [[gnu::target(isa)]]
+#endif
+
+export module renderer:math.simd;
+import std;
+
+// SSE kernels for the 4-component float maths in :math.vector and
+// :math.matrix. They work on raw floats so that the partitions that call
+// them don't need to see any intrinsics; vectors are passed as a pointer
+// to 4 floats and matrices as a pointer to 16 row-major floats, all
+// 16-byte aligned. Callers use them only outside constant evaluation
+// and keep the scalar code for it.
+namespace
+{
+	// ECX of CPUID leaf 1, which flags SSE3 onwards.
+	auto cpuid_features() noexcept -> unsigned
+	{
+#ifdef _MSC_VER
+		int info[4]{};
+		__cpuid(info, 1);
+		return static_cast<unsigned>(info[2]);
+#else
+		unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+		return __get_cpuid(1, &eax, &ebx, &ecx, &edx) ? ecx : 0;
+#endif
+	}
+
+	// Only called once CPUID has said that XGETBV is there.
+	RENDERER_TARGET("xsave") auto enabled_register_state() noexcept -> std::uint64_t
+	{
+		return _xgetbv(0);
+	}
+
+	auto has_avx() noexcept -> bool
+	{
+		static const bool value =
+			[] static
+			{
+				constexpr auto osxsave = 1u << 27;
+				constexpr auto avx = 1u << 28;
+				if ((cpuid_features() & (osxsave | avx)) != (osxsave | avx))
+					return false;
+				// The OS must also save the upper halves of the YMM registers.
+				return (enabled_register_state() & 0x6) == 0x6;
+			}();
+		return value;
+	}
+
+	// Sums the x, y and z lanes into every lane; w is ignored.
+	auto horizontal_sum3(__m128 v) noexcept -> __m128
+	{
+		auto x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+		auto y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+		auto z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+		return _mm_add_ps(_mm_add_ps(x, y), z);
+	}
+
+	// Row-major matrix times column vector: the result is the sum of the
+	// matrix's columns scaled by the vector's components, so the columns
+	// are what we load.
+	struct columns
+	{
+		__m128 c0, c1, c2, c3;
+
+		columns(const float* matrix) noexcept
+			: c0{ _mm_load_ps(matrix) },
+			  c1{ _mm_load_ps(matrix + 4) },
+			  c2{ _mm_load_ps(matrix + 8) },
+			  c3{ _mm_load_ps(matrix + 12) }
+		{
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		}
+
+		auto transform(__m128 v) const noexcept -> __m128
+		{
+			auto result = _mm_mul_ps(c0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+			result = _mm_add_ps(result, _mm_mul_ps(c1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+			result = _mm_add_ps(result, _mm_mul_ps(c2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+			return _mm_add_ps(result, _mm_mul_ps(c3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+		}
+	};
+
+	// Two vectors per iteration in the lower and upper halves of a YMM
+	// register, with the same columns broadcast into both halves.
+	RENDERER_TARGET("avx") void transform_batch_avx(const float* matrix, const float* in, float* out, std::size_t count) noexcept
+	{
+		auto m = columns{ matrix };
+		auto c0 = _mm256_set_m128(m.c0, m.c0);
+		auto c1 = _mm256_set_m128(m.c1, m.c1);
+		auto c2 = _mm256_set_m128(m.c2, m.c2);
+		auto c3 = _mm256_set_m128(m.c3, m.c3);
+		auto i = std::size_t{ 0 };
+		for (; i + 2 <= count; i += 2)
+		{
+			auto v = _mm256_loadu_ps(in + i * 4);
+			auto result = _mm256_mul_ps(c0, _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)));
+			result = _mm256_add_ps(result, _mm256_mul_ps(c1, _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1))));
+			result = _mm256_add_ps(result, _mm256_mul_ps(c2, _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2))));
+			result = _mm256_add_ps(result, _mm256_mul_ps(c3, _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm256_storeu_ps(out + i * 4, result);
+		}
+		// Leave the AVX state clean before any SSE code runs.
+		_mm256_zeroupper();
+		if (i < count)
+			_mm_store_ps(out + i * 4, m.transform(_mm_load_ps(in + i * 4)));
+	}
+}
+
+export namespace renderer::simd
+{
+	// out = a * b, all 4x4 row-major. out may alias a or b.
+	void multiply_4x4(const float* a, const float* b, float* out) noexcept
+	{
+		auto b0 = _mm_load_ps(b);
+		auto b1 = _mm_load_ps(b + 4);
+		auto b2 = _mm_load_ps(b + 8);
+		auto b3 = _mm_load_ps(b + 12);
+		__m128 rows[4];
+		// Each row of the result is the rows of b weighted by a row of a.
+		for (int r = 0; r < 4; r++)
+		{
+			auto row = _mm_mul_ps(_mm_set1_ps(a[r * 4]), b0);
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[r * 4 + 1]), b1));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[r * 4 + 2]), b2));
+			rows[r] = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[r * 4 + 3]), b3));
+		}
+		for (int r = 0; r < 4; r++)
+			_mm_store_ps(out + r * 4, rows[r]);
+	}
+
+	// out = matrix * v. out may alias v.
+	void transform(const float* matrix, const float* v, float* out) noexcept
+	{
+		_mm_store_ps(out, columns{ matrix }.transform(_mm_load_ps(v)));
+	}
+
+	// out[i] = matrix * in[i] for count vectors. out may alias in.
+	void transform_batch(const float* matrix, const float* in, float* out, std::size_t count) noexcept
+	{
+		if (has_avx())
+			return transform_batch_avx(matrix, in, out, count);
+		auto m = columns{ matrix };
+		for (auto i = std::size_t{ 0 }; i < count; i++)
+			_mm_store_ps(out + i * 4, m.transform(_mm_load_ps(in + i * 4)));
+	}
+
+	// The dot product of the x, y and z components.
+	auto dot3(const float* a, const float* b) noexcept -> float
+	{
+		return _mm_cvtss_f32(horizontal_sum3(_mm_mul_ps(_mm_load_ps(a), _mm_load_ps(b))));
+	}
+
+	// out.xyz = a.xyz x b.xyz and out.w = w.
+	void cross3(const float* a, const float* b, float w, float* out) noexcept
+	{
+		auto va = _mm_load_ps(a);
+		auto vb = _mm_load_ps(b);
+		auto a_yzx = _mm_shuffle_ps(va, va, _MM_SHUFFLE(3, 0, 2, 1));
+		auto b_yzx = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(3, 0, 2, 1));
+		// a x b = (a * b.yzx - a.yzx * b).yzx
+		auto c = _mm_sub_ps(_mm_mul_ps(va, b_yzx), _mm_mul_ps(a_yzx, vb));
+		c = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+		alignas(16) float result[4];
+		_mm_store_ps(result, c);
+		result[3] = w;
+		_mm_store_ps(out, _mm_load_ps(result));
+	}
+
+	// Scales v.xyz to unit length, leaving w as it is. The reciprocal
+	// square root estimate is refined with one Newton-Raphson step, which
+	// gets it to within a couple of ulps of 1/sqrt.
+	void normalise3(float* v) noexcept
+	{
+		auto vector = _mm_load_ps(v);
+		auto length_squared = horizontal_sum3(_mm_mul_ps(vector, vector));
+		auto estimate = _mm_rsqrt_ps(length_squared);
+		// y' = y * (1.5 - 0.5 * x * y * y)
+		auto half_x_y_y = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), length_squared), _mm_mul_ps(estimate, estimate));
+		auto reciprocal = _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), half_x_y_y));
+		auto scaled = _mm_mul_ps(vector, reciprocal);
+		// Keep the original w: blend lanes x, y, z from scaled with w from vector.
+		auto w = _mm_shuffle_ps(scaled, vector, _MM_SHUFFLE(3, 3, 2, 2)); // z, z, w, w
+		_mm_store_ps(v, _mm_shuffle_ps(scaled, w, _MM_SHUFFLE(2, 0, 1, 0)));
+	}
+}
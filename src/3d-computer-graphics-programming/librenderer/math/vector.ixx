@@ -1,9 +1,12 @@
 export module renderer:math.vector;
 import std;
 import :math.functions;
+import :math.simd;
 
 export namespace renderer
 {
+	struct vector_4f;
+
 	template<typename T>
 	concept vector1_like = requires(T v) { { v.x } -> std::convertible_to<float>; };
 	template<typename T>
@@ -45,6 +48,13 @@ export namespace renderer
 	{
 		static_assert(dot_product_defined<decltype(a), decltype(b)>, "a and b must be vectors of matching dimension.");
 
+		if constexpr (std::same_as<T, vector_4f> and std::same_as<V, vector_4f>)
+		{
+			if not consteval
+			{
+				return simd::dot3(&a.x, &b.x);
+			}
+		}
 		if constexpr (vector3_like<T> or vector4_like<T>)
 			return a.x * b.x + a.y * b.y + a.z * b.z;
 		if constexpr (vector2_like<T>)
@@ -67,6 +77,14 @@ export namespace renderer
 
 	constexpr void normalise(vector_like auto& v) noexcept
 	{
+		if constexpr (std::same_as<std::remove_cvref_t<decltype(v)>, vector_4f>)
+		{
+			if not consteval
+			{
+				simd::normalise3(&v.x);
+				return;
+			}
+		}
 		float multiplicand = 1.f / magnitude(v);
 		if constexpr (requires { v.x; })
 			v.x *= multiplicand;
@@ -126,6 +144,15 @@ export namespace renderer
 	constexpr auto cross_product(vector3_like auto a, vector3_like auto b) 
 		noexcept -> std::remove_cvref_t<decltype(a)>
 	{
+		if constexpr (std::same_as<decltype(a), vector_4f> and std::same_as<decltype(b), vector_4f>)
+		{
+			if not consteval
+			{
+				auto result = vector_4f{};
+				simd::cross3(&a.x, &b.x, result.w, &result.x);
+				return result;
+			}
+		}
 		return {
 			.x = a.y * b.z - a.z * b.y,
 			.y = a.z * b.x - a.x * b.z,
@@ -134,8 +161,6 @@ export namespace renderer
 	}
 
 	// Forward declaration of vector_4f for conversion operator.
-	struct vector_4f;
-
 	struct vector_2f
 	{
 		float x = 0;
@@ -150,7 +175,8 @@ export namespace renderer
 		constexpr operator vector_4f(this const vector_3f& self) noexcept;
 	};
 
-	struct vector_4f
+	// Aligned so that it can be loaded into a single SSE register.
+	struct alignas(16) vector_4f
 	{
 		float x = 0;
 		float y = 0;
@@ -1,7 +1,12 @@
+// Defining RENDERER_PORTABLE leaves out the partitions that need SDL or
+// Win32, and everything built on them, for builds on other platforms such
+// as the benchmarks' CMake build.
 export module renderer;
 export import :concepts;
+#ifndef RENDERER_PORTABLE
 export import :win32;
 export import :sdl;
+#endif
 export import :upng;
 export import :math;
 export import :raii;
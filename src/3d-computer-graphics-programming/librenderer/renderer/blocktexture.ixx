@@ -0,0 +1,317 @@
+export module renderer:renderer.blocktexture;
+import std;
+import :renderer.pixelformat;
+
+// A BC1-style block-compressed texture format. The texture is split into
+// 4x4 blocks, each stored as two RGB565 endpoint colours and a 2-bit
+// index per pixel into a palette of the endpoints and the two colours a
+// third and two thirds of the way between them: 8 bytes for 16 pixels,
+// an eighth of the 32-bit pixels upng gives us. Alpha isn't kept; every
+// texel decodes as opaque.
+//
+// Blocks are compressed once, when a texture is loaded. Decoding a block
+// is a handful of shifts and adds, and a block_cache keeps the last few
+// decoded blocks so that neighbouring texels, which a triangle mostly
+// samples, don't decode the same block over and over.
+namespace
+{
+	struct rgb
+	{
+		std::int32_t r = 0;
+		std::int32_t g = 0;
+		std::int32_t b = 0;
+	};
+
+	constexpr auto unpack(std::uint32_t argb) noexcept -> rgb
+	{
+		return {
+			static_cast<std::int32_t>((argb >> 16) & 0xff),
+			static_cast<std::int32_t>((argb >> 8) & 0xff),
+			static_cast<std::int32_t>(argb & 0xff)
+		};
+	}
+
+	constexpr auto to_565(rgb c) noexcept -> std::uint16_t
+	{
+		// Round to the nearest representable value rather than truncate.
+		auto r = (c.r * 31 + 127) / 255;
+		auto g = (c.g * 63 + 127) / 255;
+		auto b = (c.b * 31 + 127) / 255;
+		return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	constexpr auto from_565(std::uint16_t c) noexcept -> rgb
+	{
+		auto r = (c >> 11) & 0x1f;
+		auto g = (c >> 5) & 0x3f;
+		auto b = c & 0x1f;
+		// Replicate the high bits into the low ones so that 0x1f becomes 0xff.
+		return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+	}
+
+	constexpr auto distance_squared(rgb a, rgb b) noexcept -> std::int32_t
+	{
+		return (a.r - b.r) * (a.r - b.r) + (a.g - b.g) * (a.g - b.g) + (a.b - b.b) * (a.b - b.b);
+	}
+
+	constexpr auto blend_third(rgb a, rgb b) noexcept -> rgb
+	{
+		return { (2 * a.r + b.r) / 3, (2 * a.g + b.g) / 3, (2 * a.b + b.b) / 3 };
+	}
+}
+
+export namespace renderer
+{
+	struct bc1_block
+	{
+		std::uint16_t color0 = 0;
+		std::uint16_t color1 = 0;
+		// Pixel i of the block, in row-major order, is bits 2i and 2i + 1.
+		std::uint32_t indices = 0;
+	};
+	static_assert(sizeof(bc1_block) == 8);
+
+	// The four colours a block's indices select from, as 0xAARRGGBB.
+	constexpr auto block_palette(const bc1_block& block) noexcept -> std::array<std::uint32_t, 4>
+	{
+		auto c0 = from_565(block.color0);
+		auto c1 = from_565(block.color1);
+		auto c2 = blend_third(c0, c1);
+		auto c3 = blend_third(c1, c0);
+		auto pack = [](rgb c)
+		{
+			return pack_argb(0xff, static_cast<std::uint32_t>(c.r), static_cast<std::uint32_t>(c.g), static_cast<std::uint32_t>(c.b));
+		};
+		return { pack(c0), pack(c1), pack(c2), pack(c3) };
+	}
+
+	constexpr void decode_block(const bc1_block& block, std::span<std::uint32_t, 16> out) noexcept
+	{
+		auto palette = block_palette(block);
+		for (auto i = 0u; i < 16; i++)
+			out[i] = palette[(block.indices >> (2 * i)) & 3];
+	}
+
+	// Uses the two most different colours in the block as the endpoints,
+	// which puts the palette along the block's main axis of colour
+	// without having to find it, then gives each pixel the nearest
+	// palette colour. Trying all 120 pairs is slow next to decoding, but
+	// it's only done once per block, at load time.
+	constexpr auto encode_block(std::span<const std::uint32_t, 16> pixels) noexcept -> bc1_block
+	{
+		auto first = unpack(pixels[0]);
+		auto last = first;
+		auto max_distance = 0;
+		for (auto i = 0u; i < 16; i++)
+		{
+			for (auto j = i + 1; j < 16; j++)
+			{
+				auto a = unpack(pixels[i]);
+				auto b = unpack(pixels[j]);
+				if (auto distance = distance_squared(a, b); distance > max_distance)
+				{
+					max_distance = distance;
+					first = a;
+					last = b;
+				}
+			}
+		}
+
+		auto block = bc1_block{ .color0 = to_565(last), .color1 = to_565(first) };
+		if (block.color0 == block.color1)
+			return block;
+
+		auto palette = std::array<rgb, 4>{};
+		for (auto i = 0u; auto color : block_palette(block))
+			palette[i++] = unpack(color);
+		for (auto i = 0u; i < 16; i++)
+		{
+			auto c = unpack(pixels[i]);
+			auto best = 0u;
+			for (auto candidate = 1u; candidate < 4; candidate++)
+				if (distance_squared(c, palette[candidate]) < distance_squared(c, palette[best]))
+					best = candidate;
+			block.indices |= best << (2 * i);
+		}
+		return block;
+	}
+
+	class block_compressed_texture
+	{
+	public:
+		constexpr block_compressed_texture() = default;
+
+		// Compresses row-major 0xAARRGGBB pixels. Blocks that hang over the
+		// right or bottom edge repeat the edge pixels.
+		constexpr block_compressed_texture(const std::uint32_t* pixels, std::uint32_t width, std::uint32_t height)
+			: m_width{ width },
+			  m_height{ height },
+			  m_blocks_per_row{ (width + 3) / 4 },
+			  m_blocks(std::size_t{ (width + 3) / 4 } * ((height + 3) / 4))
+		{
+			auto block_pixels = std::array<std::uint32_t, 16>{};
+			for (auto block_y = 0u; block_y < (height + 3) / 4; block_y++)
+			{
+				for (auto block_x = 0u; block_x < m_blocks_per_row; block_x++)
+				{
+					for (auto y = 0u; y < 4; y++)
+					{
+						auto row = std::min(block_y * 4 + y, height - 1);
+						for (auto x = 0u; x < 4; x++)
+							block_pixels[y * 4 + x] = pixels[std::size_t{ row } * width + std::min(block_x * 4 + x, width - 1)];
+					}
+					m_blocks[std::size_t{ block_y } * m_blocks_per_row + block_x] = encode_block(block_pixels);
+				}
+			}
+		}
+
+		constexpr auto width() const noexcept -> std::uint32_t { return m_width; }
+		constexpr auto height() const noexcept -> std::uint32_t { return m_height; }
+		constexpr auto size_in_bytes() const noexcept -> std::size_t { return m_blocks.size() * sizeof(bc1_block); }
+
+		constexpr auto block(std::uint32_t block_x, std::uint32_t block_y) const noexcept -> const bc1_block&
+		{
+			return m_blocks[std::size_t{ block_y } * m_blocks_per_row + block_x];
+		}
+
+		// Decodes a single texel without going through a cache.
+		constexpr auto texel(std::uint32_t x, std::uint32_t y) const noexcept -> std::uint32_t
+		{
+			const auto& b = block(x >> 2, y >> 2);
+			auto index = (b.indices >> (2 * (((y & 3) << 2) | (x & 3)))) & 3;
+			return block_palette(b)[index];
+		}
+
+	private:
+		std::uint32_t m_width = 0;
+		std::uint32_t m_height = 0;
+		std::uint32_t m_blocks_per_row = 0;
+		std::vector<bc1_block> m_blocks;
+	};
+
+	// A small direct-mapped cache of decoded blocks, meant to live on the
+	// stack of whatever is rasterizing, one per thread. Slots are chosen by
+	// the low bits of the block's column and row, so the VSide x VSide
+	// blocks around any texel never evict each other. With the default
+	// 8x8 that covers 32x32 texels in 4KB of decoded pixels, about what a
+	// triangle of a typical mesh touches, and fits comfortably in L1.
+	template<std::uint32_t VSide = 8>
+	class block_cache
+	{
+		static_assert(std::has_single_bit(VSide), "The cache's side must be a power of two.");
+	public:
+		constexpr block_cache() noexcept = default;
+
+		// The texture to sample. Changing it invalidates the cache.
+		constexpr void bind(const block_compressed_texture& texture) noexcept
+		{
+			if (&texture == m_texture)
+				return;
+			m_texture = &texture;
+			m_tags.fill(invalid_tag);
+		}
+
+		constexpr auto width() const noexcept -> std::size_t { return m_texture->width(); }
+		constexpr auto height() const noexcept -> std::size_t { return m_texture->height(); }
+
+		constexpr auto sample(std::uint32_t x, std::uint32_t y) noexcept -> std::uint32_t
+		{
+			auto block_x = x >> 2;
+			auto block_y = y >> 2;
+			auto slot = ((block_y & (VSide - 1)) * VSide) + (block_x & (VSide - 1));
+			auto tag = (block_y << 16) | block_x;
+			if (m_tags[slot] != tag)
+			{
+				m_tags[slot] = tag;
+				decode_block(m_texture->block(block_x, block_y), std::span<std::uint32_t, 16>{ m_pixels[slot] });
+				m_misses++;
+			}
+			else
+			{
+				m_hits++;
+			}
+			return m_pixels[slot][((y & 3) << 2) | (x & 3)];
+		}
+
+		constexpr auto hits() const noexcept -> std::uint64_t { return m_hits; }
+		constexpr auto misses() const noexcept -> std::uint64_t { return m_misses; }
+
+	private:
+		static constexpr auto invalid_tag = std::numeric_limits<std::uint32_t>::max();
+
+		const block_compressed_texture* m_texture = nullptr;
+		std::array<std::uint32_t, VSide * VSide> m_tags{};
+		alignas(64) std::array<std::array<std::uint32_t, 16>, VSide * VSide> m_pixels{};
+		std::uint64_t m_hits = 0;
+		std::uint64_t m_misses = 0;
+	};
+
+	// Peak signal-to-noise ratio of a compressed texture against the
+	// pixels it was made from, over the RGB channels, in dB. Higher is
+	// better; above about 35dB differences are hard to see.
+	auto peak_signal_to_noise(const std::uint32_t* pixels, const block_compressed_texture& compressed) -> double
+	{
+		auto squared_error = 0.0;
+		for (auto y = 0u; y < compressed.height(); y++)
+		{
+			for (auto x = 0u; x < compressed.width(); x++)
+			{
+				auto a = unpack(pixels[std::size_t{ y } * compressed.width() + x]);
+				auto b = unpack(compressed.texel(x, y));
+				squared_error += distance_squared(a, b);
+			}
+		}
+		auto mean = squared_error / (3.0 * compressed.width() * compressed.height());
+		return mean == 0 ? std::numeric_limits<double>::infinity() : 10.0 * std::log10(255.0 * 255.0 / mean);
+	}
+}
+
+static_assert(
+	[]{
+		// A block of two colours that are exactly representable in 565
+		// round-trips losslessly.
+		auto pixels = std::array<std::uint32_t, 16>{};
+		for (auto i = 0u; i < 16; i++)
+			pixels[i] = i % 3 == 0 ? 0xffff0000 : 0xff0000ff;
+		auto decoded = std::array<std::uint32_t, 16>{};
+		renderer::decode_block(renderer::encode_block(pixels), decoded);
+		return decoded == pixels;
+	}(),
+	"A two-colour block is expected to decode to exactly its input."
+);
+
+static_assert(
+	[]{
+		// A 6x5 diagonal gradient, so the edge blocks are padded, sampled
+		// directly and through the cache. Its colours lie on a line, which
+		// four evenly spaced palette colours can follow closely.
+		auto pixels = std::array<std::uint32_t, 30>{};
+		for (auto y = 0u; y < 5; y++)
+			for (auto x = 0u; x < 6; x++)
+				pixels[y * 6 + x] = renderer::pack_argb(0xff, (x + y) * 24, (x + y) * 12, 128);
+		auto texture = renderer::block_compressed_texture{ pixels.data(), 6, 5 };
+		auto cache = renderer::block_cache<>{};
+		cache.bind(texture);
+		auto max_error = 0;
+		for (auto y = 0u; y < 5; y++)
+		{
+			for (auto x = 0u; x < 6; x++)
+			{
+				if (cache.sample(x, y) != texture.texel(x, y))
+					return false;
+				auto original = pixels[y * 6 + x];
+				auto decoded = texture.texel(x, y);
+				for (auto shift : { 0u, 8u, 16u })
+				{
+					auto error = static_cast<int>((original >> shift) & 0xff) - static_cast<int>((decoded >> shift) & 0xff);
+					max_error = std::max(max_error, error < 0 ? -error : error);
+				}
+			}
+		}
+		// 4 blocks decoded once each, the rest of the 30 samples are hits.
+		return texture.size_in_bytes() == 4 * 8
+			and cache.misses() == 4 and cache.hits() == 26
+			and max_error <= 24;
+	}(),
+	"Compressed textures are expected to approximate their input, and the cache to decode each block once."
+);
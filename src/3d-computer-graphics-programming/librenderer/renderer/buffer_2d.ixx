@@ -2,50 +2,217 @@ export module renderer:renderer.buffer_2d;
 import std;
 import :util;
 import :concepts;
-import :sdl;
+import :renderer.depthformat;
 
 export namespace renderer
 {
+	// Layout policies decide how a buffer_2d maps a (row, column) pair
+	// onto its storage and how much storage it needs. The stride is
+	// layout-specific: elements per row for the linear layouts and tiles
+	// per row for the tiled ones.
+
+	// Plain row-major storage. Rows are padded out to a whole number of
+	// cache lines, so every row starts 64-byte aligned and row-wise SIMD
+	// stores never split a line at the start of a row.
+	struct linear_layout
+	{
+		static constexpr std::size_t alignment = 64;
+		static constexpr bool is_linear = true;
+		static constexpr bool is_tiled = false;
+		static constexpr bool is_checked = false;
+
+		template<typename T>
+		static constexpr auto stride(std::uint32_t width) noexcept -> std::uint32_t
+		{
+			constexpr auto elements_per_line = static_cast<std::uint32_t>(alignment / sizeof(T));
+			return (width + elements_per_line - 1) / elements_per_line * elements_per_line;
+		}
+
+		static constexpr auto size(std::uint32_t stride, std::uint32_t height) noexcept -> std::size_t
+		{
+			return std::size_t{ stride } * height;
+		}
+
+		static constexpr auto index(std::uint32_t row, std::uint32_t column, std::uint32_t stride) noexcept -> std::size_t
+		{
+			return std::size_t{ row } * stride + column;
+		}
+	};
+
+	// Same as linear_layout, but element access is bounds checked and
+	// throws. Used by default in debug builds.
+	struct checked_layout : linear_layout
+	{
+		static constexpr bool is_checked = true;
+	};
+
+	// Storage is split into square tiles that are each contiguous in
+	// memory, with the tiles themselves in row-major order and the pixels
+	// inside a tile row-major too. With the default 8x8 tile, a tile is
+	// 256 bytes for both a colour and a 1/w depth plane, so the colour
+	// and depth of one raster tile together are eight cache lines and
+	// stay resident in L1 while a triangle is rasterized over it.
+	template<std::uint32_t VTileSize = 8>
+	struct tiled_layout
+	{
+		static_assert(std::has_single_bit(VTileSize), "Tile size must be a power of two.");
+
+		static constexpr std::size_t alignment = 64;
+		static constexpr bool is_linear = false;
+		static constexpr bool is_tiled = true;
+		static constexpr bool is_checked = false;
+		// Whether each row of a tile is contiguous, which lets a resolve
+		// copy tile rows instead of single pixels.
+		static constexpr bool has_linear_tile_rows = true;
+		static constexpr std::uint32_t tile_size = VTileSize;
+		static constexpr std::uint32_t tile_elements = VTileSize * VTileSize;
+		static constexpr std::uint32_t tile_shift = std::countr_zero(VTileSize);
+		static constexpr std::uint32_t tile_mask = VTileSize - 1;
+
+		template<typename T>
+		static constexpr auto stride(std::uint32_t width) noexcept -> std::uint32_t
+		{
+			return (width + tile_mask) >> tile_shift;
+		}
+
+		static constexpr auto size(std::uint32_t stride, std::uint32_t height) noexcept -> std::size_t
+		{
+			return std::size_t{ stride } * ((height + tile_mask) >> tile_shift) * tile_elements;
+		}
+
+		static constexpr auto tile_offset(std::uint32_t tile_row, std::uint32_t tile_column, std::uint32_t stride) noexcept -> std::size_t
+		{
+			return (std::size_t{ tile_row } * stride + tile_column) * tile_elements;
+		}
+
+		static constexpr auto in_tile_index(std::uint32_t row, std::uint32_t column) noexcept -> std::uint32_t
+		{
+			return (row << tile_shift) | column;
+		}
+
+		static constexpr auto index(std::uint32_t row, std::uint32_t column, std::uint32_t stride) noexcept -> std::size_t
+		{
+			return tile_offset(row >> tile_shift, column >> tile_shift, stride)
+				+ in_tile_index(row & tile_mask, column & tile_mask);
+		}
+	};
+
+	// Tiled like tiled_layout, but the pixels inside a tile are stored in
+	// Morton (Z) order by interleaving the bits of the column and row, so
+	// that pixels that are close in 2D are also close in memory regardless
+	// of the direction a triangle is walked in.
+	template<std::uint32_t VTileSize = 8>
+	struct morton_layout : tiled_layout<VTileSize>
+	{
+		using base = tiled_layout<VTileSize>;
+		static constexpr bool has_linear_tile_rows = false;
+
+		static constexpr auto in_tile_index(std::uint32_t row, std::uint32_t column) noexcept -> std::uint32_t
+		{
+			return spread_bits(column) | (spread_bits(row) << 1);
+		}
+
+		static constexpr auto index(std::uint32_t row, std::uint32_t column, std::uint32_t stride) noexcept -> std::size_t
+		{
+			return base::tile_offset(row >> base::tile_shift, column >> base::tile_shift, stride)
+				+ in_tile_index(row & base::tile_mask, column & base::tile_mask);
+		}
+
+	private:
+		// Inserts a zero bit between each of the low 16 bits of value.
+		static constexpr auto spread_bits(std::uint32_t value) noexcept -> std::uint32_t
+		{
+			value &= 0x0000ffff;
+			value = (value | (value << 8)) & 0x00ff00ff;
+			value = (value | (value << 4)) & 0x0f0f0f0f;
+			value = (value | (value << 2)) & 0x33333333;
+			value = (value | (value << 1)) & 0x55555555;
+			return value;
+		}
+	};
+
+	using default_layout = std::conditional_t<is_debug, checked_layout, linear_layout>;
+
 	// represents a 2D buffer of an underlying numeric type.
-	template<is_arithmetic T>
+	template<is_arithmetic T, typename TLayout = default_layout>
 	struct buffer_2d final
 	{
 		using backing_type = T;
+		using layout_type = TLayout;
+		using storage_type = std::vector<T, aligned_allocator<T, TLayout::alignment>>;
 
 		constexpr buffer_2d() = default;
 
 		constexpr buffer_2d(std::uint32_t width, std::uint32_t height)
 			: m_width(width),
 			m_height(height),
-			m_buffer(std::vector<T>(width * height))
+			m_stride(TLayout::template stride<T>(width)),
+			m_buffer(storage_type(TLayout::size(m_stride, height))),
+			m_data(m_buffer.data())
 		{}
 
+		// m_data may point into m_buffer, so copies and moves have to
+		// re-point it at their own storage unless it's attached.
+		constexpr buffer_2d(const buffer_2d& other)
+			: m_width(other.m_width),
+			m_height(other.m_height),
+			m_stride(other.m_stride),
+			m_buffer(other.m_buffer),
+			m_data(other.m_attached ? other.m_data : m_buffer.data()),
+			m_attached(other.m_attached)
+		{}
+
+		constexpr buffer_2d(buffer_2d&& other) noexcept
+			: m_width(other.m_width),
+			m_height(other.m_height),
+			m_stride(other.m_stride),
+			m_buffer(std::move(other.m_buffer)),
+			m_data(other.m_attached ? other.m_data : m_buffer.data()),
+			m_attached(other.m_attached)
+		{
+			other.m_data = other.m_buffer.data();
+			other.m_attached = false;
+		}
+
+		constexpr auto operator=(buffer_2d other) noexcept -> buffer_2d&
+		{
+			std::swap(m_width, other.m_width);
+			std::swap(m_height, other.m_height);
+			std::swap(m_stride, other.m_stride);
+			std::swap(m_attached, other.m_attached);
+			m_buffer.swap(other.m_buffer);
+			m_data = m_attached ? other.m_data : m_buffer.data();
+			return *this;
+		}
+
 		constexpr auto operator[](this auto&& self, const std::uint64_t index) noexcept -> decltype(auto)
 		{
-			return std::forward_like<decltype(self)>(m_buffer[index]);
+			return std::forward_like<decltype(self)>(self.m_data[index]);
 		}
 
 		constexpr auto width()          const noexcept  -> std::uint32_t { return m_width; }
 		constexpr auto height()         const noexcept  -> std::uint32_t { return m_height; }
-		constexpr auto total_elements() const noexcept  -> size_t { return m_buffer.size(); }
-		constexpr auto raw_buffer()     noexcept        -> T* { return m_buffer.data(); }
-		constexpr auto data()           noexcept        -> T* { return m_buffer.data(); }
+		constexpr auto stride()         const noexcept  -> std::uint32_t { return m_stride; }
+		constexpr auto total_elements() const noexcept  -> size_t { return TLayout::size(m_stride, m_height); }
+		constexpr auto raw_buffer(this auto&& self) noexcept { return self.storage(); }
+		constexpr auto data(this auto&& self)       noexcept { return self.storage(); }
+		constexpr auto is_attached()    const noexcept  -> bool { return m_attached; }
 
 		constexpr void set(std::uint64_t row, std::uint64_t column, T value) noexcept(is_release)
 		{
 			if (check_bounds(row, column, std::nothrow))
-				m_buffer[row * m_width + column] = value;
+				m_data[index_of(row, column)] = value;
 		}
 
-		constexpr auto operator[](this auto&& self, std::uint64_t row, std::uint64_t column) noexcept -> decltype(auto)
+		constexpr auto operator[](this auto&& self, std::uint64_t row, std::uint64_t column) noexcept(not TLayout::is_checked) -> decltype(auto)
 		{
 			self.check_bounds(row, column);
-			return std::forward_like<decltype(self)>(self.m_buffer[row * self.m_width + column]);
+			return std::forward_like<decltype(self)>(self.m_data[self.index_of(row, column)]);
 		}
 
 		constexpr auto check_bounds(
-			this auto&& self, 
-			std::uint64_t row, 
+			this auto&& self,
+			std::uint64_t row,
 			std::uint64_t column,
 			const std::nothrow_t&
 		) noexcept -> bool
@@ -55,26 +222,143 @@ export namespace renderer
 
 		constexpr void check_bounds(this auto&& self, std::uint64_t row, std::uint64_t column)
 		{
-			if constexpr (is_debug) // for debugging only
+			if constexpr (TLayout::is_checked) // for debugging only
 				if (not self.check_bounds(row, column, std::nothrow))
 					throw std::runtime_error(std::format("Index out of bounds {}:{} against {}:{}", row, column, self.m_width, self.m_height));
 		}
 
 		constexpr void fill(const T value = 0) noexcept
 		{
-			std::ranges::fill(m_buffer, value);
+			std::fill_n(m_data, total_elements(), value);
 		}
 
+		// The number of bytes in each row, including padding.
 		constexpr auto pitch() const noexcept -> std::uint32_t
+			requires TLayout::is_linear
+		{
+			return m_stride * sizeof(T);
+		}
+
+		// A contiguous view of a single row, so raster code can write a
+		// span without recomputing the index of every pixel.
+		constexpr auto row(this auto&& self, std::uint32_t row) noexcept
+			requires TLayout::is_linear
+		{
+			return std::span{ self.storage() + std::size_t{ row } * self.m_stride, self.m_width };
+		}
+
+		constexpr auto tiles_per_row()    const noexcept -> std::uint32_t requires TLayout::is_tiled { return m_stride; }
+		constexpr auto tiles_per_column() const noexcept -> std::uint32_t requires TLayout::is_tiled
+		{
+			return (m_height + TLayout::tile_mask) >> TLayout::tile_shift;
+		}
+
+		// The contiguous storage of a single tile. Pixels inside it are
+		// ordered according to TLayout::in_tile_index().
+		constexpr auto tile(this auto&& self, std::uint32_t tile_row, std::uint32_t tile_column) noexcept
+			requires TLayout::is_tiled
+		{
+			return std::span<std::remove_pointer_t<decltype(self.storage())>, TLayout::tile_elements>{
+				self.storage() + TLayout::tile_offset(tile_row, tile_column, self.m_stride),
+				TLayout::tile_elements
+			};
+		}
+
+		// Copies the visible pixels out in plain row-major order into
+		// destination, whose rows are destination_pitch bytes apart. This
+		// is what gets handed to SDL for presentation.
+		constexpr void resolve(this const buffer_2d& self, T* destination, std::size_t destination_pitch) noexcept
+		{
+			const auto destination_stride = destination_pitch / sizeof(T);
+			if constexpr (TLayout::is_linear)
+			{
+				if (destination_stride == self.m_stride)
+				{
+					std::copy_n(self.storage(), self.total_elements(), destination);
+					return;
+				}
+				for (std::uint32_t row = 0; row < self.m_height; row++)
+					std::ranges::copy(self.row(row), destination + row * destination_stride);
+			}
+			else
+			{
+				for (std::uint32_t tile_row = 0; tile_row < self.tiles_per_column(); tile_row++)
+				{
+					const auto first_row = tile_row << TLayout::tile_shift;
+					const auto rows = std::min(TLayout::tile_size, self.m_height - first_row);
+					for (std::uint32_t tile_column = 0; tile_column < self.tiles_per_row(); tile_column++)
+					{
+						const auto first_column = tile_column << TLayout::tile_shift;
+						const auto columns = std::min(TLayout::tile_size, self.m_width - first_column);
+						const auto tile = self.tile(tile_row, tile_column);
+						for (std::uint32_t row = 0; row < rows; row++)
+						{
+							auto out = destination + (first_row + row) * destination_stride + first_column;
+							if constexpr (TLayout::has_linear_tile_rows)
+								std::copy_n(tile.data() + TLayout::in_tile_index(row, 0), columns, out);
+							else
+								for (std::uint32_t column = 0; column < columns; column++)
+									out[column] = tile[TLayout::in_tile_index(row, column)];
+						}
+					}
+				}
+			}
+		}
+
+		// Points the buffer at external storage, such as the locked pixels
+		// of a streaming texture, whose rows are pitch bytes apart. The
+		// buffer's own storage is kept and used again after detach().
+		constexpr void attach(T* pixels, std::size_t pitch) noexcept
+			requires TLayout::is_linear
+		{
+			m_data = pixels;
+			m_stride = static_cast<std::uint32_t>(pitch / sizeof(T));
+			m_attached = true;
+		}
+
+		constexpr void detach() noexcept
+		{
+			m_data = m_buffer.data();
+			m_stride = TLayout::template stride<T>(m_width);
+			m_attached = false;
+		}
+
+		// Changes the buffer's dimensions. The storage is only reallocated
+		// if it's too small, so a buffer sized for the largest dimensions
+		// up front can be resized every frame without touching the heap.
+		// The contents are left unspecified.
+		constexpr void resize(std::uint32_t width, std::uint32_t height)
 		{
-			// this is the number of bytes in each row
-			return m_width * sizeof(std::uint32_t);
+			if (m_attached)
+				detach();
+			m_width = width;
+			m_height = height;
+			m_stride = TLayout::template stride<T>(width);
+			if (TLayout::size(m_stride, height) > m_buffer.size())
+				m_buffer.resize(TLayout::size(m_stride, height));
+			m_data = m_buffer.data();
 		}
 
 	private:
+		constexpr auto storage(this auto&& self) noexcept
+		{
+			if constexpr (std::is_const_v<std::remove_reference_t<decltype(self)>>)
+				return static_cast<const T*>(self.m_data);
+			else
+				return self.m_data;
+		}
+
+		constexpr auto index_of(std::uint64_t row, std::uint64_t column) const noexcept -> std::size_t
+		{
+			return TLayout::index(static_cast<std::uint32_t>(row), static_cast<std::uint32_t>(column), m_stride);
+		}
+
 		std::uint32_t m_width = 0;
 		std::uint32_t m_height = 0;
-		std::vector<T> m_buffer = std::vector<T>(m_width * m_height);
+		std::uint32_t m_stride = 0;
+		storage_type m_buffer{};
+		T* m_data = nullptr;
+		bool m_attached = false;
 	};
 
 	// Each byte in uint32_t is one element of the pixel colour
@@ -83,19 +367,63 @@ export namespace renderer
 	using color_buffer = buffer_2d<uint32_t>;
 	using z_buffer = buffer_2d<float>;
 
-	struct frame_buffer
+	// The depth plane stores 1/w in the TDepth format; see depthformat.
+	template<typename TLayout = default_layout, typename TDepth = float_depth>
+	struct basic_frame_buffer
 	{
-		color_buffer color;
-		z_buffer depth;
-		constexpr frame_buffer() = default;
-		constexpr frame_buffer(std::uint32_t width, std::uint32_t height)
-			: color(width, height), depth(width, height)
+		using layout_type = TLayout;
+		using depth_format_type = TDepth;
+		buffer_2d<std::uint32_t, TLayout> color;
+		buffer_2d<typename TDepth::value_type, TLayout> depth;
+		TDepth depth_format{};
+		constexpr basic_frame_buffer() = default;
+		constexpr basic_frame_buffer(std::uint32_t width, std::uint32_t height, TDepth format = {})
+			: color(width, height), depth(width, height), depth_format(format)
 		{}
-		// Initialise to 0 because 1/w is used directly for depth
-		// testing with a > comparison (larger 1/w = closer).
+		constexpr void resize(std::uint32_t width, std::uint32_t height)
+		{
+			color.resize(width, height);
+			depth.resize(width, height);
+		}
+		// Calls visit(column, colour, depth) for each pixel from column
+		// first to last, inclusive, of row, which must all be inside the
+		// buffer. Linear buffers are walked through a span of each plane's
+		// row and tiled ones a tile at a time, so a raster loop touches
+		// both planes through contiguous storage, and with a tiled layout
+		// the tiles it keeps returning to across rows stay in L1.
+		template<typename TVisit>
+		constexpr void for_each_in_span(std::uint32_t row, std::uint32_t first, std::uint32_t last, TVisit&& visit)
+		{
+			if constexpr (TLayout::is_linear)
+			{
+				auto colors = color.row(row);
+				auto depths = depth.row(row);
+				for (auto column = first; column <= last; column++)
+					visit(column, colors[column], depths[column]);
+			}
+			else
+			{
+				const auto tile_row = row >> TLayout::tile_shift;
+				const auto row_in_tile = row & TLayout::tile_mask;
+				for (auto tile_column = first >> TLayout::tile_shift; tile_column <= last >> TLayout::tile_shift; tile_column++)
+				{
+					auto colors = color.tile(tile_row, tile_column);
+					auto depths = depth.tile(tile_row, tile_column);
+					const auto tile_first = std::max(first, tile_column << TLayout::tile_shift);
+					const auto tile_last = std::min(last, (tile_column << TLayout::tile_shift) | TLayout::tile_mask);
+					for (auto column = tile_first; column <= tile_last; column++)
+					{
+						const auto index = TLayout::in_tile_index(row_in_tile, column & TLayout::tile_mask);
+						visit(column, colors[index], depths[index]);
+					}
+				}
+			}
+		}
+		// Initialise to 0 because depth is tested with a > comparison
+		// (larger 1/w = closer) in every format.
 		constexpr auto clear_z_buffer(this auto&& self) noexcept -> decltype(auto)
 		{
-			self.depth.fill(0.f);
+			self.depth.fill(0);
 			return decltype(self)(self);
 		}
 		constexpr auto clear_color_buffer(this auto&& self, const std::uint32_t fill_color = 0xff000000) noexcept -> decltype(auto)
@@ -104,8 +432,16 @@ export namespace renderer
 			return decltype(self)(self);
 		}
 	};
+
+	using frame_buffer = basic_frame_buffer<>;
+	template<typename TDepth>
+	using frame_buffer_with_depth = basic_frame_buffer<default_layout, TDepth>;
+	using tiled_frame_buffer = basic_frame_buffer<tiled_layout<>>;
 }
 
+static_assert(
+	renderer::tiled_layout<>::tile_elements * sizeof(float) % renderer::tiled_layout<>::alignment == 0,
+	"Tiles are expected to start on a cache line boundary.");
 static_assert(
 	[]{
 		renderer::buffer_2d<std::uint32_t> buffer;
@@ -116,6 +452,11 @@ static_assert(
 		renderer::buffer_2d<std::uint32_t> buffer{ 200, 300 };
 		return buffer.width() == 200 and buffer.height() == 300;
 	}(), "A buffer constructed with arguments 200 and 300 should have width and height of 200 and 300 respectively.");
+static_assert(
+	[] {
+		renderer::buffer_2d<std::uint32_t> buffer{ 200, 300 };
+		return buffer.stride() == 208 and buffer.pitch() % 64 == 0;
+	}(), "Linear rows are expected to be padded to a whole number of cache lines.");
 static_assert(
 	[] {
 		renderer::buffer_2d<std::uint32_t> buffer{ 200, 300 };
@@ -126,11 +467,96 @@ static_assert(
 	[] {
 		renderer::buffer_2d<std::uint32_t> buffer{ 200, 300 };
 		buffer.set(1, 1, 45);
-		return buffer.raw_buffer()[200 + 1] == 45;
+		return buffer.raw_buffer()[buffer.stride() + 1] == 45;
 	}(), "A set() operation did not modify the expected pixel to the correct value.");
 static_assert(
 	[] {
 		renderer::buffer_2d<std::uint32_t> buffer{ 200, 300 };
 		buffer[1,1] = 45;
-		return buffer.raw_buffer()[200 + 1] == 45;
+		return buffer.raw_buffer()[buffer.stride() + 1] == 45;
 	}(), "A set() operation did not modify the expected pixel to the correct value.");
+static_assert(
+	[] {
+		renderer::buffer_2d<std::uint32_t> buffer{ 200, 300 };
+		buffer.row(2)[3] = 45;
+		return buffer[2, 3] == 45;
+	}(), "A row() write did not modify the expected pixel.");
+static_assert(
+	[] {
+		auto external = std::vector<std::uint32_t>(300 * 4);
+		renderer::buffer_2d<std::uint32_t> buffer{ 200, 4 };
+		buffer.attach(external.data(), 300 * sizeof(std::uint32_t));
+		buffer[1, 2] = 45;
+		auto copy = buffer;
+		copy[1, 3] = 46;
+		buffer.detach();
+		return external[300 + 2] == 45 and external[300 + 3] == 46 and buffer[1, 2] == 0;
+	}(), "An attached buffer did not write through to its external storage.");
+static_assert(
+	[] {
+		renderer::buffer_2d<std::uint32_t, renderer::tiled_layout<>> buffer{ 20, 20 };
+		buffer[9, 10] = 45;
+		// Second tile row, second tile column, row 1 and column 2 inside the tile.
+		return buffer.tiles_per_row() == 3 and buffer.tile(1, 1)[1 * 8 + 2] == 45;
+	}(), "A tiled write did not land in the expected tile.");
+static_assert(
+	[] {
+		renderer::buffer_2d<std::uint32_t, renderer::morton_layout<>> buffer{ 8, 8 };
+		buffer[3, 5] = 45;
+		// column 5 = 0b101, row 3 = 0b011 -> interleaved 0b011011
+		return buffer.tile(0, 0)[0b011011] == 45;
+	}(), "A Morton write did not land at the expected Z-order offset.");
+static_assert(
+	[] {
+		auto resolves_linearly = []<typename TLayout>() -> bool
+		{
+			renderer::buffer_2d<std::uint32_t, TLayout> buffer{ 13, 11 };
+			for (std::uint32_t row = 0; row < buffer.height(); row++)
+				for (std::uint32_t column = 0; column < buffer.width(); column++)
+					buffer[row, column] = row * 100 + column;
+			auto out = std::vector<std::uint32_t>(13 * 11);
+			buffer.resolve(out.data(), 13 * sizeof(std::uint32_t));
+			for (std::uint32_t row = 0; row < buffer.height(); row++)
+				for (std::uint32_t column = 0; column < buffer.width(); column++)
+					if (out[row * 13 + column] != row * 100 + column)
+						return false;
+			return true;
+		};
+		return resolves_linearly.operator()<renderer::linear_layout>()
+			and resolves_linearly.operator()<renderer::tiled_layout<>>()
+			and resolves_linearly.operator()<renderer::morton_layout<>>();
+	}(), "Resolving a buffer did not produce a row-major image.");
+static_assert(
+	[] {
+		auto visits_row_span = []<typename TLayout>() -> bool
+		{
+			renderer::basic_frame_buffer<TLayout> buffer{ 20, 20 };
+			auto columns = std::vector<std::uint32_t>{};
+			buffer.for_each_in_span(9, 3, 17, [&](std::uint32_t column, std::uint32_t& pixel, float& depth)
+			{
+				columns.push_back(column);
+				pixel = column;
+				depth = 1.f;
+			});
+			for (std::uint32_t column = 0; column < 20; column++)
+			{
+				auto inside = column >= 3 and column <= 17;
+				if (buffer.color[9, column] != (inside ? column : 0) or buffer.depth[9, column] != (inside ? 1.f : 0.f))
+					return false;
+			}
+			return columns == std::vector<std::uint32_t>{ 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17 };
+		};
+		return visits_row_span.operator()<renderer::linear_layout>()
+			and visits_row_span.operator()<renderer::tiled_layout<>>()
+			and visits_row_span.operator()<renderer::morton_layout<>>();
+	}(), "A span is expected to visit every pixel in it, in order, and no others, in every layout.");
+static_assert(
+	[] {
+		renderer::buffer_2d<std::uint32_t> buffer{ 200, 300 };
+		auto storage = buffer.raw_buffer();
+		buffer.resize(100, 150);
+		auto shrunk_in_place = buffer.raw_buffer() == storage and buffer.width() == 100 and buffer.height() == 150;
+		buffer.set(149, 99, 45);
+		buffer.resize(200, 300);
+		return shrunk_in_place and buffer.raw_buffer() == storage and buffer.stride() == 208;
+	}(), "Resizing a buffer within its original size is expected to reuse its storage.");
@@ -79,5 +79,51 @@ export namespace renderer
 		vector_3f direction{ 0, 0, 1 };
 		vector_3f forward_velocity{ };
 		float yaw{ };
+		// Up and down, about the camera's own x axis after the yaw.
+		// Positive looks down.
+		float pitch{ };
+
+		auto operator==(const camera_t&) const -> bool = default;
 	};
+
+	// The unit vector a camera looks along: +z turned by the pitch, then
+	// the yaw.
+	inline auto forward_direction(const camera_t& camera) noexcept -> vector_3f
+	{
+		return {
+			std::cos(camera.pitch) * std::sin(camera.yaw),
+			-std::sin(camera.pitch),
+			std::cos(camera.pitch) * std::cos(camera.yaw)
+		};
+	}
+
+	// The camera's up, turned with it, so that a camera looking straight
+	// up or down still has a well-defined view matrix.
+	inline auto up_direction(const camera_t& camera) noexcept -> vector_3f
+	{
+		return {
+			std::sin(camera.pitch) * std::sin(camera.yaw),
+			std::cos(camera.pitch),
+			std::sin(camera.pitch) * std::cos(camera.yaw)
+		};
+	}
+
+	// Blends the position and heading of two camera states, e.g. those
+	// of the last two fixed simulation steps. The direction is left to be
+	// recomputed from the yaw.
+	constexpr auto interpolate(const camera_t& previous, const camera_t& current, float alpha) noexcept -> camera_t
+	{
+		auto blend = [alpha](float from, float to) { return from + (to - from) * alpha; };
+		return camera_t{
+			.position {
+				blend(previous.position.x, current.position.x),
+				blend(previous.position.y, current.position.y),
+				blend(previous.position.z, current.position.z)
+			},
+			.direction = current.direction,
+			.forward_velocity = current.forward_velocity,
+			.yaw = blend(previous.yaw, current.yaw),
+			.pitch = blend(previous.pitch, current.pitch)
+		};
+	}
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+export module renderer:renderer.depthformat;
+import std;
+
+export namespace renderer
+{
+	// Depth formats decide how a frame buffer's depth plane stores each
+	// pixel's 1/w. Whatever the format, a larger stored value is closer to
+	// the camera, a pixel is drawn only if its encoded 1/w is greater than
+	// the stored one, and a cleared plane holds zero, which is farther than
+	// anything.
+
+	// 1/w as is.
+	struct float_depth
+	{
+		using value_type = float;
+
+		constexpr auto encode(float w_reciprocal) const noexcept -> value_type { return w_reciprocal; }
+		constexpr auto decode(value_type depth) const noexcept -> float { return depth; }
+	};
+
+	// 1/w scaled by the near plane distance and stored as VBits of fixed
+	// point. The mapping is reversed, the near plane to the largest value
+	// and infinity to zero, so the compare and the clear are the same as
+	// for float_depth. The steps are even in 1/w, which makes them finest
+	// near the camera: with a near plane of 0.1, 16 bits resolve about
+	// 0.00015 units at a distance of 1 and 0.1 at 25.
+	template<std::unsigned_integral T, std::uint32_t VBits>
+	struct unorm_depth
+	{
+		static_assert(VBits <= std::numeric_limits<T>::digits);
+
+		using value_type = T;
+		static constexpr auto max_value = static_cast<float>((std::uint64_t{ 1 } << VBits) - 1);
+
+		// Has to match the projection's. Anything nearer saturates to the
+		// largest value.
+		float near_plane = 0.1f;
+
+		constexpr auto encode(float w_reciprocal) const noexcept -> value_type
+		{
+			auto unorm = std::clamp(w_reciprocal * near_plane, 0.f, 1.f);
+			// Rounded, and kept within VBits where rounding in float
+			// overshoots.
+			return static_cast<value_type>(std::min(unorm * max_value + 0.5f, max_value));
+		}
+
+		constexpr auto decode(value_type depth) const noexcept -> float
+		{
+			return static_cast<float>(depth) / max_value / near_plane;
+		}
+	};
+
+	// Kept in 32 bits with the top 8 unused, like a D24X8 GPU format, so it
+	// moves as many bytes as float_depth; it's the layout a packed stencil
+	// would go into.
+	using unorm24_depth = unorm_depth<std::uint32_t, 24>;
+	// Half the depth traffic of the others.
+	using unorm16_depth = unorm_depth<std::uint16_t, 16>;
+
+	// For picking one of the above at run time.
+	enum class depth_encoding
+	{
+		float32,
+		unorm24,
+		unorm16
+	};
+}
+
+static_assert(
+	[]{
+		auto depth = renderer::unorm16_depth{ .near_plane = 0.1f };
+		// The near plane is the largest value, and nearer stays there;
+		// farther is smaller, and 1/w of zero is the cleared value.
+		return depth.encode(10.f) == 65535
+			and depth.encode(20.f) == 65535
+			and depth.encode(1.f) < depth.encode(2.f)
+			and depth.encode(0.f) == 0;
+	}(),
+	"unorm depth is expected to map the near plane to its largest value and infinity to zero."
+);
+
+static_assert(
+	[]{
+		// 1/w at distances 1 and 1.001 stay distinct in 16 bits, and come
+		// back to within a step.
+		auto depth = renderer::unorm16_depth{ .near_plane = 0.1f };
+		auto decoded = depth.decode(depth.encode(1.f));
+		return depth.encode(1.f) > depth.encode(1.f / 1.001f)
+			and decoded > 0.999f and decoded < 1.001f;
+	}(),
+	"unorm depth is expected to resolve small distances near the camera."
+);
@@ -1,9 +1,9 @@
 export module renderer:renderer.display;
 import std;
 import :math;
-import :sdl;
 import :renderer.primitives;
 import :renderer.buffer_2d;
+import :renderer.screenrect;
 
 export namespace renderer
 {
@@ -34,28 +34,58 @@ export namespace renderer
         }
     }
 
-    constexpr void draw_dot_grid(std::int32_t step, std::uint32_t color, renderer::frame_buffer& buffer)
+    // Draws only the dots that fall inside region, for redrawing part of
+    // a frame.
+    template<typename TLayout, typename TDepth>
+    constexpr void draw_dot_grid(std::int32_t step, std::uint32_t color, renderer::basic_frame_buffer<TLayout, TDepth>& buffer, const screen_rect& region)
     {
-        for (uint32_t row = 0; row < buffer.color.height(); row += 10)
-            for (uint32_t column = 0; column < buffer.color.width(); column += 10)
+        // Start from the first multiple of 10 in the region, so the dots
+        // line up with the rest of the grid.
+        for (uint32_t row = (region.y + 9) / 10 * 10; row < region.bottom() and row < buffer.color.height(); row += 10)
+            for (uint32_t column = (region.x + 9) / 10 * 10; column < region.right() and column < buffer.color.width(); column += 10)
                 buffer.color.set(row, column, color);
     }
 
+    template<typename TLayout, typename TDepth>
+    constexpr void draw_dot_grid(std::int32_t step, std::uint32_t color, renderer::basic_frame_buffer<TLayout, TDepth>& buffer)
+    {
+        draw_dot_grid(step, color, buffer, { 0, 0, buffer.color.width(), buffer.color.height() });
+    }
+
+    // Clears the colour and depth of region alone, leaving the rest of
+    // the frame as it was.
+    template<typename TLayout, typename TDepth>
+    constexpr void clear_region(const screen_rect& region, std::uint32_t color, renderer::basic_frame_buffer<TLayout, TDepth>& buffer)
+    {
+        if (region.empty())
+            return;
+        for (auto row = region.y; row < region.bottom(); row++)
+        {
+            buffer.for_each_in_span(row, region.x, region.right() - 1, [color](std::uint32_t, std::uint32_t& pixel, auto& depth)
+            {
+                pixel = color;
+                depth = 0;
+            });
+        }
+    }
+
 	// This is in row-major form. This means that if you're
 	// working with Cartesian coordinates, you need to swap 
     // x and y to get the correct pixel.
-    constexpr void draw_pixel(std::uint32_t x, std::uint32_t y, std::uint32_t color, renderer::frame_buffer& buffer)
+    template<typename TLayout, typename TDepth>
+    constexpr void draw_pixel(std::uint32_t x, std::uint32_t y, std::uint32_t color, renderer::basic_frame_buffer<TLayout, TDepth>& buffer)
     {
         buffer.color.set(x, y, color);
     }
 
+    template<typename TLayout, typename TDepth>
     constexpr void draw_rect(
         std::uint32_t x,
         std::uint32_t y,
         std::uint32_t width,
         std::uint32_t height,
         std::uint32_t color,
-        renderer::frame_buffer& buffer
+        renderer::basic_frame_buffer<TLayout, TDepth>& buffer
     )
     {
         for (uint32_t row = y; row < y + width and row < buffer.color.height(); row++)
@@ -63,24 +93,15 @@ export namespace renderer
                 draw_pixel(row, column, color, buffer);
     }
 
-    void render_color_buffer(
-        SDL_Renderer* renderer,
-        renderer::color_buffer& buffer,
-        SDL_Texture* color_buffer_texture
-    )
-    {
-        SDL_UpdateTexture(color_buffer_texture, nullptr, buffer.raw_buffer(), buffer.pitch());
-        SDL_RenderCopy(renderer, color_buffer_texture, nullptr, nullptr);
-    }
-
     // DDA algorithm
+    template<typename TLayout, typename TDepth>
     constexpr void draw_line(
         const int x0,
         const int y0,
         const int x1,
         const int y1,
         const std::uint32_t color,
-        renderer::frame_buffer& buffer
+        renderer::basic_frame_buffer<TLayout, TDepth>& buffer
     )
     {
         int delta_x = x1 - x0;
@@ -105,10 +126,11 @@ export namespace renderer
         }
     }
 
+    template<typename TLayout, typename TDepth>
     constexpr void draw_triangle(
         const renderer::triangle& triangle,
         const std::uint32_t color,
-        renderer::frame_buffer& buffer
+        renderer::basic_frame_buffer<TLayout, TDepth>& buffer
     )
     {
         draw_line(
@@ -137,19 +159,43 @@ export namespace renderer
         ); // and back to 2 -> 0
     }
 
-    constexpr void draw_triangle_pixel(
-        int x,
+    // Hands shade the colour and depth of each pixel of one scanline
+    // of a triangle, from x_start to x_end, which are already clamped to
+    // the buffer's width. Scanlines above or below the buffer are skipped.
+    // The pixels are walked through the buffer's layout a row or tile at a
+    // time rather than indexed one by one.
+    template<typename TLayout, typename TDepth, typename TShade>
+    constexpr void draw_span(
         int y,
-        const std::array<textured_vertex, 3>& vertex,
-        renderer::frame_buffer& buffer,
-		std::uint32_t color
+        float x_start,
+        float x_end,
+        renderer::basic_frame_buffer<TLayout, TDepth>& buffer,
+        TShade&& shade
     )
     {
-        if (x < 0 or y < 0
-            or static_cast<std::uint32_t>(y) >= buffer.depth.height()
-            or static_cast<std::uint32_t>(x) >= buffer.depth.width())
+        if (y < 0 or static_cast<std::uint32_t>(y) >= buffer.color.height())
             return;
+        buffer.for_each_in_span(
+            static_cast<std::uint32_t>(y),
+            static_cast<std::uint32_t>(x_start),
+            static_cast<std::uint32_t>(x_end),
+            shade
+        );
+    }
 
+    // Depth tests and writes one pixel of a filled triangle, given the
+    // pixel's colour and depth in the frame buffer.
+    template<typename TDepth>
+    constexpr void draw_triangle_pixel(
+        std::uint32_t x,
+        std::uint32_t y,
+        const std::array<textured_vertex, 3>& vertex,
+        const TDepth& depth_format,
+		std::uint32_t color,
+        std::uint32_t& pixel,
+        typename TDepth::value_type& depth
+    )
+    {
         auto weights = barycentric_weights(
             vector_2f{ .x = vertex[0].position.x, .y = vertex[0].position.y },
             vector_2f{ .x = vertex[1].position.x, .y = vertex[1].position.y },
@@ -186,18 +232,21 @@ export namespace renderer
 
         // Use 1/w directly for depth testing: larger 1/w means
         // closer to the camera. Avoids the precision loss that
-        // a "1 - 1/w" transformation would introduce.
-        if (interpolated_w_reciprocal > buffer.depth[static_cast<uint32_t>(y), static_cast<uint32_t>(x)])
+        // a "1 - 1/w" transformation would introduce. Compact
+        // formats quantize it first, keeping the same order.
+        auto encoded_depth = depth_format.encode(interpolated_w_reciprocal);
+        if (encoded_depth > depth)
         {
-            draw_pixel(static_cast<uint32_t>(y), static_cast<uint32_t>(x), color, buffer);
-            buffer.depth.set(static_cast<uint32_t>(y), static_cast<uint32_t>(x), interpolated_w_reciprocal);
+            pixel = color;
+            depth = encoded_depth;
         }
     }
 
+    template<typename TLayout, typename TDepth>
     constexpr void draw_filled_triangle(
         const triangle& triangle,
         std::uint32_t color,
-        renderer::frame_buffer& buffer
+        renderer::basic_frame_buffer<TLayout, TDepth>& buffer
     )
     {
         // Sort by ascending y-coordinate
@@ -248,10 +297,10 @@ export namespace renderer
                 x_start = std::clamp(x_start, 0.f, static_cast<float>(buffer.color.width() - 1));
                 x_end = std::clamp(x_end, 0.f, static_cast<float>(buffer.color.width() - 1));
 
-                for (int x = static_cast<int>(x_start); x <= static_cast<int>(x_end); x++)
+                draw_span(y, x_start, x_end, buffer, [&](std::uint32_t x, std::uint32_t& pixel, auto& depth)
                 {
-                    draw_triangle_pixel(x, y, vertices, buffer, color);
-                }
+                    draw_triangle_pixel(x, static_cast<std::uint32_t>(y), vertices, buffer.depth_format, color, pixel, depth);
+                });
             }
         }
 
@@ -276,30 +325,50 @@ export namespace renderer
                 x_start = std::clamp(x_start, 0.f, static_cast<float>(buffer.color.width() - 1));
                 x_end = std::clamp(x_end, 0.f, static_cast<float>(buffer.color.width() - 1));
 
-                for (int x = static_cast<int>(x_start); x <= static_cast<int>(x_end); x++)
+                draw_span(y, x_start, x_end, buffer, [&](std::uint32_t x, std::uint32_t& pixel, auto& depth)
                 {
-                    draw_triangle_pixel(x, y, vertices, buffer, color);
-                }
+                    draw_triangle_pixel(x, static_cast<std::uint32_t>(y), vertices, buffer.depth_format, color, pixel, depth);
+                });
             }
         }
     }
 
-	// Expects x and y to be in Cartesian space.
+    // Samplers give the textured rasterizer its texels: width() and
+    // height() in texels, and sample(x, y) for the 0xAARRGGBB texel at a
+    // column and row inside them. This one reads plain row-major pixels;
+    // block_cache reads block-compressed ones.
+    struct texel_sampler
+    {
+        const std::uint32_t* texture = nullptr;
+        std::size_t texture_width = 0;
+        std::size_t texture_height = 0;
+
+        constexpr auto width() const noexcept -> std::size_t { return texture_width; }
+        constexpr auto height() const noexcept -> std::size_t { return texture_height; }
+
+        constexpr auto sample(std::uint32_t x, std::uint32_t y) const noexcept -> std::uint32_t
+        {
+            auto colorIndex = (texture_width * y) + x;
+            if (colorIndex >= texture_width * texture_height)
+                colorIndex = texture_width * texture_height - 1;
+            return texture[colorIndex];
+        }
+    };
+
+	// Expects x and y to be in Cartesian space. Depth tests and writes one
+    // pixel of a textured triangle, given the pixel's colour and depth in
+    // the frame buffer.
+    template<typename TSampler, typename TDepth>
     constexpr void draw_texel(
-		int x,
-		int y,
+		std::uint32_t x,
+		std::uint32_t y,
 		const std::array<textured_vertex, 3>& vertex,
-        const std::uint32_t* const texture,
-        size_t texture_width,
-        size_t texture_height,
-		renderer::frame_buffer& buffer
+        TSampler& sampler,
+        const TDepth& depth_format,
+        std::uint32_t& pixel,
+        typename TDepth::value_type& depth
     )
     {
-        if (x < 0 or y < 0
-            or static_cast<std::uint32_t>(y) >= buffer.depth.height()
-            or static_cast<std::uint32_t>(x) >= buffer.depth.width())
-            return;
-
         auto weights = barycentric_weights(
             vector_2f{ .x = vertex[0].position.x, .y = vertex[0].position.y },
             vector_2f{ .x = vertex[1].position.x, .y = vertex[1].position.y },
@@ -335,30 +404,29 @@ export namespace renderer
         interpolated_v /= interpolated_w_reciprocal;
 
 		// Map the UV coordinate to the full texture width and height.
+        const auto texture_width = sampler.width();
+        const auto texture_height = sampler.height();
         auto tex_x = abs(static_cast<int>(interpolated_u * texture_width)) % static_cast<int>(texture_width);
         auto tex_y = abs(static_cast<int>(interpolated_v * texture_height)) % static_cast<int>(texture_height);
 
-        auto colorIndex = (texture_width * tex_y) + tex_x;
-        if (colorIndex >= texture_width * texture_height)
-            colorIndex = texture_width * texture_height - 1;
-
         // Use 1/w directly for depth testing: larger 1/w means
         // closer to the camera. Avoids the precision loss that
-        // a "1 - 1/w" transformation would introduce.
-        if (interpolated_w_reciprocal > buffer.depth[static_cast<uint32_t>(y), static_cast<uint32_t>(x)])
+        // a "1 - 1/w" transformation would introduce. Compact
+        // formats quantize it first, keeping the same order.
+        auto encoded_depth = depth_format.encode(interpolated_w_reciprocal);
+        if (encoded_depth > depth)
         {
-            draw_pixel(static_cast<uint32_t>(y), static_cast<uint32_t>(x), texture[colorIndex], buffer);
-            buffer.depth.set(static_cast<uint32_t>(y), static_cast<uint32_t>(x), interpolated_w_reciprocal);
+            pixel = sampler.sample(static_cast<std::uint32_t>(tex_x), static_cast<std::uint32_t>(tex_y));
+            depth = encoded_depth;
         }
 	}
 
     // Draw a textured triangle with flat-top/flat-bottom method.
+    template<typename TSampler, typename TLayout, typename TDepth>
     constexpr void draw_textured_triangle(
         const triangle& triangle,
-        const std::uint32_t* const texture,
-		size_t texture_width,
-		size_t texture_height,
-        renderer::frame_buffer& buffer
+        TSampler& sampler,
+        renderer::basic_frame_buffer<TLayout, TDepth>& buffer
     )
     {
         // Sort by ascending y-coordinate
@@ -404,10 +472,10 @@ export namespace renderer
                 x_start = std::clamp(x_start, 0.f, static_cast<float>(buffer.color.width() - 1));
                 x_end = std::clamp(x_end, 0.f, static_cast<float>(buffer.color.width() - 1));
 
-                for (int x = static_cast<int>(x_start); x <= static_cast<int>(x_end); x++)
+                draw_span(y, x_start, x_end, buffer, [&](std::uint32_t x, std::uint32_t& pixel, auto& depth)
                 {
-					draw_texel(x, y, vertices, texture, texture_width, texture_height, buffer);
-                }
+                    draw_texel(x, static_cast<std::uint32_t>(y), vertices, sampler, buffer.depth_format, pixel, depth);
+                });
             }
         }
 
@@ -432,11 +500,24 @@ export namespace renderer
                 x_start = std::clamp(x_start, 0.f, static_cast<float>(buffer.color.width() - 1));
                 x_end = std::clamp(x_end, 0.f, static_cast<float>(buffer.color.width() - 1));
 
-                for (int x = static_cast<int>(x_start); x <= static_cast<int>(x_end); x++)
+                draw_span(y, x_start, x_end, buffer, [&](std::uint32_t x, std::uint32_t& pixel, auto& depth)
                 {
-                    draw_texel(x, y, vertices, texture, texture_width, texture_height, buffer);
-                }
+                    draw_texel(x, static_cast<std::uint32_t>(y), vertices, sampler, buffer.depth_format, pixel, depth);
+                });
             }
         }
     }
+
+    template<typename TLayout, typename TDepth>
+    constexpr void draw_textured_triangle(
+        const triangle& triangle,
+        const std::uint32_t* const texture,
+        size_t texture_width,
+        size_t texture_height,
+        renderer::basic_frame_buffer<TLayout, TDepth>& buffer
+    )
+    {
+        auto sampler = texel_sampler{ texture, texture_width, texture_height };
+        draw_textured_triangle(triangle, sampler, buffer);
+    }
 }
@@ -1,7 +1,3 @@
-module;
-
-#include <stdio.h>
-
 export module renderer:renderer.mesh;
 import std;
 import :math;
@@ -84,45 +80,6 @@ export namespace renderer
 			scale.z += s;
 		}
 
-		static auto from_file_2(const std::filesystem::path& p) -> mesh
-		{
-			std::FILE* file = nullptr;
-			fopen_s(&file, p.string().c_str(), "r");
-			char line[1024];
-
-			mesh m;
-
-			while (std::fgets(line, 1024, file)) {
-				// Vertex information
-				if (std::strncmp(line, "v ", 2) == 0) {
-					vector_4f vertex;
-					sscanf_s(line, "v %f %f %f", &vertex.x, &vertex.y, &vertex.z);
-					m.vertices.push_back(vertex);
-				}
-				// Face information
-				if (std::strncmp(line, "f ", 2) == 0) {
-					int vertex_indices[3];
-					int texture_indices[3];
-					int normal_indices[3];
-					sscanf_s(
-						line, "f %d/%d/%d %d/%d/%d %d/%d/%d",
-						&vertex_indices[0], &texture_indices[0], &normal_indices[0],
-						&vertex_indices[1], &texture_indices[1], &normal_indices[1],
-						&vertex_indices[2], &texture_indices[2], &normal_indices[2]
-					);
-					renderer::face face = {
-						.a = vertex_indices[0],
-						.b = vertex_indices[1],
-						.c = vertex_indices[2],
-						.color = 0xFFFFFFFF
-					};
-					m.faces.push_back(face);
-				}
-			}
-
-			return m;
-		}
-
 		struct face_triplet
 		{
 			int vertex_index;
@@ -0,0 +1,188 @@
+export module renderer:renderer.pipeline;
+import std;
+import :math;
+import :camera;
+import :renderer.mesh;
+import :renderer.primitives;
+import :renderer.shading;
+import :renderer.display;
+import :renderer.settings;
+import :renderer.texture;
+import :renderer.blocktexture;
+import :renderer.buffer_2d;
+
+export namespace renderer
+{
+	// Everything about where a mesh is seen from and what it's projected onto.
+	struct view_parameters
+	{
+		camera_t camera;
+		// Also divides by w, to give normalised device coordinates.
+		projective_perspective_divide_matrix projection;
+		// The size of the frame buffer to project into.
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		cull_mode culling = cull_mode::enabled;
+	};
+
+	// Transforms, culls, lights and projects a mesh's faces into screen
+	// space, and returns the triangles to draw, allocated from arena. This
+	// only reads its arguments, so frames can be projected concurrently.
+	auto project_mesh(const mesh& mesh, const view_parameters& view, std::pmr::memory_resource& arena) -> triangle_list
+	{
+		// Create the view matrix, looking from the camera's position in
+		// the direction it's pointing at.
+		auto target = view.camera.position + forward_direction(view.camera);
+		auto view_matrix = look_at_matrix_4x4(view.camera.position, target, up_direction(view.camera));
+
+
+		auto scaleMatrix = scale_matrix{ mesh.scale };
+		auto translation = translate_matrix{ mesh.translation };
+
+		auto rotationMatrix = rotation_matrix{ mesh.rotation };
+
+		constexpr auto global_light = light{ {.x = 0, .y = 0, .z = 1 }, 0xffffffff };
+
+		auto triangles_to_render = triangle_list{ &arena };
+		triangles_to_render.reserve(mesh.faces.size());
+
+		// These need to be applied in the correct order: 
+		// scale, rotate, translate.
+		// Scale our original vertex, then rotate, then 
+		// the vertex away from the camera. The matrix 
+		// translate*rotate*scale is called the world 
+		// matrix and is responsible for placing the
+		// mesh in its correct position in the 3D world.
+		auto world_view_matrix = view_matrix * translation * rotationMatrix * scaleMatrix;
+
+		// Transform every vertex once up front, in a batch, rather than
+		// once for each face that shares it.
+		const auto& mesh_vertices = mesh.vertices;
+		auto view_vertices = std::pmr::vector<vector_4f>(mesh_vertices.size(), &arena);
+		transform(world_view_matrix, mesh_vertices, view_vertices);
+
+		const auto viewport_width = view.width;
+		const auto viewport_height = view.height;
+
+		for (int i = 0; i < mesh.faces.size(); i++)
+		{
+			auto mesh_face = face{ mesh.faces[i] };
+			auto transformed_vertices = std::array{
+				view_vertices[mesh_face.a],
+				view_vertices[mesh_face.b],
+				view_vertices[mesh_face.c]
+			};
+
+			auto transformed_triangle = triangle{
+				.vertices {
+					transformed_vertices[0],
+					transformed_vertices[1],
+					transformed_vertices[2]
+				}
+			};
+			auto normal = vector_4f{ transformed_triangle.compute_normal() };
+
+			/* Backface culling -- bypass rendering triangles that
+			* are not facing the camera.
+			* Note:
+			* This is a naive implementation and modern graphics APIs
+			* and 3D hardware approach back-face culling differently.
+			* For example, OpenGL does not compare the normal of the
+			* faces with the camera; instead, it does back-face culling
+			* after projection and uses the clockwise/counterclockwise
+			* order of the vertices to determine what is visible and
+			* what's not.
+			*
+			* Note that backface culling is not the same as frustum
+			* culling.
+			*/
+			auto origin = vector_3f{ 0, 0, 0 };
+			if (view.culling == cull_mode::enabled)
+			{
+				const auto& [vector_a, vector_b, _] = transformed_vertices;
+				auto camera_ray = vector_4f{ vector_4f{origin.x, origin.y, origin.z, 1.0f} - vector_a };
+				if (dot_product(camera_ray, normal) <= 0) // cull the face
+					continue;
+			}
+
+			// Loop all three vertices
+			auto projected_triangle = triangle{
+				.texcoords = { mesh_face.a_uv, mesh_face.b_uv, mesh_face.c_uv },
+				.color =
+				//global_light.compute_intensity_from_normal(mesh_face.color, normal)
+				global_light.compute_intensity_from_normal(normal),
+			};
+
+			for (int j = 0; j < 3; j++)
+			{
+				// Project the current vertex
+				auto projected_point = vector_4f{ view.projection * transformed_vertices[j] };
+
+				// Scale into the view.
+				projected_point.x *= viewport_width / 2;
+				projected_point.y *= viewport_height / 2;
+
+				// Invert the y coordinate to account for flipped y-axis in screen space.
+				projected_point.y *= -1;
+
+				// Translate the projected points to the middle of the screen.
+				projected_point.x += viewport_width / 2;
+				projected_point.y += viewport_height / 2;
+				projected_triangle.vertices[j] = projected_point;
+			}
+
+			// Save the projected triangle in the array of triangles to render
+			triangles_to_render.push_back(projected_triangle);
+		}
+		return triangles_to_render;
+	}
+
+	// Rasterizes projected triangles into a frame buffer according to the
+	// render mode. The frame buffer isn't cleared first, and may have any
+	// layout.
+	template<typename TLayout, typename TDepth>
+	void draw_triangles(
+		const triangle_list& triangles_to_render,
+		texture::selected_texture texture,
+		const settings& render_settings,
+		basic_frame_buffer<TLayout, TDepth>& frame_buffer
+	)
+	{
+		// Compressed textures are sampled through a cache of decoded blocks
+		// shared by all the triangles, as neighbouring triangles mostly
+		// sample neighbouring blocks.
+		auto compressed_sampler = block_cache<>{};
+		auto sampler = texel_sampler{ texture.buffer, texture.width, texture.height };
+		if (texture.compressed)
+			compressed_sampler.bind(*texture.compressed);
+
+		for (const auto& triangle : triangles_to_render)
+		{
+			if (render_settings.should_draw_filled_triangles())
+				draw_filled_triangle(triangle, triangle.color, frame_buffer);
+
+			if (render_settings.should_draw_textured_triangles())
+			{
+				if (texture.compressed)
+					draw_textured_triangle(triangle, compressed_sampler, frame_buffer);
+				else
+					draw_textured_triangle(triangle, sampler, frame_buffer);
+			}
+
+			if (render_settings.should_draw_triangles())
+				draw_triangle(triangle, 0xffffffff, frame_buffer);
+			if (render_settings.should_draw_points())
+			{
+				for (auto&& vertex : triangle.vertices)
+				{
+					draw_pixel(
+						static_cast<std::uint32_t>(vertex.y),
+						static_cast<std::uint32_t>(vertex.x),
+						0xffff0000,
+						frame_buffer
+					);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+export module renderer:renderer.pixelformat;
+import std;
+#ifndef RENDERER_PORTABLE
+import :sdl;
+#endif
+
+export namespace renderer
+{
+	// The channel order of a 32-bit pixel, named after how it reads
+	// when loaded as a native (little-endian) std::uint32_t.
+	enum class pixel_format
+	{
+		argb8888, // 0xAARRGGBB, stored as the bytes B, G, R, A
+		abgr8888  // 0xAABBGGRR, stored as the bytes R, G, B, A (upng's RGBA8)
+	};
+
+	// The format of the colour buffer and of every texture the rasterizer
+	// samples from. Textures are converted to it when loaded and the SDL
+	// streaming texture is created with it, so no pixel is ever converted
+	// per frame.
+	constexpr auto native_pixel_format = pixel_format::argb8888;
+
+#ifndef RENDERER_PORTABLE
+	constexpr auto to_sdl_pixel_format(pixel_format format) noexcept -> SDL_PixelFormatEnum
+	{
+		switch (format)
+		{
+			case pixel_format::argb8888:
+				return SDL_PixelFormatEnum::SDL_PIXELFORMAT_ARGB8888;
+			case pixel_format::abgr8888:
+				return SDL_PixelFormatEnum::SDL_PIXELFORMAT_ABGR8888;
+		}
+		std::unreachable();
+	}
+#endif
+
+	constexpr auto pack_argb(std::uint32_t a, std::uint32_t r, std::uint32_t g, std::uint32_t b) noexcept -> std::uint32_t
+	{
+		return (a << 24) | (r << 16) | (g << 8) | b;
+	}
+}
+
+static_assert(renderer::pack_argb(0xff, 0xff, 0, 0) == 0xffff0000, "Packing is expected to match the 0xAARRGGBB colour constants.");
@@ -0,0 +1,133 @@
+export module renderer:renderer.present;
+import std;
+import :sdl;
+import :renderer.buffer_2d;
+import :renderer.screenrect;
+
+// Getting rendered frames on screen through SDL. Kept apart from
+// :renderer.display, which only draws into buffers, so that drawing
+// doesn't depend on SDL.
+export namespace renderer
+{
+    // The part of the colour buffer texture that a buffer covers. A buffer
+    // may be smaller than the texture when rendering below the output
+    // resolution, in which case it occupies the texture's top left corner
+    // and is scaled up to the whole window when copied to the renderer.
+    template<typename TLayout>
+    auto texture_region(const renderer::buffer_2d<std::uint32_t, TLayout>& buffer) noexcept -> SDL_Rect
+    {
+        return { 0, 0, static_cast<int>(buffer.width()), static_cast<int>(buffer.height()) };
+    }
+
+    // Copies the buffer into the texture and the texture to the renderer.
+    // Only dirty, if given, is copied into the texture; the texture is
+    // expected to hold the rest of the buffer from earlier frames.
+    template<typename TLayout>
+    void render_color_buffer(
+        SDL_Renderer* renderer,
+        renderer::buffer_2d<std::uint32_t, TLayout>& buffer,
+        SDL_Texture* color_buffer_texture,
+        std::optional<screen_rect> dirty = std::nullopt
+    )
+    {
+        auto region = texture_region(buffer);
+        if constexpr (TLayout::is_linear)
+        {
+            if (dirty)
+            {
+                if (not dirty->empty())
+                {
+                    auto dirty_region = SDL_Rect{
+                        static_cast<int>(dirty->x),
+                        static_cast<int>(dirty->y),
+                        static_cast<int>(dirty->width),
+                        static_cast<int>(dirty->height)
+                    };
+                    auto first_pixel = buffer.raw_buffer() + std::size_t{ dirty->y } * buffer.stride() + dirty->x;
+                    SDL_UpdateTexture(color_buffer_texture, &dirty_region, first_pixel, buffer.pitch());
+                }
+            }
+            else
+            {
+                SDL_UpdateTexture(color_buffer_texture, &region, buffer.raw_buffer(), buffer.pitch());
+            }
+        }
+        else
+        {
+            // Tiled buffers can't be handed to SDL as-is, so resolve them 
+            // straight into the texture's memory instead.
+            void* pixels = nullptr;
+            int pitch = 0;
+            if (SDL_LockTexture(color_buffer_texture, &region, &pixels, &pitch) != 0)
+                throw std::runtime_error(sdl::print_last_error());
+            buffer.resolve(static_cast<std::uint32_t*>(pixels), static_cast<std::size_t>(pitch));
+            SDL_UnlockTexture(color_buffer_texture);
+        }
+        SDL_RenderCopy(renderer, color_buffer_texture, &region, nullptr);
+    }
+
+    // Zero-copy presentation: instead of rasterizing into our own memory
+    // and copying the whole frame into the texture with SDL_UpdateTexture,
+    // lock the streaming texture and point the colour plane at its pixels
+    // so the rasterizer writes straight into upload memory. Returns false
+    // if the texture can't be locked or doesn't match the buffer, in which
+    // case the buffer keeps its own storage for this frame and
+    // present_color_buffer() falls back to copying. A buffer smaller than
+    // the texture is bound to its top left corner.
+    auto lock_color_buffer(renderer::color_buffer& buffer, SDL_Texture* color_buffer_texture) -> bool
+    {
+        int width = 0;
+        int height = 0;
+        if (SDL_QueryTexture(color_buffer_texture, nullptr, nullptr, &width, &height) != 0)
+            return false;
+        if (static_cast<std::uint32_t>(width) < buffer.width() or static_cast<std::uint32_t>(height) < buffer.height())
+            return false;
+
+        void* pixels = nullptr;
+        int pitch = 0;
+        auto region = texture_region(buffer);
+        if (SDL_LockTexture(color_buffer_texture, &region, &pixels, &pitch) != 0)
+            return false;
+        buffer.attach(static_cast<std::uint32_t*>(pixels), static_cast<std::size_t>(pitch));
+        return true;
+    }
+
+    // Presents the colour buffer, unlocking the texture if the buffer was
+    // bound to it by lock_color_buffer(), or copying it otherwise, in
+    // which case only dirty, if given, is copied.
+    void present_color_buffer(
+        SDL_Renderer* renderer,
+        renderer::color_buffer& buffer,
+        SDL_Texture* color_buffer_texture,
+        std::optional<screen_rect> dirty = std::nullopt
+    )
+    {
+        if (not buffer.is_attached())
+            return render_color_buffer(renderer, buffer, color_buffer_texture, dirty);
+
+        buffer.detach();
+        SDL_UnlockTexture(color_buffer_texture);
+        auto region = texture_region(buffer);
+        SDL_RenderCopy(renderer, color_buffer_texture, &region, nullptr);
+    }
+
+    // Copies a buffer into the part of the colour buffer texture at
+    // destination, e.g. one of several viewports, clipped to the smaller
+    // of the two. Nothing is copied to the renderer, so the texture can be
+    // composited from several buffers and then presented once.
+    void composite_color_buffer(
+        const renderer::color_buffer& buffer,
+        SDL_Texture* color_buffer_texture,
+        const screen_rect& destination
+    )
+    {
+        auto region = SDL_Rect{
+            static_cast<int>(destination.x),
+            static_cast<int>(destination.y),
+            static_cast<int>(std::min(destination.width, buffer.width())),
+            static_cast<int>(std::min(destination.height, buffer.height()))
+        };
+        if (region.w > 0 and region.h > 0)
+            SDL_UpdateTexture(color_buffer_texture, &region, buffer.raw_buffer(), buffer.pitch());
+    }
+}
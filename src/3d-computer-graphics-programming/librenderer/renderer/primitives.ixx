@@ -1,4 +1,5 @@
 export module renderer:renderer.primitives;
+import std;
 import :math;
 
 export namespace renderer
@@ -57,4 +58,8 @@ export namespace renderer
 			return normal;
 		}
 	};
+
+	// Triangles are produced and consumed within a frame, so lists of them
+	// are meant to be allocated from a frame_arena.
+	using triangle_list = std::pmr::vector<triangle>;
 }
@@ -3,6 +3,16 @@ export import :renderer.display;
 export import :renderer.mesh;
 export import :renderer.shading;
 export import :renderer.texture;
+export import :renderer.blocktexture;
+#ifndef RENDERER_PORTABLE
+export import :renderer.texturecache;
+export import :renderer.present;
+#endif
+export import :renderer.pipeline;
+export import :renderer.viewport;
+export import :renderer.screenrect;
 export import :renderer.buffer_2d;
+export import :renderer.depthformat;
 export import :renderer.primitives;
 export import :renderer.settings;
+export import :renderer.pixelformat;
@@ -0,0 +1,86 @@
+export module renderer:renderer.screenrect;
+import std;
+import :renderer.primitives;
+
+export namespace renderer
+{
+	// An axis-aligned rectangle of pixels, e.g. the part of a frame that
+	// has to be redrawn. Empty when either extent is zero.
+	struct screen_rect
+	{
+		std::uint32_t x = 0;
+		std::uint32_t y = 0;
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+
+		constexpr auto empty() const noexcept -> bool { return width == 0 or height == 0; }
+		constexpr auto right() const noexcept -> std::uint32_t { return x + width; }
+		constexpr auto bottom() const noexcept -> std::uint32_t { return y + height; }
+
+		// The smallest rectangle covering both.
+		constexpr auto united(const screen_rect& other) const noexcept -> screen_rect
+		{
+			if (empty())
+				return other;
+			if (other.empty())
+				return *this;
+			auto left = std::min(x, other.x);
+			auto top = std::min(y, other.y);
+			return {
+				left,
+				top,
+				std::max(right(), other.right()) - left,
+				std::max(bottom(), other.bottom()) - top
+			};
+		}
+
+		constexpr auto operator==(const screen_rect&) const -> bool = default;
+	};
+
+	// The pixels that drawing the triangles can touch, in any render mode,
+	// within a buffer of the given size. Rasterizing rounds vertices to
+	// whole pixels, so the bounds are padded by one on each side.
+	constexpr auto screen_bounds(const triangle_list& triangles, std::uint32_t width, std::uint32_t height) noexcept -> screen_rect
+	{
+		if (triangles.empty() or width == 0 or height == 0)
+			return {};
+
+		auto min_x = std::numeric_limits<float>::max();
+		auto min_y = std::numeric_limits<float>::max();
+		auto max_x = std::numeric_limits<float>::lowest();
+		auto max_y = std::numeric_limits<float>::lowest();
+		for (auto&& triangle : triangles)
+		{
+			for (auto&& vertex : triangle.vertices)
+			{
+				min_x = std::min(min_x, vertex.x);
+				min_y = std::min(min_y, vertex.y);
+				max_x = std::max(max_x, vertex.x);
+				max_y = std::max(max_y, vertex.y);
+			}
+		}
+
+		auto clamp = [](float value, std::uint32_t limit)
+		{
+			return static_cast<std::uint32_t>(std::clamp(value, 0.f, static_cast<float>(limit)));
+		};
+		auto left = clamp(std::floor(min_x) - 1.f, width);
+		auto top = clamp(std::floor(min_y) - 1.f, height);
+		auto right = clamp(std::ceil(max_x) + 2.f, width);
+		auto bottom = clamp(std::ceil(max_y) + 2.f, height);
+		if (right <= left or bottom <= top)
+			return {};
+		return { left, top, right - left, bottom - top };
+	}
+}
+
+static_assert(
+	[]{
+		auto a = renderer::screen_rect{ 10, 20, 5, 5 };
+		auto b = renderer::screen_rect{ 0, 22, 8, 10 };
+		return a.united(b) == renderer::screen_rect{ 0, 20, 15, 12 }
+			and a.united({}) == a
+			and renderer::screen_rect{}.united(b) == b;
+	}(),
+	"United rectangles are expected to cover both, ignoring empty ones."
+);
@@ -17,10 +17,22 @@ export namespace renderer
 		disabled
 	};
 
+	enum class presentation_mode
+	{
+		// rasterize into the frame buffer's own memory, then copy it into the texture
+		copy,
+		// rasterize directly into the locked streaming texture
+		zero_copy
+	};
+
 	struct settings
 	{
 		render_mode rendering_mode = render_mode::filled_wireframe;
 		cull_mode culling_mode = cull_mode::enabled;
+		presentation_mode presenting_mode = presentation_mode::zero_copy;
+
+		auto operator==(const settings&) const -> bool = default;
+
 		auto should_draw_filled_triangles(this const settings& self) -> bool
 		{
 			return self.rendering_mode == render_mode::filled
@@ -1,6 +1,6 @@
 export module renderer:renderer.texture;
 import std;
-import :upng;
+import :renderer.blocktexture;
 
 export namespace renderer::texture
 {
@@ -9,6 +9,10 @@ export namespace renderer::texture
         const std::uint32_t* buffer = nullptr;
         std::uint32_t width = 0;
         std::uint32_t height = 0;
+        // When set, sampled instead of buffer, which may then be null.
+        const block_compressed_texture* compressed = nullptr;
+
+        auto operator==(const selected_texture&) const -> bool = default;
     };
 }
 
@@ -90,33 +94,16 @@ export namespace renderer::texture::red_brick_texture
     }
 }
 
-namespace renderer::texture::upng_one
-{
-    auto upng_texture = upng::upng_texture{ "..\\assets\\cube.png" };
-}
-
 export namespace renderer::texture
 {
-    // todo: add an option to swap between the upng texture and the hardcoded red brick texture
-    // at runtime, and remove the need for the if constexpr.
-
-	auto get_selected() -> selected_texture
+    // The built-in red brick texture, which is always resident and so is
+    // what's shown while a texture is being loaded.
+    auto red_brick() noexcept -> selected_texture
     {
-        if constexpr (true)
-        {
-            return {
-                .buffer = upng_one::upng_texture.uint32_buffer(),
-                .width = upng_one::upng_texture.width(),
-                .height = upng_one::upng_texture.height()
-            };
-        }
-        else
-        {
-            return {
-                .buffer = red_brick_texture::texture(),
-                .width = red_brick_texture::width,
-                .height = red_brick_texture::height
-            };
-        }
+        return {
+            .buffer = red_brick_texture::texture(),
+            .width = red_brick_texture::width,
+            .height = red_brick_texture::height
+        };
     }
 }
@@ -0,0 +1,374 @@
+export module renderer:renderer.texturecache;
+import std;
+import :upng;
+import :upng.diskcache;
+import :util;
+import :renderer.texture;
+import :renderer.blocktexture;
+
+export namespace renderer
+{
+	// Identifies a texture registered with a texture_cache.
+	enum class texture_handle : std::uint32_t {};
+
+	// How a texture_cache keeps resident textures in memory.
+	enum class texture_encoding
+	{
+		// 32-bit pixels as decoded.
+		argb8888,
+		// Compressed to BC1 blocks after decoding, an eighth of the size,
+		// at the cost of decoding blocks while sampling and of alpha.
+		bc1
+	};
+
+	struct texture_cache_statistics
+	{
+		// Acquires that found the texture resident.
+		std::uint64_t hits = 0;
+		// Acquires that didn't, and so got the fallback texture.
+		std::uint64_t misses = 0;
+		// Textures dropped to stay within the budget.
+		std::uint64_t evictions = 0;
+		// Textures decoded, including ones decoded again after eviction.
+		std::uint64_t decodes = 0;
+		std::size_t resident_bytes = 0;
+		std::size_t budget_bytes = 0;
+		std::size_t resident_textures = 0;
+	};
+
+	// Keeps the decoded pixels of the most recently used textures within a
+	// memory budget, so that any number of textures can be registered but
+	// only the ones being looked at are held in memory.
+	//
+	// Textures are decoded on a background thread the first time they're
+	// acquired after being registered or evicted. Until the decode finishes
+	// acquire() returns the fallback texture, so switching to a texture
+	// never stalls a frame. A texture that fails to decode keeps returning
+	// the fallback, without being decoded again, until it's invalidated;
+	// the error is logged once and kept for decode_error().
+	// When the resident textures exceed the budget,
+	// the least recently acquired are evicted, except for the one just
+	// acquired, which is kept even if it alone is over the budget.
+	// Given a disk cache, which must outlive it, a texture that was decoded
+	// before, in this run or an earlier one, is mapped from there instead.
+	//
+	// All members must be called from the same thread.
+	class texture_cache final
+	{
+	public:
+		explicit texture_cache(
+			std::size_t budget_bytes,
+			texture::selected_texture fallback = texture::red_brick(),
+			texture_encoding encoding = texture_encoding::argb8888,
+			upng::decoded_texture_cache* disk_cache = nullptr
+		)	: m_budget_bytes{ budget_bytes },
+			  m_encoding{ encoding },
+			  m_fallback{ fallback },
+			  m_disk_cache{ disk_cache },
+			  m_decoder{ [this](std::stop_token stop) { decode_loop(stop); } }
+		{ }
+
+		texture_cache(const texture_cache&) = delete;
+		auto operator=(const texture_cache&) -> texture_cache& = delete;
+
+		// Registers a texture without loading it.
+		auto add(std::filesystem::path path) -> texture_handle
+		{
+			m_entries.push_back({ .path = std::move(path) });
+			return static_cast<texture_handle>(m_entries.size() - 1);
+		}
+
+		// Returns the texture's pixels, or the fallback texture while it's
+		// being decoded or if decoding it failed. The pixels are valid until
+		// the next call to acquire(), set_budget(), set_encoding(),
+		// invalidate() or wait_for_decodes(). Compressed textures have only
+		// compressed set. A failed decode doesn't throw; see decode_error().
+		auto acquire(texture_handle handle) -> texture::selected_texture
+		{
+			collect_decoded();
+			auto& entry = m_entries.at(std::to_underlying(handle));
+			// Made the most recently used before evicting, so that it isn't
+			// evicted by the decodes just collected.
+			if (entry.is_resident())
+				m_lru.splice(m_lru.begin(), m_lru, entry.lru_position);
+			evict_to_budget();
+
+			if (not entry.is_resident())
+			{
+				m_statistics.misses++;
+				if (not entry.decode_error)
+					request_decode(handle);
+				return m_fallback;
+			}
+
+			m_statistics.hits++;
+			if (entry.compressed)
+			{
+				return {
+					.width = entry.compressed->width(),
+					.height = entry.compressed->height(),
+					.compressed = entry.compressed.get()
+				};
+			}
+			return {
+				.buffer = entry.pixels->uint32_buffer(),
+				.width = entry.pixels->width(),
+				.height = entry.pixels->height()
+			};
+		}
+
+		auto is_resident(texture_handle handle) const -> bool
+		{
+			return m_entries.at(std::to_underlying(handle)).is_resident();
+		}
+
+		// The error that decoding the texture last threw, if it hasn't been
+		// invalidated since.
+		auto decode_error(texture_handle handle) const -> std::exception_ptr
+		{
+			return m_entries.at(std::to_underlying(handle)).decode_error;
+		}
+
+		// Drops the texture, and any error decoding it threw, so that the
+		// next acquire decodes it again, e.g. after its file changed.
+		void invalidate(texture_handle handle)
+		{
+			auto& entry = m_entries.at(std::to_underlying(handle));
+			entry.decode_error = nullptr;
+			if (not entry.is_resident())
+				return;
+			m_resident_bytes -= size_in_bytes(entry);
+			entry.pixels.reset();
+			entry.compressed.reset();
+			m_lru.erase(entry.lru_position);
+		}
+
+		auto encoding() const noexcept -> texture_encoding { return m_encoding; }
+
+		// Changes how textures are kept. Resident textures are dropped and
+		// decoded again in the new encoding as they're acquired.
+		void set_encoding(texture_encoding encoding)
+		{
+			if (encoding == m_encoding)
+				return;
+			m_encoding = encoding;
+			collect_decoded();
+			for (auto handle : m_lru)
+			{
+				auto& entry = m_entries[std::to_underlying(handle)];
+				entry.pixels.reset();
+				entry.compressed.reset();
+			}
+			m_lru.clear();
+			m_resident_bytes = 0;
+		}
+
+		void set_budget(std::size_t budget_bytes)
+		{
+			m_budget_bytes = budget_bytes;
+			collect_decoded();
+			evict_to_budget();
+		}
+
+		// Blocks until every requested decode has finished and is resident.
+		void wait_for_decodes()
+		{
+			{
+				auto lock = std::unique_lock{ m_mutex };
+				m_idle.wait(lock, [this] { return m_requests.empty() and not m_decoding; });
+			}
+			collect_decoded();
+			evict_to_budget();
+		}
+
+		auto statistics() const noexcept -> texture_cache_statistics
+		{
+			auto statistics = m_statistics;
+			statistics.resident_bytes = m_resident_bytes;
+			statistics.budget_bytes = m_budget_bytes;
+			statistics.resident_textures = m_lru.size();
+			return statistics;
+		}
+
+	private:
+		// A resident texture has either its pixels or, when the cache
+		// compresses textures, only its compressed blocks.
+		struct entry
+		{
+			std::filesystem::path path;
+			std::unique_ptr<upng::upng_texture> pixels;
+			std::unique_ptr<block_compressed_texture> compressed;
+			bool decode_requested = false;
+			// Set when decoding failed, which stops it being requested again
+			// until it's invalidated.
+			std::exception_ptr decode_error;
+			std::list<texture_handle>::iterator lru_position;
+
+			auto is_resident() const noexcept -> bool { return pixels or compressed; }
+		};
+
+		struct decode_request
+		{
+			texture_handle handle;
+			std::filesystem::path path;
+			texture_encoding encoding;
+		};
+
+		struct decoded
+		{
+			texture_handle handle;
+			texture_encoding encoding;
+			std::unique_ptr<upng::upng_texture> pixels;
+			std::unique_ptr<block_compressed_texture> compressed;
+			std::exception_ptr error;
+		};
+
+		static auto size_in_bytes(const entry& entry) noexcept -> std::size_t
+		{
+			if (entry.compressed)
+				return entry.compressed->size_in_bytes();
+			return std::size_t{ entry.pixels->width() } * entry.pixels->height() * sizeof(std::uint32_t);
+		}
+
+		void request_decode(texture_handle handle)
+		{
+			auto& entry = m_entries[std::to_underlying(handle)];
+			if (entry.decode_requested)
+				return;
+			entry.decode_requested = true;
+			{
+				auto lock = std::scoped_lock{ m_mutex };
+				m_requests.push_back({ handle, entry.path, m_encoding });
+			}
+			m_wake.notify_one();
+		}
+
+		static auto describe(std::exception_ptr error) -> std::string
+		{
+			try
+			{
+				std::rethrow_exception(error);
+			}
+			catch (const std::exception& e)
+			{
+				return e.what();
+			}
+			catch (...)
+			{
+				return "unknown error";
+			}
+		}
+
+		// Makes finished decodes resident, as the most recently used, and
+		// logs the ones that failed. Doesn't evict, so that callers can
+		// first mark what they're about to use as recently used.
+		void collect_decoded()
+		{
+			auto finished = std::vector<decoded>{};
+			{
+				auto lock = std::scoped_lock{ m_mutex };
+				if (m_decoded.empty())
+					return;
+				finished.swap(m_decoded);
+			}
+
+			for (auto&& [handle, encoding, pixels, compressed, decode_error] : finished)
+			{
+				auto& entry = m_entries[std::to_underlying(handle)];
+				entry.decode_requested = false;
+				if (decode_error)
+				{
+					entry.decode_error = decode_error;
+					print_debug_string("Failed to decode {}: {}", entry.path.string(), describe(decode_error));
+					continue;
+				}
+				// Requested before the encoding changed; the next acquire
+				// requests it again.
+				if (encoding != m_encoding)
+					continue;
+				entry.pixels = std::move(pixels);
+				entry.compressed = std::move(compressed);
+				m_resident_bytes += size_in_bytes(entry);
+				m_statistics.decodes++;
+				m_lru.push_front(handle);
+				entry.lru_position = m_lru.begin();
+			}
+		}
+
+		void evict_to_budget()
+		{
+			while (m_resident_bytes > m_budget_bytes and m_lru.size() > 1)
+			{
+				auto& entry = m_entries[std::to_underlying(m_lru.back())];
+				m_resident_bytes -= size_in_bytes(entry);
+				entry.pixels.reset();
+				entry.compressed.reset();
+				m_lru.pop_back();
+				m_statistics.evictions++;
+			}
+		}
+
+		void decode_loop(std::stop_token stop)
+		{
+			auto lock = std::unique_lock{ m_mutex };
+			while (m_wake.wait(lock, stop, [this] { return not m_requests.empty(); }))
+			{
+				auto request = std::move(m_requests.front());
+				m_requests.pop_front();
+				m_decoding = true;
+				lock.unlock();
+
+				auto result = decoded{ .handle = request.handle, .encoding = request.encoding };
+				try
+				{
+					result.pixels = m_disk_cache
+						? std::make_unique<upng::upng_texture>(m_disk_cache->load(request.path))
+						: std::make_unique<upng::upng_texture>(request.path);
+					if (request.encoding == texture_encoding::bc1)
+					{
+						result.compressed = std::make_unique<block_compressed_texture>(
+							result.pixels->uint32_buffer(),
+							result.pixels->width(),
+							result.pixels->height()
+						);
+						result.pixels.reset();
+					}
+				}
+				catch (...)
+				{
+					result.error = std::current_exception();
+				}
+
+				lock.lock();
+				m_decoded.push_back(std::move(result));
+				m_decoding = false;
+				if (m_requests.empty())
+					m_idle.notify_all();
+			}
+		}
+
+		// Only touched by the owning thread.
+		std::size_t m_budget_bytes;
+		texture_encoding m_encoding;
+		texture::selected_texture m_fallback;
+		// Only used by the decoder thread.
+		upng::decoded_texture_cache* m_disk_cache;
+		std::vector<entry> m_entries;
+		// Resident textures, most recently acquired first.
+		std::list<texture_handle> m_lru;
+		std::size_t m_resident_bytes = 0;
+		texture_cache_statistics m_statistics;
+
+		// Shared with the decoder thread.
+		std::mutex m_mutex;
+		std::condition_variable_any m_wake;
+		std::condition_variable m_idle;
+		std::deque<decode_request> m_requests;
+		std::vector<decoded> m_decoded;
+		bool m_decoding = false;
+
+		// Last, so that it's stopped and joined before anything it uses is
+		// destroyed.
+		std::jthread m_decoder;
+	};
+}
@@ -0,0 +1,118 @@
+export module renderer:renderer.viewport;
+import std;
+import :math;
+import :camera;
+import :renderer.mesh;
+import :renderer.display;
+import :renderer.pipeline;
+import :renderer.settings;
+import :renderer.texture;
+import :renderer.buffer_2d;
+import :renderer.screenrect;
+
+export namespace renderer
+{
+	// One view of the scene: a camera, the projection it sees through,
+	// and the rectangle of the window its image is composited into.
+	//
+	// Each viewport rasterizes into a frame buffer of its own, sized to its
+	// rectangle, so that several can be rendered at once without any two
+	// writing to the same memory. Compositing copies each into its part of
+	// the window's texture, which a single view copies its frame into
+	// anyway, so splitting the window costs no extra copies.
+	class viewport final
+	{
+	public:
+		viewport(camera_t camera, radians field_of_view, screen_rect rect)
+			: m_camera{ camera },
+			  m_field_of_view{ field_of_view },
+			  m_rect{ rect },
+			  m_projection{ projection_for(field_of_view, rect) },
+			  m_frame{ std::max(rect.width, 1u), std::max(rect.height, 1u) }
+		{ }
+
+		auto camera(this auto&& self) noexcept -> decltype(auto) { return std::forward_like<decltype(self)>(self.m_camera); }
+		auto frame(this auto&& self) noexcept -> decltype(auto) { return std::forward_like<decltype(self)>(self.m_frame); }
+		auto rect() const noexcept -> const screen_rect& { return m_rect; }
+
+		// Moves or resizes the viewport, e.g. when the window's layout
+		// changes. The projection follows the new aspect ratio.
+		void set_rect(const screen_rect& rect)
+		{
+			m_rect = rect;
+			m_projection = projection_for(m_field_of_view, rect);
+			m_frame.resize(std::max(rect.width, 1u), std::max(rect.height, 1u));
+		}
+
+		auto view(cull_mode culling) const noexcept -> view_parameters
+		{
+			return {
+				.camera = m_camera,
+				.projection = m_projection,
+				.width = m_frame.color.width(),
+				.height = m_frame.color.height(),
+				.culling = culling
+			};
+		}
+
+		// Projects the mesh through this viewport's camera and rasterizes
+		// it into the viewport's frame, which is cleared first. The mesh and
+		// texture are only read, so any number of viewports can render the
+		// same ones concurrently, as long as each thread has its own arena.
+		void render(
+			const mesh& mesh,
+			texture::selected_texture texture,
+			const settings& render_settings,
+			std::pmr::memory_resource& arena
+		)
+		{
+			auto triangles = project_mesh(mesh, view(render_settings.culling_mode), arena);
+			m_frame.clear_color_buffer(0xff000000).clear_z_buffer();
+			draw_dot_grid(10, 0xff464646, m_frame);
+			draw_triangles(triangles, texture, render_settings, m_frame);
+		}
+
+	private:
+		static auto projection_for(radians field_of_view, const screen_rect& rect) noexcept -> projective_perspective_divide_matrix
+		{
+			return {
+				field_of_view,
+				static_cast<float>(std::max(rect.width, 1u)) / static_cast<float>(std::max(rect.height, 1u)),
+				0.1f,
+				100.f
+			};
+		}
+
+		camera_t m_camera;
+		radians m_field_of_view;
+		screen_rect m_rect;
+		projective_perspective_divide_matrix m_projection;
+		frame_buffer m_frame;
+	};
+
+	// Splits an area into a 2x2 grid of rectangles that cover it exactly,
+	// in the order top left, top right, bottom left, bottom right.
+	constexpr auto quad_layout(std::uint32_t width, std::uint32_t height) noexcept -> std::array<screen_rect, 4>
+	{
+		auto left_width = width / 2;
+		auto top_height = height / 2;
+		return {
+			screen_rect{ 0, 0, left_width, top_height },
+			screen_rect{ left_width, 0, width - left_width, top_height },
+			screen_rect{ 0, top_height, left_width, height - top_height },
+			screen_rect{ left_width, top_height, width - left_width, height - top_height }
+		};
+	}
+}
+
+static_assert(
+	[]{
+		auto [top_left, top_right, bottom_left, bottom_right] = renderer::quad_layout(1921, 1081);
+		auto area = [](const renderer::screen_rect& rect) { return std::uint64_t{ rect.width } * rect.height; };
+		return top_left.united(bottom_right) == renderer::screen_rect{ 0, 0, 1921, 1081 }
+			and top_right.x == top_left.right()
+			and bottom_left.y == top_left.bottom()
+			and area(top_left) + area(top_right) + area(bottom_left) + area(bottom_right) == 1921ull * 1081;
+	}(),
+	"A quad layout is expected to cover the whole area without overlapping, whatever its size."
+);
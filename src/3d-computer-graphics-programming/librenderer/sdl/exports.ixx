@@ -18,6 +18,7 @@ export
 		::SDL_CreateWindow,
 		::SDL_CreateRenderer,
 		::SDL_PollEvent,
+		::SDL_WaitEventTimeout,
 		::SDL_SetRenderDrawColor,
 		::SDL_RenderClear,
 		::SDL_RenderCopy,
@@ -29,6 +30,10 @@ export
 		::SDL_CreateTexture,
 		::SDL_DestroyTexture,
 		::SDL_UpdateTexture,
+		::SDL_LockTexture,
+		::SDL_UnlockTexture,
+		::SDL_QueryTexture,
+		::SDL_SetTextureScaleMode,
 		::SDL_GetCurrentDisplayMode,
 		::SDL_GetDisplayMode,
 		::SDL_SetWindowFullscreen,
@@ -46,11 +51,14 @@ export
 		::SDL_Texture,
 		::SDL_Event,
 		::SDL_EventType,
+		::SDL_WindowEventID,
 		::SDL_KeyCode,
 		::SDL_Keycode,
 		::SDL_WindowFlags,
 		::SDL_PixelFormatEnum,
 		::SDL_TextureAccess,
-		::SDL_DisplayMode
+		::SDL_DisplayMode,
+		::SDL_Rect,
+		::SDL_ScaleMode
 		;
 }
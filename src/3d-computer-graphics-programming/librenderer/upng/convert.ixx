@@ -0,0 +1,224 @@
+module;
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+
+// GCC and Clang only accept intrinsics beyond the target's baseline in
+// functions that ask for them; MSVC accepts them anywhere.
+#ifdef _MSC_VER
+#define RENDERER_TARGET(isa)
+#else
+#define RENDERER_TARGET(isa) [[gnu::target(isa)]]
+#endif
+
+export module renderer:upng.convert;
+import std;
+import :upng.exports;
+import :upng.error;
+import :renderer.pixelformat;
+
+// Conversions from every upng_format into the renderer's native pixel
+// format. These run once when a texture is loaded. The byte-aligned
+// formats are converted 4 to 16 pixels at a time with SSE2 (SSSE3 for
+// RGB8, whose 3-byte pixels need a byte shuffle); the bit-packed
+// luminance formats and RGB16 are rare enough to stay scalar.
+namespace
+{
+	static_assert(
+		renderer::native_pixel_format == renderer::pixel_format::argb8888,
+		"The conversion routines below write 0xAARRGGBB pixels.");
+
+	// ECX of CPUID leaf 1, which flags SSE3 onwards.
+	auto cpuid_features() noexcept -> unsigned
+	{
+#ifdef _MSC_VER
+		int info[4]{};
+		__cpuid(info, 1);
+		return static_cast<unsigned>(info[2]);
+#else
+		unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+		return __get_cpuid(1, &eax, &ebx, &ecx, &edx) ? ecx : 0;
+#endif
+	}
+
+	auto has_ssse3() noexcept -> bool
+	{
+		static const bool value =
+			[] static
+			{
+				return (cpuid_features() & (1u << 9)) != 0;
+			}();
+		return value;
+	}
+
+	// Read as little-endian words, RGBA bytes are 0xAABBGGRR, so only
+	// red and blue have to trade places to get 0xAARRGGBB.
+	auto swap_red_blue(__m128i pixels) noexcept -> __m128i
+	{
+		const auto green_alpha = _mm_set1_epi32(static_cast<int>(0xff00ff00));
+		const auto low_byte = _mm_set1_epi32(0x000000ff);
+		auto red = _mm_slli_epi32(_mm_and_si128(pixels, low_byte), 16);
+		auto blue = _mm_and_si128(_mm_srli_epi32(pixels, 16), low_byte);
+		return _mm_or_si128(_mm_and_si128(pixels, green_alpha), _mm_or_si128(red, blue));
+	}
+
+	void rgba8_to_native(const std::uint8_t* in, std::uint32_t* out, std::size_t count) noexcept
+	{
+		auto i = std::size_t{ 0 };
+		for (; i + 4 <= count; i += 4)
+		{
+			auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), swap_red_blue(pixels));
+		}
+		for (; i < count; i++)
+			out[i] = renderer::pack_argb(in[i * 4 + 3], in[i * 4], in[i * 4 + 1], in[i * 4 + 2]);
+	}
+
+	// Returns how many pixels it converted, leaving the rest to the
+	// scalar loop.
+	RENDERER_TARGET("ssse3") auto rgb8_to_native_ssse3(const std::uint8_t* in, std::uint32_t* out, std::size_t count) noexcept -> std::size_t
+	{
+		// Each iteration consumes 12 bytes but loads 16, so stop early
+		// enough that the load never reads past the end of the image.
+		const auto shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		const auto alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+		auto i = std::size_t{ 0 };
+		for (; i + 6 <= count; i += 4)
+		{
+			auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 3));
+			pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), pixels);
+		}
+		return i;
+	}
+
+	void rgb8_to_native(const std::uint8_t* in, std::uint32_t* out, std::size_t count) noexcept
+	{
+		auto i = has_ssse3() ? rgb8_to_native_ssse3(in, out, count) : std::size_t{ 0 };
+		for (; i < count; i++)
+			out[i] = renderer::pack_argb(0xff, in[i * 3], in[i * 3 + 1], in[i * 3 + 2]);
+	}
+
+	// 16-bit channels are big-endian, so the most significant byte of a
+	// channel comes first; only that byte is kept.
+	void rgba16_to_native(const std::uint8_t* in, std::uint32_t* out, std::size_t count) noexcept
+	{
+		const auto high_bytes = _mm_set1_epi16(0x00ff);
+		auto i = std::size_t{ 0 };
+		for (; i + 4 <= count; i += 4)
+		{
+			auto first = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 8)), high_bytes);
+			auto second = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 8 + 16)), high_bytes);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), swap_red_blue(_mm_packus_epi16(first, second)));
+		}
+		for (; i < count; i++)
+			out[i] = renderer::pack_argb(in[i * 8 + 6], in[i * 8], in[i * 8 + 2], in[i * 8 + 4]);
+	}
+
+	void rgb16_to_native(const std::uint8_t* in, std::uint32_t* out, std::size_t count) noexcept
+	{
+		for (auto i = std::size_t{ 0 }; i < count; i++)
+			out[i] = renderer::pack_argb(0xff, in[i * 6], in[i * 6 + 2], in[i * 6 + 4]);
+	}
+
+	void luminance8_to_native(const std::uint8_t* in, std::uint32_t* out, std::size_t count) noexcept
+	{
+		const auto opaque = _mm_set1_epi8(static_cast<char>(0xff));
+		auto i = std::size_t{ 0 };
+		for (; i + 16 <= count; i += 16)
+		{
+			auto luminance = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+			// L L pairs interleaved with L A pairs give the bytes L L L A.
+			auto low_ll = _mm_unpacklo_epi8(luminance, luminance);
+			auto low_la = _mm_unpacklo_epi8(luminance, opaque);
+			auto high_ll = _mm_unpackhi_epi8(luminance, luminance);
+			auto high_la = _mm_unpackhi_epi8(luminance, opaque);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(low_ll, low_la));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(low_ll, low_la));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpacklo_epi16(high_ll, high_la));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 12), _mm_unpackhi_epi16(high_ll, high_la));
+		}
+		for (; i < count; i++)
+			out[i] = renderer::pack_argb(0xff, in[i], in[i], in[i]);
+	}
+
+	void luminance_alpha8_to_native(const std::uint8_t* in, std::uint32_t* out, std::size_t count) noexcept
+	{
+		const auto low_bytes = _mm_set1_epi16(0x00ff);
+		auto i = std::size_t{ 0 };
+		for (; i + 8 <= count; i += 8)
+		{
+			auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2));
+			auto luminance = _mm_and_si128(pixels, low_bytes);
+			auto ll = _mm_or_si128(luminance, _mm_slli_epi16(luminance, 8));
+			// Interleaving the L L words with the original L A words gives L L L A.
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(ll, pixels));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(ll, pixels));
+		}
+		for (; i < count; i++)
+			out[i] = renderer::pack_argb(in[i * 2 + 1], in[i * 2], in[i * 2], in[i * 2]);
+	}
+
+	// upng leaves bit-packed images as one continuous, most significant
+	// bit first, bit stream without any row padding. A sample is 1, 2 or
+	// 4 bits wide, so it never straddles a byte.
+	void packed_to_native(const std::uint8_t* in, std::uint32_t* out, std::size_t count, std::uint32_t bits, bool has_alpha) noexcept
+	{
+		const auto mask = (1u << bits) - 1;
+		auto bit = std::size_t{ 0 };
+		auto read = [&] -> std::uint32_t
+		{
+			auto value = (in[bit >> 3] >> (8 - bits - (bit & 7))) & mask;
+			bit += bits;
+			return value * 255 / mask;
+		};
+		for (auto i = std::size_t{ 0 }; i < count; i++)
+		{
+			auto luminance = read();
+			auto alpha = has_alpha ? read() : 0xffu;
+			out[i] = renderer::pack_argb(alpha, luminance, luminance, luminance);
+		}
+	}
+}
+
+export namespace upng
+{
+	// Converts count pixels of a decoded upng image into the renderer's
+	// native pixel format.
+	void convert_to_native(upng_format format, const unsigned char* source, std::size_t count, std::uint32_t* destination)
+	{
+		switch (format)
+		{
+			case upng_format::UPNG_RGBA8:
+				return rgba8_to_native(source, destination, count);
+			case upng_format::UPNG_RGB8:
+				return rgb8_to_native(source, destination, count);
+			case upng_format::UPNG_RGBA16:
+				return rgba16_to_native(source, destination, count);
+			case upng_format::UPNG_RGB16:
+				return rgb16_to_native(source, destination, count);
+			case upng_format::UPNG_LUMINANCE8:
+				return luminance8_to_native(source, destination, count);
+			case upng_format::UPNG_LUMINANCE_ALPHA8:
+				return luminance_alpha8_to_native(source, destination, count);
+			case upng_format::UPNG_LUMINANCE1:
+				return packed_to_native(source, destination, count, 1, false);
+			case upng_format::UPNG_LUMINANCE2:
+				return packed_to_native(source, destination, count, 2, false);
+			case upng_format::UPNG_LUMINANCE4:
+				return packed_to_native(source, destination, count, 4, false);
+			case upng_format::UPNG_LUMINANCE_ALPHA1:
+				return packed_to_native(source, destination, count, 1, true);
+			case upng_format::UPNG_LUMINANCE_ALPHA2:
+				return packed_to_native(source, destination, count, 2, true);
+			case upng_format::UPNG_LUMINANCE_ALPHA4:
+				return packed_to_native(source, destination, count, 4, true);
+			default:
+				throw error(upng_error::UPNG_EUNFORMAT, "Cannot convert PNG to the native pixel format");
+		}
+	}
+}
@@ -0,0 +1,317 @@
+export module renderer:upng.diskcache;
+import std;
+import :upng.exports;
+import :upng.texture;
+import :renderer.pixelformat;
+import :win32.mappedfile;
+
+// Each cached texture is a single file: a fixed-size header followed by
+// the texture's pixels in the native format, row-major and unpadded, so
+// that a mapped entry can be sampled in place.
+namespace
+{
+	constexpr auto entry_extension = std::string_view{ ".texcache" };
+	constexpr auto entry_magic = std::array<char, 8>{ 'R', 'T', 'E', 'X', 'C', 'A', 'C', 'H' };
+	constexpr auto entry_version = std::uint32_t{ 1 };
+
+	struct entry_header
+	{
+		std::array<char, 8> magic = entry_magic;
+		std::uint32_t version = entry_version;
+		std::uint32_t pixel_format = 0;
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		std::uint32_t source_format = 0;
+		std::uint32_t reserved = 0;
+		// What the PNG was when the entry was written. The size and write
+		// time are checked on every load; the hash of its contents only
+		// when they don't match, e.g. after a checkout rewrote the file
+		// without changing it.
+		std::uint64_t source_size = 0;
+		std::int64_t source_write_time = 0;
+		std::uint64_t source_hash = 0;
+		std::array<std::byte, 8> padding{};
+	};
+	// A multiple of the pixel size, so the pixels after it stay aligned.
+	static_assert(sizeof(entry_header) == 64);
+
+	// 64-bit FNV-1a. Not cryptographic, but a changed PNG colliding with
+	// the one it replaced isn't something to guard against.
+	constexpr auto fnv1a(std::span<const unsigned char> bytes) noexcept -> std::uint64_t
+	{
+		auto hash = std::uint64_t{ 14695981039346656037ull };
+		for (auto byte : bytes)
+		{
+			hash ^= byte;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	auto write_time_of(const std::filesystem::path& path) -> std::int64_t
+	{
+		return std::filesystem::last_write_time(path).time_since_epoch().count();
+	}
+
+	auto read_file(const std::filesystem::path& path) -> std::vector<unsigned char>
+	{
+		auto file = std::ifstream{ path, std::ios::binary };
+		if (not file)
+			throw std::runtime_error(std::format("Failed to open {}", path.string()));
+		return { std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	}
+
+	auto read_header(const std::filesystem::path& path) -> std::optional<entry_header>
+	{
+		auto file = std::ifstream{ path, std::ios::binary };
+		auto header = entry_header{};
+		if (not file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+			return std::nullopt;
+		if (header.magic != entry_magic
+			or header.version != entry_version
+			or header.pixel_format != static_cast<std::uint32_t>(std::to_underlying(renderer::native_pixel_format)))
+			return std::nullopt;
+		return header;
+	}
+
+	auto pixels_size(const entry_header& header) noexcept -> std::size_t
+	{
+		return std::size_t{ header.width } * header.height * sizeof(std::uint32_t);
+	}
+}
+
+export namespace upng
+{
+	struct decoded_texture_cache_statistics
+	{
+		// Loads that mapped an entry, including ones whose PNG had to be
+		// hashed to confirm it hadn't changed.
+		std::uint64_t hits = 0;
+		// Loads that decoded the PNG, and wrote an entry for it.
+		std::uint64_t misses = 0;
+		// Entries deleted to stay within the size cap.
+		std::uint64_t evictions = 0;
+		// Entries that couldn't be written, e.g. because the disk is full.
+		// The texture is still loaded; it's just decoded again next time.
+		std::uint64_t write_failures = 0;
+		// Stale entries left in place, rather than replaced or updated,
+		// because a texture mapped from them was still loaded. They're
+		// replaced by the first load after it's released.
+		std::uint64_t busy_entries = 0;
+	};
+
+	// Keeps decoded textures on disk, so that loading a PNG that's been
+	// loaded before maps its pixels instead of inflating and unfiltering it
+	// again, and costs no more than paging them in.
+	//
+	// Entries are named after the PNG's path and remember its size, write
+	// time and a hash of its contents, so a PNG that changes is decoded
+	// again and its entry replaced. Entries are written to a temporary file
+	// and renamed into place, so a crash never leaves a torn one. When the
+	// entries exceed the size cap, the least recently loaded are deleted.
+	// Windows doesn't let a mapped file be written, renamed over or
+	// deleted, so entries that loaded textures are still mapped from are
+	// left alone until those textures are released.
+	//
+	// load() can be called from any thread.
+	class decoded_texture_cache final
+	{
+	public:
+		decoded_texture_cache(std::filesystem::path directory, std::uintmax_t size_cap_bytes)
+			: m_directory{ std::move(directory) },
+			  m_size_cap_bytes{ size_cap_bytes }
+		{
+			std::filesystem::create_directories(m_directory);
+		}
+
+		decoded_texture_cache(const decoded_texture_cache&) = delete;
+		auto operator=(const decoded_texture_cache&) -> decoded_texture_cache& = delete;
+
+		auto load(const std::filesystem::path& png_path) -> upng_texture
+		{
+			auto source_size = std::filesystem::file_size(png_path);
+			auto source_write_time = write_time_of(png_path);
+			auto entry = entry_path(png_path);
+
+			auto header = read_header(entry);
+			if (header and header->source_size == source_size and header->source_write_time == source_write_time)
+				if (auto texture = map(entry, *header))
+					return std::move(*texture);
+
+			auto bytes = read_file(png_path);
+			auto source_hash = fnv1a(bytes);
+			if (header and header->source_size == source_size and header->source_hash == source_hash)
+			{
+				// Same contents, new write time: note it so that the next
+				// load doesn't have to hash the PNG again.
+				header->source_write_time = source_write_time;
+				rewrite_header(entry, *header);
+				if (auto texture = map(entry, *header))
+					return std::move(*texture);
+			}
+
+			auto texture = upng_texture{ std::span{ bytes } };
+			m_misses++;
+			store(entry, texture, {
+				.pixel_format = static_cast<std::uint32_t>(std::to_underlying(texture.pixel_format())),
+				.width = texture.width(),
+				.height = texture.height(),
+				.source_format = static_cast<std::uint32_t>(texture.format()),
+				.source_size = source_size,
+				.source_write_time = source_write_time,
+				.source_hash = source_hash
+			});
+			return texture;
+		}
+
+		auto statistics() const noexcept -> decoded_texture_cache_statistics
+		{
+			return {
+				.hits = m_hits,
+				.misses = m_misses,
+				.evictions = m_evictions,
+				.write_failures = m_write_failures,
+				.busy_entries = m_busy_entries
+			};
+		}
+
+	private:
+		auto entry_path(const std::filesystem::path& png_path) const -> std::filesystem::path
+		{
+			auto key = std::filesystem::weakly_canonical(png_path).u8string();
+			auto hash = fnv1a({ reinterpret_cast<const unsigned char*>(key.data()), key.size() });
+			return m_directory / std::format("{:016x}{}", hash, entry_extension);
+		}
+
+		// Returns nothing if the entry is missing, truncated or can't be
+		// mapped, in which case the PNG is decoded instead.
+		auto map(const std::filesystem::path& entry, const entry_header& header) -> std::optional<upng_texture>
+		{
+			try
+			{
+				// Locked so that the entry can't be replaced between being
+				// opened and being noted as mapped.
+				auto lock = std::scoped_lock{ m_mutex };
+				auto file = std::make_shared<const win32::mapped_file>(entry);
+				if (file->size() != sizeof(entry_header) + pixels_size(header))
+					return std::nullopt;
+				std::erase_if(m_mapped, [](auto&& mapped) { return mapped.second.expired(); });
+				m_mapped.insert_or_assign(entry, file);
+
+				// Entries loaded last are evicted last.
+				auto error = std::error_code{};
+				std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), error);
+
+				auto pixels = reinterpret_cast<const std::uint32_t*>(file->data() + sizeof(entry_header));
+				m_hits++;
+				return upng_texture{
+					std::move(file),
+					pixels,
+					header.width,
+					header.height,
+					static_cast<upng_format>(header.source_format)
+				};
+			}
+			catch (const std::system_error&)
+			{
+				return std::nullopt;
+			}
+		}
+
+		// Whether a loaded texture is still mapped from the entry. Must be
+		// called with m_mutex held.
+		auto is_mapped(const std::filesystem::path& entry) const -> bool
+		{
+			auto mapped = m_mapped.find(entry);
+			return mapped != m_mapped.end() and not mapped->second.expired();
+		}
+
+		void rewrite_header(const std::filesystem::path& entry, const entry_header& header)
+		{
+			auto lock = std::scoped_lock{ m_mutex };
+			if (is_mapped(entry))
+			{
+				m_busy_entries++;
+				return;
+			}
+			auto file = std::fstream{ entry, std::ios::binary | std::ios::in | std::ios::out };
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		}
+
+		void store(const std::filesystem::path& entry, const upng_texture& texture, const entry_header& header)
+		{
+			auto lock = std::scoped_lock{ m_mutex };
+			if (is_mapped(entry))
+			{
+				m_busy_entries++;
+				return;
+			}
+			try
+			{
+				auto temporary = std::filesystem::path{ entry }.replace_extension(".tmp");
+				{
+					auto file = std::ofstream{ temporary, std::ios::binary | std::ios::trunc };
+					file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+					file.write(reinterpret_cast<const char*>(texture.uint32_buffer()), static_cast<std::streamsize>(pixels_size(header)));
+					if (not file.flush())
+						throw std::runtime_error(std::format("Failed to write {}", temporary.string()));
+				}
+				std::filesystem::rename(temporary, entry);
+				evict_to_cap(entry);
+			}
+			catch (const std::exception&)
+			{
+				// The cache only saves time; failing to fill it is no
+				// reason to fail the load.
+				m_write_failures++;
+			}
+		}
+
+		// Deletes the least recently loaded entries until the rest fit
+		// within the cap, but never the one just written or ones that are
+		// still mapped.
+		void evict_to_cap(const std::filesystem::path& keep)
+		{
+			struct cached
+			{
+				std::filesystem::path path;
+				std::uintmax_t size;
+				std::filesystem::file_time_type last_used;
+			};
+			auto entries = std::vector<cached>{};
+			auto total = std::uintmax_t{ 0 };
+			for (auto&& file : std::filesystem::directory_iterator{ m_directory })
+			{
+				if (not file.is_regular_file() or file.path().extension() != entry_extension)
+					continue;
+				entries.push_back({ file.path(), file.file_size(), file.last_write_time() });
+				total += file.file_size();
+			}
+
+			std::ranges::sort(entries, std::less{}, &cached::last_used);
+			for (auto&& [path, size, last_used] : entries)
+			{
+				if (total <= m_size_cap_bytes)
+					break;
+				auto error = std::error_code{};
+				if (path == keep or is_mapped(path) or not std::filesystem::remove(path, error))
+					continue;
+				total -= size;
+				m_evictions++;
+			}
+		}
+
+		std::filesystem::path m_directory;
+		std::uintmax_t m_size_cap_bytes;
+		// Serialises writes to the directory, and guards m_mapped.
+		std::mutex m_mutex;
+		// The entries that textures were mapped from, which may since have
+		// been released.
+		std::map<std::filesystem::path, std::weak_ptr<const win32::mapped_file>> m_mapped;
+		std::atomic<std::uint64_t> m_hits = 0;
+		std::atomic<std::uint64_t> m_misses = 0;
+		std::atomic<std::uint64_t> m_evictions = 0;
+		std::atomic<std::uint64_t> m_write_failures = 0;
+		std::atomic<std::uint64_t> m_busy_entries = 0;
+	};
+}
@@ -3,6 +3,8 @@ import std;
 import :raii;
 import :upng.exports;
 import :upng.error;
+import :upng.convert;
+import :renderer.pixelformat;
 
 export namespace upng
 {
@@ -13,20 +15,77 @@ export namespace upng
 	public:
 		upng_texture(const std::filesystem::path& path)
 		{
-			png = upng_unique_ptr{ upng_new_from_file(path.string().c_str()) };
+			auto png = upng_unique_ptr{ upng_new_from_file(path.string().c_str()) };
 			if (not png)
 				throw std::runtime_error("Failed to load PNG from file");
-			if (auto result = upng_decode(png.get()); result != UPNG_EOK)
-				throw error(result, "Failed to decode PNG");
+			decode(png.get());
+		}
+
+		// Decodes a PNG already read into memory.
+		explicit upng_texture(std::span<const unsigned char> png_bytes)
+		{
+			auto png = upng_unique_ptr{ upng_new_from_bytes(png_bytes.data(), static_cast<unsigned long>(png_bytes.size())) };
+			if (not png)
+				throw std::runtime_error("Failed to load PNG from memory");
+			decode(png.get());
 		}
 
-		auto buffer() const noexcept -> const unsigned char* { return upng_get_buffer(png.get()); }
-		auto uint32_buffer() const noexcept -> const std::uint32_t* { return reinterpret_cast<const std::uint32_t*>(upng_get_buffer(png.get())); }
-		auto width() const noexcept -> std::uint32_t { return upng_get_width(png.get()); }
-		auto height() const noexcept -> std::uint32_t { return upng_get_height(png.get()); }
-		auto format() const noexcept -> upng_format { return upng_get_format(png.get()); }
+		// Wraps pixels that are already decoded and in the native format,
+		// e.g. mapped from a decoded_texture_cache entry. storage owns them
+		// and is kept alive with the texture.
+		upng_texture(
+			std::shared_ptr<const void> storage,
+			const std::uint32_t* pixels,
+			std::uint32_t width,
+			std::uint32_t height,
+			upng_format source_format
+		) : m_width{ width },
+			m_height{ height },
+			m_source_format{ source_format },
+			m_storage{ std::move(storage) },
+			m_data{ pixels }
+		{ }
+
+		// Moving keeps the pixels where they are, so that pointers to them
+		// stay valid; a copy would point at the original's.
+		upng_texture(upng_texture&&) noexcept = default;
+		auto operator=(upng_texture&&) noexcept -> upng_texture& = default;
+		upng_texture(const upng_texture&) = delete;
+		auto operator=(const upng_texture&) -> upng_texture& = delete;
+
+		auto buffer() const noexcept -> const unsigned char* { return reinterpret_cast<const unsigned char*>(m_data); }
+		auto uint32_buffer() const noexcept -> const std::uint32_t* { return m_data; }
+		auto width() const noexcept -> std::uint32_t { return m_width; }
+		auto height() const noexcept -> std::uint32_t { return m_height; }
+		// The format of the source PNG.
+		auto format() const noexcept -> upng_format { return m_source_format; }
+		// The format of the pixels returned by buffer() and uint32_buffer().
+		auto pixel_format() const noexcept -> renderer::pixel_format { return m_pixel_format; }
 
 	private:
-		upng_unique_ptr png;
+		void decode(upng_t* png)
+		{
+			if (auto result = upng_decode(png); result != UPNG_EOK)
+				throw error(result, "Failed to decode PNG");
+
+			m_width = upng_get_width(png);
+			m_height = upng_get_height(png);
+			m_source_format = upng_get_format(png);
+			// Convert to the framebuffer's format once, here, so that texel
+			// fetches are a single load and nothing is swizzled per frame.
+			// The decoded upng image isn't needed after this.
+			m_pixels.resize(std::size_t{ m_width } * m_height);
+			convert_to_native(m_source_format, upng_get_buffer(png), m_pixels.size(), m_pixels.data());
+			m_data = m_pixels.data();
+		}
+
+		std::uint32_t m_width = 0;
+		std::uint32_t m_height = 0;
+		upng_format m_source_format = upng_format::UPNG_BADFORMAT;
+		renderer::pixel_format m_pixel_format = renderer::native_pixel_format;
+		// The pixels are either decoded into m_pixels or owned by m_storage.
+		std::vector<std::uint32_t> m_pixels;
+		std::shared_ptr<const void> m_storage;
+		const std::uint32_t* m_data = nullptr;
 	};
 }
@@ -3,4 +3,8 @@ import std;
 export import :upng.exports;
 export import :upng.formatters;
 export import :upng.error;
+export import :upng.convert;
 export import :upng.texture;
+#ifndef RENDERER_PORTABLE
+export import :upng.diskcache;
+#endif
@@ -0,0 +1,57 @@
+export module renderer:util.alignedallocator;
+import std;
+
+export namespace renderer
+{
+	// An allocator that over-aligns its storage, e.g. to a cache line.
+	// Aligned operator new is not usable in constant evaluation, so we
+	// fall back to std::allocator there; this keeps the containers that
+	// use it testable through static_assert.
+	template<typename T, std::size_t VAlignment>
+	struct aligned_allocator
+	{
+		static_assert(std::has_single_bit(VAlignment), "Alignment must be a power of two.");
+		static_assert(VAlignment >= alignof(T), "Alignment must not be weaker than the type's natural alignment.");
+
+		using value_type = T;
+
+		// Required as allocator_traits can't rebind templates with non-type parameters.
+		template<typename U>
+		struct rebind { using other = aligned_allocator<U, VAlignment>; };
+
+		constexpr aligned_allocator() noexcept = default;
+
+		template<typename U>
+		constexpr aligned_allocator(const aligned_allocator<U, VAlignment>&) noexcept {}
+
+		[[nodiscard]] constexpr auto allocate(std::size_t count) -> T*
+		{
+			if consteval
+			{
+				return std::allocator<T>{}.allocate(count);
+			}
+			else
+			{
+				return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{ VAlignment }));
+			}
+		}
+
+		constexpr void deallocate(T* pointer, std::size_t count) noexcept
+		{
+			if consteval
+			{
+				std::allocator<T>{}.deallocate(pointer, count);
+			}
+			else
+			{
+				::operator delete(pointer, count * sizeof(T), std::align_val_t{ VAlignment });
+			}
+		}
+
+		template<typename U>
+		constexpr auto operator==(const aligned_allocator<U, VAlignment>&) const noexcept -> bool
+		{
+			return true;
+		}
+	};
+}
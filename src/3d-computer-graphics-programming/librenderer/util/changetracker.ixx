@@ -0,0 +1,46 @@
+export module renderer:util.changetracker;
+import std;
+
+export namespace renderer
+{
+	// Remembers the last value it was given so that work derived from the
+	// value can be skipped while it stays the same, e.g. rendering a frame
+	// whose inputs haven't changed since the last one.
+	template<std::equality_comparable T>
+	class change_tracker
+	{
+	public:
+		// Records the value and returns true if it differs from the last
+		// one recorded, or if there's none since construction or the last
+		// invalidate().
+		constexpr auto update(const T& value) -> bool
+		{
+			if (m_last and *m_last == value)
+				return false;
+			m_last = value;
+			return true;
+		}
+
+		// Makes the next update() report a change whatever its value.
+		constexpr void invalidate() noexcept
+		{
+			m_last.reset();
+		}
+
+	private:
+		std::optional<T> m_last;
+	};
+}
+
+static_assert(
+	[]{
+		auto tracker = renderer::change_tracker<int>{};
+		auto first = tracker.update(1);
+		auto same = tracker.update(1);
+		auto different = tracker.update(2);
+		tracker.invalidate();
+		auto after_invalidate = tracker.update(2);
+		return first and not same and different and after_invalidate;
+	}(),
+	"Only new values, and any value after invalidate(), are expected to count as changes."
+);
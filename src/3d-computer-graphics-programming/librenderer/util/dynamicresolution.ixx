@@ -0,0 +1,137 @@
+export module renderer:util.dynamicresolution;
+import std;
+
+export namespace renderer
+{
+	struct dynamic_resolution_settings
+	{
+		// The bounds and step of the scale applied to each axis of the
+		// output resolution.
+		float min_scale = 0.5f;
+		float max_scale = 1.f;
+		float step = 0.1f;
+		// How many frames' raster times are averaged before each decision,
+		// so a single slow frame doesn't change the resolution.
+		std::uint32_t frames_per_adjustment = 30;
+		// Only step up when the raster time predicted for the larger scale
+		// is within this fraction of the budget, which keeps the scale from
+		// flipping back and forth between two steps.
+		float headroom = 0.9f;
+	};
+
+	// Picks the internal rendering resolution from how long rasterizing
+	// recent frames took. Raster cost is roughly proportional to the number
+	// of pixels, so the scale steps down while the average raster time is
+	// over the budget and steps up once the time predicted for the next
+	// step up, the average scaled by the ratio of areas, would fit in it.
+	class dynamic_resolution
+	{
+	public:
+		constexpr explicit dynamic_resolution(std::chrono::nanoseconds budget, dynamic_resolution_settings settings = {})
+			: m_settings{ settings },
+			  m_budget{ budget },
+			  m_scale{ settings.max_scale }
+		{ }
+
+		// The raster time to fit each frame into. Zero disables scaling
+		// and renders at max_scale.
+		constexpr void set_budget(std::chrono::nanoseconds budget) noexcept
+		{
+			if (budget == m_budget)
+				return;
+			m_budget = budget;
+			restart_window();
+			if (budget <= std::chrono::nanoseconds{ 0 })
+				m_scale = m_settings.max_scale;
+		}
+
+		constexpr auto budget() const noexcept -> std::chrono::nanoseconds { return m_budget; }
+		constexpr auto scale() const noexcept -> float { return m_scale; }
+		constexpr auto settings() const noexcept -> const dynamic_resolution_settings& { return m_settings; }
+
+		// A full-resolution extent scaled by the current scale.
+		constexpr auto scaled(std::uint32_t extent) const noexcept -> std::uint32_t
+		{
+			return std::max(std::uint32_t{ 1 }, static_cast<std::uint32_t>(static_cast<float>(extent) * m_scale));
+		}
+
+		// Records how long rasterizing a frame took. Returns true if the
+		// scale changed, in which case the next frame should be rendered at
+		// the new resolution.
+		constexpr auto record(std::chrono::nanoseconds raster_time) noexcept -> bool
+		{
+			if (m_budget <= std::chrono::nanoseconds{ 0 })
+				return false;
+			m_total += raster_time;
+			if (++m_frames < m_settings.frames_per_adjustment)
+				return false;
+
+			auto average = static_cast<float>(m_total.count()) / static_cast<float>(m_frames);
+			auto budget = static_cast<float>(m_budget.count());
+			restart_window();
+
+			auto next_scale = m_scale;
+			if (average > budget)
+			{
+				next_scale = std::max(m_settings.min_scale, m_scale - m_settings.step);
+			}
+			else
+			{
+				auto up = std::min(m_settings.max_scale, m_scale + m_settings.step);
+				auto area_ratio = (up * up) / (m_scale * m_scale);
+				if (average * area_ratio <= budget * m_settings.headroom)
+					next_scale = up;
+			}
+
+			if (next_scale == m_scale)
+				return false;
+			m_scale = next_scale;
+			return true;
+		}
+
+	private:
+		constexpr void restart_window() noexcept
+		{
+			m_total = std::chrono::nanoseconds{ 0 };
+			m_frames = 0;
+		}
+
+		dynamic_resolution_settings m_settings;
+		std::chrono::nanoseconds m_budget;
+		float m_scale;
+		std::chrono::nanoseconds m_total{ 0 };
+		std::uint32_t m_frames = 0;
+	};
+}
+
+static_assert(
+	[]{
+		using namespace std::chrono_literals;
+		auto resolution = renderer::dynamic_resolution{ 10ms, { .min_scale = 0.5f, .max_scale = 1.f, .step = 0.25f, .frames_per_adjustment = 2 } };
+		// Over budget: steps down once per window, and not below min_scale.
+		auto first = resolution.record(20ms);
+		auto second = resolution.record(20ms);
+		auto scale_after_one_window = resolution.scale();
+		for (int i = 0; i < 4; i++)
+			resolution.record(20ms);
+		return not first and second
+			and scale_after_one_window == 0.75f
+			and resolution.scale() == 0.5f
+			and resolution.scaled(1920) == 960;
+	}(),
+	"The scale is expected to step down while raster time is over the budget."
+);
+
+static_assert(
+	[]{
+		using namespace std::chrono_literals;
+		auto resolution = renderer::dynamic_resolution{ 10ms, { .min_scale = 0.5f, .max_scale = 1.f, .step = 0.5f, .frames_per_adjustment = 1 } };
+		resolution.record(20ms);
+		// At 0.5 a step up quadruples the area: 3ms would predict 12ms and
+		// stays put, 2ms predicts 8ms and fits.
+		auto stayed = not resolution.record(3ms) and resolution.scale() == 0.5f;
+		auto stepped_up = resolution.record(2ms) and resolution.scale() == 1.f;
+		return stayed and stepped_up;
+	}(),
+	"The scale is expected to step up only when the larger resolution is predicted to fit the budget."
+);
@@ -0,0 +1,202 @@
+export module renderer:util.framearena;
+import std;
+
+namespace
+{
+	std::atomic<std::uint64_t> heap_allocations{ 0 };
+}
+
+export namespace renderer
+{
+	// Counts general-heap allocations made through operator new. The
+	// count is only advanced when the program replaces the global
+	// operator new to call count_heap_allocation(), as the renderer app
+	// does in main.cpp, which lets us verify steady-state frames don't
+	// touch the heap at all.
+	void count_heap_allocation() noexcept
+	{
+		heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	auto heap_allocation_count() noexcept -> std::uint64_t
+	{
+		return heap_allocations.load(std::memory_order_relaxed);
+	}
+
+	// A bump allocator for data that lives for a single frame, such as
+	// the triangles to render. Allocating is a pointer increment,
+	// deallocating is a no-op, and reset() reclaims everything at once at
+	// the start of the next frame.
+	//
+	// Should a frame need more than the arena's capacity, the excess is
+	// taken from the upstream resource, and on the following reset() the
+	// arena releases those blocks and regrows its own buffer to the
+	// high-water mark, so only the frame that spiked pays for the heap.
+	class frame_arena final : public std::pmr::memory_resource
+	{
+	public:
+		explicit frame_arena(std::size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+			: m_upstream{ upstream }
+		{
+			grow(capacity);
+		}
+
+		frame_arena(const frame_arena&) = delete;
+		auto operator=(const frame_arena&) -> frame_arena& = delete;
+
+		~frame_arena()
+		{
+			release_overflow();
+			if (m_buffer)
+				m_upstream->deallocate(m_buffer, m_capacity, alignof(std::max_align_t));
+		}
+
+		// Invalidates everything allocated since the last reset.
+		void reset()
+		{
+			if (not m_overflow.empty())
+			{
+				release_overflow();
+				grow(std::bit_ceil(m_high_water_mark));
+			}
+			m_offset = 0;
+			m_used = 0;
+		}
+
+		// Bytes handed out since the last reset, including alignment padding.
+		auto used() const noexcept -> std::size_t { return m_used; }
+		// The most bytes any single frame has used.
+		auto high_water_mark() const noexcept -> std::size_t { return m_high_water_mark; }
+		auto capacity() const noexcept -> std::size_t { return m_capacity; }
+		// How many times the arena has had to go to the upstream resource,
+		// including for its initial buffer.
+		auto upstream_allocations() const noexcept -> std::uint64_t { return m_upstream_allocations; }
+
+	private:
+		struct overflow_block
+		{
+			void* pointer = nullptr;
+			std::size_t bytes = 0;
+			std::size_t alignment = 0;
+		};
+
+		auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override
+		{
+			auto base = reinterpret_cast<std::uintptr_t>(m_buffer);
+			auto aligned_offset = ((base + m_offset + alignment - 1) & ~(alignment - 1)) - base;
+			if (aligned_offset + bytes <= m_capacity)
+			{
+				m_used += aligned_offset + bytes - m_offset;
+				m_offset = aligned_offset + bytes;
+				m_high_water_mark = std::max(m_high_water_mark, m_used);
+				return m_buffer + aligned_offset;
+			}
+
+			auto pointer = m_upstream->allocate(bytes, alignment);
+			m_upstream_allocations++;
+			m_overflow.push_back({ pointer, bytes, alignment });
+			m_used += bytes;
+			m_high_water_mark = std::max(m_high_water_mark, m_used);
+			return pointer;
+		}
+
+		void do_deallocate(void*, std::size_t, std::size_t) override
+		{
+			// Memory is reclaimed by reset().
+		}
+
+		auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override
+		{
+			return this == &other;
+		}
+
+		void grow(std::size_t capacity)
+		{
+			if (capacity <= m_capacity)
+				return;
+			if (m_buffer)
+				m_upstream->deallocate(m_buffer, m_capacity, alignof(std::max_align_t));
+			m_buffer = static_cast<std::byte*>(m_upstream->allocate(capacity, alignof(std::max_align_t)));
+			m_capacity = capacity;
+			m_upstream_allocations++;
+		}
+
+		void release_overflow() noexcept
+		{
+			for (auto&& block : m_overflow)
+				m_upstream->deallocate(block.pointer, block.bytes, block.alignment);
+			m_overflow.clear();
+		}
+
+		std::pmr::memory_resource* m_upstream = nullptr;
+		std::byte* m_buffer = nullptr;
+		std::size_t m_capacity = 0;
+		std::size_t m_offset = 0;
+		std::size_t m_used = 0;
+		std::size_t m_high_water_mark = 0;
+		std::uint64_t m_upstream_allocations = 0;
+		std::vector<overflow_block> m_overflow;
+	};
+
+	// One frame_arena per thread that renders, so that worker threads can
+	// allocate without contending on a lock. Arenas are created on a
+	// thread's first call to local() and live as long as the pool. reset()
+	// must only be called between frames, while no thread is allocating.
+	class frame_arena_pool final
+	{
+	public:
+		explicit frame_arena_pool(std::size_t capacity_per_thread)
+			: m_capacity_per_thread{ capacity_per_thread }
+		{ }
+
+		frame_arena_pool(const frame_arena_pool&) = delete;
+		auto operator=(const frame_arena_pool&) -> frame_arena_pool& = delete;
+
+		// The calling thread's arena.
+		auto local() -> frame_arena&
+		{
+			thread_local auto cache = std::pair<const frame_arena_pool*, frame_arena*>{ nullptr, nullptr };
+			if (cache.first == this)
+				return *cache.second;
+
+			auto lock = std::scoped_lock{ m_mutex };
+			auto& arena = m_arenas[std::this_thread::get_id()];
+			if (not arena)
+				arena = std::make_unique<frame_arena>(m_capacity_per_thread);
+			cache = { this, arena.get() };
+			return *arena;
+		}
+
+		void reset()
+		{
+			auto lock = std::scoped_lock{ m_mutex };
+			for (auto&& [_, arena] : m_arenas)
+				arena->reset();
+		}
+
+		// The largest high-water mark of any thread's arena, which is what
+		// capacity_per_thread should be tuned to.
+		auto high_water_mark() const -> std::size_t
+		{
+			auto lock = std::scoped_lock{ m_mutex };
+			auto result = std::size_t{ 0 };
+			for (auto&& [_, arena] : m_arenas)
+				result = std::max(result, arena->high_water_mark());
+			return result;
+		}
+
+		auto upstream_allocations() const -> std::uint64_t
+		{
+			auto lock = std::scoped_lock{ m_mutex };
+			auto result = std::uint64_t{ 0 };
+			for (auto&& [_, arena] : m_arenas)
+				result += arena->upstream_allocations();
+			return result;
+		}
+
+	private:
+		std::size_t m_capacity_per_thread;
+		mutable std::mutex m_mutex;
+		std::unordered_map<std::thread::id, std::unique_ptr<frame_arena>> m_arenas;
+	};
+}
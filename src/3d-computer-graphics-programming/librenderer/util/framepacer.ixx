@@ -0,0 +1,304 @@
+export module renderer:util.framepacer;
+import std;
+
+export namespace renderer
+{
+	enum class frame_rate_target
+	{
+		fps_60,
+		fps_120,
+		fps_144,
+		uncapped
+	};
+
+	// The time between two frames for a target, or zero if uncapped.
+	constexpr auto frame_period(frame_rate_target target) noexcept -> std::chrono::nanoseconds
+	{
+		using namespace std::chrono_literals;
+		switch (target)
+		{
+			case frame_rate_target::fps_60:
+				return std::chrono::nanoseconds{ 1s } / 60;
+			case frame_rate_target::fps_120:
+				return std::chrono::nanoseconds{ 1s } / 120;
+			case frame_rate_target::fps_144:
+				return std::chrono::nanoseconds{ 1s } / 144;
+			case frame_rate_target::uncapped:
+				return 0ns;
+		}
+		std::unreachable();
+	}
+
+	struct frame_statistics
+	{
+		std::chrono::nanoseconds p50{};
+		std::chrono::nanoseconds p99{};
+		std::chrono::nanoseconds max{};
+		std::size_t samples = 0;
+	};
+
+	// A histogram of the last VWindow frame times. Samples are binned into
+	// buckets of bucket_width so that percentiles can be read off without
+	// sorting; the sample that falls out of the window is un-binned as the
+	// new one is recorded. Frame times beyond the last bucket are counted
+	// in it, and percentiles that land there report the window's maximum.
+	template<std::size_t VWindow = 512>
+	class frame_time_histogram
+	{
+	public:
+		static constexpr auto bucket_width = std::chrono::nanoseconds{ std::chrono::microseconds{ 50 } };
+		static constexpr std::size_t bucket_count = 1024;
+
+		constexpr void record(std::chrono::nanoseconds frame_time) noexcept
+		{
+			frame_time = std::max(frame_time, std::chrono::nanoseconds{ 0 });
+			if (m_count == VWindow)
+				m_buckets[bucket_of(m_samples[m_next])]--;
+			else
+				m_count++;
+			m_samples[m_next] = frame_time;
+			m_buckets[bucket_of(frame_time)]++;
+			m_next = (m_next + 1) % VWindow;
+		}
+
+		constexpr auto count() const noexcept -> std::size_t
+		{
+			return m_count;
+		}
+
+		// The upper edge of the bucket holding the given fraction of frames,
+		// e.g. percentile(0.99) is a frame time 99% of frames didn't exceed.
+		constexpr auto percentile(double fraction) const noexcept -> std::chrono::nanoseconds
+		{
+			if (m_count == 0)
+				return {};
+			auto exact_rank = fraction * static_cast<double>(m_count);
+			auto rank = static_cast<std::size_t>(exact_rank);
+			if (static_cast<double>(rank) < exact_rank or rank == 0)
+				rank++;
+			auto seen = std::size_t{ 0 };
+			for (auto bucket = std::size_t{ 0 }; bucket < bucket_count - 1; bucket++)
+			{
+				seen += m_buckets[bucket];
+				if (seen >= rank)
+					return std::min(bucket_width * static_cast<std::int64_t>(bucket + 1), max());
+			}
+			return max();
+		}
+
+		constexpr auto max() const noexcept -> std::chrono::nanoseconds
+		{
+			auto result = std::chrono::nanoseconds{ 0 };
+			for (auto i = std::size_t{ 0 }; i < m_count; i++)
+				result = std::max(result, m_samples[i]);
+			return result;
+		}
+
+		constexpr auto statistics() const noexcept -> frame_statistics
+		{
+			return { .p50 = percentile(0.5), .p99 = percentile(0.99), .max = max(), .samples = m_count };
+		}
+
+	private:
+		static constexpr auto bucket_of(std::chrono::nanoseconds frame_time) noexcept -> std::size_t
+		{
+			return std::min(static_cast<std::size_t>(frame_time / bucket_width), bucket_count - 1);
+		}
+
+		std::array<std::chrono::nanoseconds, VWindow> m_samples{};
+		std::array<std::uint32_t, bucket_count> m_buckets{};
+		std::size_t m_next = 0;
+		std::size_t m_count = 0;
+	};
+
+	// Splits variable frame times into a whole number of fixed simulation
+	// steps. What's left over is reported by alpha() as the fraction of a
+	// step the renderer should interpolate between the previous and the
+	// current simulation state. The number of steps per frame is capped so
+	// that a long stall doesn't make the simulation fall further behind.
+	class fixed_timestep
+	{
+	public:
+		constexpr explicit fixed_timestep(std::chrono::nanoseconds step, std::uint32_t max_steps = 8) noexcept
+			: m_step{ step }, m_max_steps{ max_steps }
+		{ }
+
+		// Returns how many steps to simulate for a frame that took frame_time.
+		constexpr auto advance(std::chrono::nanoseconds frame_time) noexcept -> std::uint32_t
+		{
+			m_accumulator += std::max(frame_time, std::chrono::nanoseconds{ 0 });
+			auto steps = static_cast<std::uint32_t>(std::min<std::int64_t>(m_accumulator / m_step, m_max_steps));
+			m_accumulator = steps == m_max_steps ? m_accumulator % m_step : m_accumulator - m_step * steps;
+			return steps;
+		}
+
+		constexpr auto step() const noexcept -> std::chrono::nanoseconds
+		{
+			return m_step;
+		}
+
+		constexpr auto alpha() const noexcept -> float
+		{
+			return static_cast<float>(static_cast<double>(m_accumulator.count()) / static_cast<double>(m_step.count()));
+		}
+
+	private:
+		std::chrono::nanoseconds m_step;
+		std::chrono::nanoseconds m_accumulator{ 0 };
+		std::uint32_t m_max_steps;
+	};
+
+	// Paces frames against steady_clock deadlines. Waiting sleeps while the
+	// deadline is comfortably far away and spins for the remainder, as
+	// sleeps are only as precise as the OS timer. How much a sleep
+	// overshoots is measured as we go (mean plus one standard deviation)
+	// so that we stop sleeping just early enough, which keeps frames within
+	// about 100us of their target without spinning for the whole frame.
+	class frame_pacer
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+		explicit frame_pacer(frame_rate_target target = frame_rate_target::fps_60)
+			: m_target{ target }
+		{ }
+
+		auto target() const noexcept -> frame_rate_target
+		{
+			return m_target;
+		}
+
+		void set_target(frame_rate_target target) noexcept
+		{
+			if (target == m_target)
+				return;
+			m_target = target;
+			m_deadline = m_frame_start + frame_period(target);
+		}
+
+		// Marks the start of a frame and returns the time since the start
+		// of the previous one, which is also what the histogram records.
+		auto begin_frame() noexcept -> std::chrono::nanoseconds
+		{
+			auto now = clock::now();
+			auto frame_time = m_has_started ? now - m_frame_start : std::chrono::nanoseconds{ 0 };
+			if (m_has_started)
+				m_histogram.record(frame_time);
+			m_has_started = true;
+			m_frame_start = now;
+
+			// Deadlines advance by whole periods so that rounding doesn't
+			// drift, unless we've missed one, in which case we restart from now.
+			auto period = frame_period(m_target);
+			m_deadline += period;
+			if (m_deadline < now)
+				m_deadline = now + period;
+			return frame_time;
+		}
+
+		// Call after the loop has been idle, e.g. waiting for input with
+		// nothing to render, so that the wait isn't taken for a frame: the
+		// next begin_frame() returns zero and records nothing.
+		void resume() noexcept
+		{
+			m_has_started = false;
+		}
+
+		// Blocks until the current frame's deadline.
+		void wait_for_next_frame() noexcept
+		{
+			if (m_target == frame_rate_target::uncapped)
+				return;
+
+			using namespace std::chrono_literals;
+			constexpr auto sleep_slice = std::chrono::nanoseconds{ 1ms };
+			while (m_deadline - clock::now() > sleep_estimate())
+			{
+				auto before = clock::now();
+				std::this_thread::sleep_for(sleep_slice);
+				record_sleep(clock::now() - before);
+			}
+			while (clock::now() < m_deadline)
+				; // spin
+		}
+
+		auto statistics() const noexcept -> frame_statistics
+		{
+			return m_histogram.statistics();
+		}
+
+	private:
+		auto sleep_estimate() const noexcept -> std::chrono::nanoseconds
+		{
+			auto deviation = m_sleeps > 1 ? std::sqrt(m_sleep_m2 / static_cast<double>(m_sleeps - 1)) : 0.0;
+			return std::chrono::nanoseconds{ static_cast<std::int64_t>(m_sleep_mean + deviation) };
+		}
+
+		// Welford's running mean and variance of how long a 1ms sleep took.
+		void record_sleep(std::chrono::nanoseconds slept) noexcept
+		{
+			auto sample = static_cast<double>(slept.count());
+			m_sleeps++;
+			auto delta = sample - m_sleep_mean;
+			m_sleep_mean += delta / static_cast<double>(m_sleeps);
+			m_sleep_m2 += delta * (sample - m_sleep_mean);
+		}
+
+		frame_rate_target m_target;
+		clock::time_point m_frame_start{};
+		clock::time_point m_deadline{};
+		bool m_has_started = false;
+		frame_time_histogram<> m_histogram;
+		// Assume a 1ms sleep takes 2ms until we've measured one.
+		double m_sleep_mean = 2'000'000.0;
+		double m_sleep_m2 = 0.0;
+		std::uint64_t m_sleeps = 0;
+	};
+}
+
+static_assert(
+	[]{
+		using namespace std::chrono_literals;
+		auto histogram = renderer::frame_time_histogram<100>{};
+		for (int i = 0; i < 99; i++)
+			histogram.record(16ms);
+		histogram.record(40ms);
+		auto stats = histogram.statistics();
+		return stats.samples == 100
+			and stats.p50 == 16050us
+			and stats.p99 == 16050us
+			and stats.max == 40ms
+			and histogram.percentile(1.0) == 40ms;
+	}(),
+	"Percentiles are expected to be read from the histogram's buckets."
+);
+
+static_assert(
+	[]{
+		using namespace std::chrono_literals;
+		// Once the window is full, the oldest sample makes way for the newest.
+		auto histogram = renderer::frame_time_histogram<4>{};
+		histogram.record(100ms);
+		for (int i = 0; i < 4; i++)
+			histogram.record(8ms);
+		return histogram.count() == 4 and histogram.max() == 8ms and histogram.percentile(0.99) == 8ms;
+	}(),
+	"The histogram is expected to only cover the most recent frames."
+);
+
+static_assert(
+	[]{
+		using namespace std::chrono_literals;
+		auto timestep = renderer::fixed_timestep{ 10ms, 4 };
+		auto first = timestep.advance(25ms);
+		auto alpha_after_first = timestep.alpha();
+		auto second = timestep.advance(8ms);
+		auto alpha_after_second = timestep.alpha();
+		// A stall drops the backlog beyond max_steps but keeps the remainder.
+		auto stalled = timestep.advance(1s + 3ms);
+		return first == 2 and alpha_after_first == 0.5f
+			and second == 1 and alpha_after_second == 0.3f
+			and stalled == 4 and timestep.alpha() == 0.6f;
+	}(),
+	"Fixed timesteps are expected to accumulate frame time into whole steps."
+);
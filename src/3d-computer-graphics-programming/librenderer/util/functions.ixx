@@ -1,6 +1,8 @@
 export module renderer:util.functions;
 import std;
+#ifndef RENDERER_PORTABLE
 import :win32;
+#endif
 
 export namespace renderer
 {
@@ -17,7 +19,11 @@ export namespace renderer
     auto print_debug_string(std::format_string<TArgs...> fmt, TArgs&&...args) -> std::string
     {
         auto error = std::format("{}\n", std::format(fmt, std::forward<TArgs>(args)...));
+#ifndef RENDERER_PORTABLE
         win32::OutputDebugStringA(error.c_str());
+#else
+        std::clog << error;
+#endif
         return error;
     }
 }
@@ -2,3 +2,9 @@ export module renderer:util;
 export import :util.functions;
 export import :util.fileline;
 export import :util.fixedstring;
+export import :util.alignedallocator;
+export import :util.framepacer;
+export import :util.framearena;
+export import :util.dynamicresolution;
+export import :util.changetracker;
+export import :util.workerpool;
@@ -0,0 +1,140 @@
+export module renderer:util.workerpool;
+import std;
+
+export namespace renderer
+{
+	// A fixed set of threads that run the items of a batch, such as the
+	// viewports of a frame, alongside the thread that submits it. The
+	// threads are started once and sleep between batches, so running a
+	// batch costs a wake-up rather than a thread start, and submitting one
+	// doesn't allocate.
+	//
+	// Only one thread may call run() at a time.
+	class worker_pool final
+	{
+	public:
+		// Zero workers runs every batch on the calling thread alone.
+		explicit worker_pool(unsigned workers)
+		{
+			m_workers.reserve(workers);
+			for (auto i = 0u; i < workers; i++)
+				m_workers.emplace_back([this](std::stop_token stop) { work_loop(stop); });
+		}
+
+		worker_pool(const worker_pool&) = delete;
+		auto operator=(const worker_pool&) -> worker_pool& = delete;
+
+		~worker_pool()
+		{
+			for (auto&& worker : m_workers)
+				worker.request_stop();
+		}
+
+		auto worker_count() const noexcept -> std::size_t { return m_workers.size(); }
+
+		// Calls task(i) once for each i in [0, count), spread over the
+		// workers and the calling thread, and returns once every call has
+		// returned. If any call throws, the first exception is rethrown
+		// here after the rest have finished.
+		template<typename TTask>
+		void run(std::size_t count, TTask&& task)
+		{
+			if (count == 0)
+				return;
+			auto current = batch{};
+			{
+				auto lock = std::scoped_lock{ m_mutex };
+				current = {
+					.task = [](void* context, std::size_t index) { (*static_cast<std::remove_reference_t<TTask>*>(context))(index); },
+					.context = std::addressof(task),
+					.count = count,
+					.id = m_batch.id + 1
+				};
+				m_batch = current;
+				m_remaining = count;
+				m_failure = nullptr;
+				m_next = std::uint64_t{ current.id } << 32;
+			}
+			m_wake.notify_all();
+
+			run_items(current);
+
+			auto lock = std::unique_lock{ m_mutex };
+			m_done.wait(lock, [this] { return m_remaining == 0; });
+			if (m_failure)
+				std::rethrow_exception(std::exchange(m_failure, nullptr));
+		}
+
+	private:
+		struct batch
+		{
+			void (*task)(void*, std::size_t) = nullptr;
+			void* context = nullptr;
+			std::size_t count = 0;
+			std::uint32_t id = 0;
+		};
+
+		void work_loop(std::stop_token stop)
+		{
+			auto seen = std::uint32_t{ 0 };
+			auto lock = std::unique_lock{ m_mutex };
+			while (m_wake.wait(lock, stop, [&] { return m_batch.id != seen; }))
+			{
+				auto current = m_batch;
+				seen = current.id;
+				lock.unlock();
+				run_items(current);
+				lock.lock();
+			}
+		}
+
+		// Claims items of the batch until there are none left. The batch's
+		// id is kept in the top half of the shared counter, so a thread
+		// that's still finishing one batch when the next is submitted
+		// can't claim an item of the new one by mistake.
+		void run_items(const batch& current)
+		{
+			while (true)
+			{
+				auto next = m_next.load();
+				do
+				{
+					if ((next >> 32) != current.id or (next & 0xffffffff) >= current.count)
+						return;
+				}
+				while (not m_next.compare_exchange_weak(next, next + 1));
+
+				try
+				{
+					current.task(current.context, static_cast<std::size_t>(next & 0xffffffff));
+				}
+				catch (...)
+				{
+					auto lock = std::scoped_lock{ m_mutex };
+					if (not m_failure)
+						m_failure = std::current_exception();
+				}
+
+				if (m_remaining.fetch_sub(1) == 1)
+				{
+					auto lock = std::scoped_lock{ m_mutex };
+					m_done.notify_one();
+				}
+			}
+		}
+
+		std::mutex m_mutex;
+		std::condition_variable_any m_wake;
+		std::condition_variable m_done;
+		// The batch being run, or last run. Only changed under the mutex.
+		batch m_batch;
+		// The batch's id, then the index of the next item to claim.
+		std::atomic<std::uint64_t> m_next = 0;
+		std::atomic<std::size_t> m_remaining = 0;
+		std::exception_ptr m_failure;
+
+		// Last, so that they're stopped and joined before anything they
+		// use is destroyed.
+		std::vector<std::jthread> m_workers;
+	};
+}
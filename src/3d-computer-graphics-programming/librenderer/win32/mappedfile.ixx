@@ -0,0 +1,73 @@
+module;
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+export module renderer:win32.mappedfile;
+import std;
+import :raii;
+
+export namespace win32
+{
+	// A whole file mapped read-only into memory. Pages are read in by the
+	// OS as they're first touched, so opening even a large file is cheap
+	// and reading it is bound by how fast it can be paged in, or not at all
+	// if it's still in the file cache.
+	//
+	// While it's mapped, the file can't be deleted, renamed over or written
+	// to, by this process or any other: those fail with ERROR_ACCESS_DENIED
+	// or ERROR_SHARING_VIOLATION until the mapped_file is destroyed.
+	class mapped_file final
+	{
+	public:
+		explicit mapped_file(const std::filesystem::path& path)
+		{
+			auto file = ::CreateFileW(
+				path.c_str(),
+				GENERIC_READ,
+				FILE_SHARE_READ | FILE_SHARE_DELETE,
+				nullptr,
+				OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+				nullptr
+			);
+			if (file == INVALID_HANDLE_VALUE)
+				throw_last_error("Failed to open", path);
+			m_file.reset(file);
+
+			auto size = LARGE_INTEGER{};
+			if (not ::GetFileSizeEx(file, &size))
+				throw_last_error("Failed to get the size of", path);
+			if (size.QuadPart == 0)
+				throw std::runtime_error(std::format("Can't map the empty file {}", path.string()));
+			m_size = static_cast<std::size_t>(size.QuadPart);
+
+			m_mapping.reset(::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr));
+			if (not m_mapping)
+				throw_last_error("Failed to create a mapping of", path);
+			m_view.reset(::MapViewOfFile(m_mapping.get(), FILE_MAP_READ, 0, 0, 0));
+			if (not m_view)
+				throw_last_error("Failed to map", path);
+		}
+
+		auto data() const noexcept -> const std::byte* { return static_cast<const std::byte*>(m_view.get()); }
+		auto size() const noexcept -> std::size_t { return m_size; }
+
+	private:
+		[[noreturn]] static void throw_last_error(std::string_view what, const std::filesystem::path& path)
+		{
+			throw std::system_error(
+				static_cast<int>(::GetLastError()),
+				std::system_category(),
+				std::format("{} {}", what, path.string())
+			);
+		}
+
+		// Declared in the order they're created, so that they're released
+		// in reverse.
+		renderer::indirect_unique_ptr<HANDLE, ::CloseHandle> m_file;
+		renderer::indirect_unique_ptr<HANDLE, ::CloseHandle> m_mapping;
+		renderer::indirect_unique_ptr<LPVOID, ::UnmapViewOfFile> m_view;
+		std::size_t m_size = 0;
+	};
+}
@@ -4,6 +4,7 @@ module;
 #include <windows.h>
 
 export module renderer:win32;
+export import :win32.mappedfile;
 
 export namespace win32
 {
@@ -4,13 +4,30 @@ import renderer;
 
 export namespace app_state
 {
+	// Decoded textures are also written to disk, so that later runs map
+	// them instead of decoding the PNGs again.
+	auto decoded_textures = upng::decoded_texture_cache{
+		std::filesystem::temp_directory_path() / "3d-computer-graphics-programming" / "textures",
+		64 << 20
+	};
+
+	// Decoded textures are kept within this budget; the least recently
+	// shown are evicted and decoded again when next needed. 2MB holds the
+	// largest texture we ship plus a few of the rest.
+	auto textures = renderer::texture_cache{
+		2 << 20,
+		renderer::texture::red_brick(),
+		renderer::texture_encoding::argb8888,
+		&decoded_textures
+	};
+
 	struct mesh_and_texture
 	{
 		mesh_and_texture(std::string_view mesh_path, std::string_view texture_path)
-			: mesh{ mesh_path }, texture{ texture_path }
+			: mesh{ mesh_path }, texture{ textures.add(texture_path) }
 		{}
 		renderer::mesh mesh;
-		upng::upng_texture texture;
+		renderer::texture_handle texture;
 	};
 
 	struct all_meshes_t
@@ -55,20 +72,33 @@ export namespace app_state
 		}
 	};
 
-	constexpr auto fps = 60;
-	constexpr auto frame_target_time = std::chrono::milliseconds{ 1000 / fps };
 	constexpr auto window_dimensions = sdl::window_dimensions{};
 
 	auto all_meshes = all_meshes_t{};
 
-	auto previous_frame_time = std::chrono::milliseconds{ 0 };
-	auto elapsed = std::chrono::milliseconds{ 0 };
+	auto pacer = renderer::frame_pacer{ renderer::frame_rate_target::fps_60 };
+	// When enabled, the simulation advances in fixed steps of this length
+	// and rendering interpolates between the last two of them.
+	auto use_fixed_timestep = false;
+	auto simulation = renderer::fixed_timestep{ std::chrono::nanoseconds{ std::chrono::seconds{ 1 } } / 120 };
 
-	auto triangles_to_render = std::vector<renderer::triangle>{}; // renderer::mesh_faces.size()
+	// Renders the 3D pass below the window's resolution when rasterizing
+	// at full resolution can't keep up with the frame rate target. The
+	// result is scaled up to the window when presenting.
+	auto use_dynamic_resolution = true;
+	auto dynamic_resolution = renderer::dynamic_resolution{
+		std::chrono::nanoseconds{ 0 },
+		{ .min_scale = 0.5f, .max_scale = 1.f, .step = 0.1f }
+	};
+
+	// Transient per-frame data, reset at the start of each frame. 1MB
+	// comfortably holds the triangles of the largest mesh we ship.
+	auto frame_arenas = renderer::frame_arena_pool{ 1 << 20 };
 	auto context = std::make_unique<sdl::sdl_context>(sdl::init_everything);
 
 
-	// combines the color and depth buffer into a single struct.
+	// combines the color and depth buffer into a single struct. It's
+	// allocated at the window's size, the largest it's resized to.
 	auto frame_buffer = renderer::frame_buffer{ window_dimensions.width(), window_dimensions.height() };
 
 	auto window = sdl::window{
@@ -81,7 +111,7 @@ export namespace app_state
 
 	auto color_buffer_texture = sdl::texture{
 		sdl_renderer.get(),
-		SDL_PixelFormatEnum::SDL_PIXELFORMAT_RGBA32,
+		renderer::to_sdl_pixel_format(renderer::native_pixel_format),
 		SDL_TextureAccess::SDL_TEXTUREACCESS_STREAMING,
 		static_cast<int>(window.get_width()),
 		static_cast<int>(window.get_height())
@@ -92,13 +122,65 @@ export namespace app_state
 		.position = {0.f, 0.f, 0.f},
 		.direction = {0.f, 0.f, 1.f}
 	};
+	// The camera as of the previous simulation step.
+	auto previous_camera = camera;
 	auto is_running = true;
 	auto render_settings = renderer::settings{};
 
+	// Everything a frame's image depends on. While it's the same as for
+	// the last presented frame, that frame is still on screen and nothing
+	// is rendered.
+	struct frame_inputs
+	{
+		renderer::camera_t camera;
+		std::size_t mesh_index = 0;
+		renderer::vector_4f rotation;
+		renderer::vector_4f scale;
+		renderer::vector_4f translation;
+		renderer::settings render_settings;
+		renderer::texture::selected_texture texture;
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+
+		auto operator==(const frame_inputs&) const -> bool = default;
+	};
+	auto frame_changes = renderer::change_tracker<frame_inputs>{};
+	// Set when the frame buffer or the texture it's presented through no
+	// longer holds the last frame, e.g. after a resize or when the window
+	// is uncovered, so the next frame is drawn in full. Otherwise only the
+	// area the mesh covered in the last frame or covers in this one is.
+	auto redraw_everything = true;
+	auto last_drawn_bounds = renderer::screen_rect{};
+
 	const auto proj_matrix = renderer::projective_perspective_divide_matrix(
 		renderer::radians{ std::numbers::pi / 3 },
 		(float)window_dimensions.width() / (float)window_dimensions.height(),
 		0.1f,
 		100.f
 	);
+
+	// The inspection layout: the current mesh from the front, the side
+	// and the top, and through the free camera, each in a quarter of the
+	// window. The meshes are placed 4 units down +z, so the fixed cameras
+	// are 4 units from that point.
+	auto use_viewports = false;
+	auto viewports = []
+	{
+		auto rects = renderer::quad_layout(window_dimensions.width(), window_dimensions.height());
+		auto field_of_view = renderer::radians{ std::numbers::pi / 3 };
+		return std::array{
+			renderer::viewport{ { .position = { 0.f, 0.f, 0.f } }, field_of_view, rects[0] },
+			renderer::viewport{ { .position = { -4.f, 0.f, 4.f }, .yaw = std::numbers::pi_v<float> / 2 }, field_of_view, rects[1] },
+			renderer::viewport{ { .position = { 0.f, 4.f, 4.f }, .pitch = std::numbers::pi_v<float> / 2 }, field_of_view, rects[2] },
+			renderer::viewport{ camera, field_of_view, rects[3] }
+		};
+	}();
+	// The viewports are rendered concurrently, the first on the main
+	// thread and the others on these, up to one per core.
+	auto viewport_workers = renderer::worker_pool{
+		std::min(
+			static_cast<unsigned>(viewports.size() - 1),
+			std::max(1u, std::thread::hardware_concurrency()) - 1
+		)
+	};
 }
\ No newline at end of file
@@ -2,168 +2,226 @@ export module mainapp:core;
 import std;
 import renderer;
 import :appstate;
+import :input;
 
 export namespace core
 {
-	void update(std::chrono::milliseconds elapsed_time)
+	// Advances the simulation by a frame's worth of time and returns the
+	// camera to render the frame with. With a fixed timestep, the
+	// simulation runs in whole steps and the camera is interpolated
+	// between the last two, so motion stays smooth whatever the frame rate.
+	auto simulate(std::chrono::nanoseconds frame_time) -> renderer::camera_t
 	{
-		// Delay to meet target frame rate. Note: we can 
-		// do this ourselves by keeping track of the 
-		// elapsed milliseconds.
-		auto time_to_wait = std::chrono::milliseconds{ app_state::frame_target_time - elapsed_time };
-		if (time_to_wait.count() > 0 and time_to_wait <= app_state::frame_target_time)
-			SDL_Delay(static_cast<std::uint32_t>(time_to_wait.count()));
-		app_state::previous_frame_time = std::chrono::milliseconds{ SDL_GetTicks() };
-		app_state::elapsed += elapsed_time;
-
-		// Create the view matrix.
-		constexpr auto up_direction = renderer::vector_3f{ 0, 1, 0 };
-		// Find the target.
-		auto target = renderer::vector_3f{ 0, 0, 1 };
-		auto camera_yaw_rotation = renderer::rotation_matrix{ renderer::y_rotation{ app_state::camera.yaw } };
-		app_state::camera.direction = camera_yaw_rotation * target;
-
-		// Offset the target position in the direction where the camera is pointing at.
-		target = app_state::camera.position + app_state::camera.direction;
-
-		auto view_matrix = renderer::look_at_matrix_4x4(app_state::camera.position, target, up_direction);
-
-
-		auto scaleMatrix = renderer::scale_matrix{ app_state::all_meshes.get_current_mesh().mesh.scale };
-		auto translation = renderer::translate_matrix{ app_state::all_meshes.get_current_mesh().mesh.translation };
-
-		auto rotationMatrix = renderer::rotation_matrix{ app_state::all_meshes.get_current_mesh().mesh.rotation };
-
-		constexpr auto global_light = renderer::light{ {.x = 0, .y = 0, .z = 1 }, 0xffffffff };
-
-		for (int i = 0; i < app_state::all_meshes.get_current_mesh().mesh.faces.size(); i++)
+		if (not app_state::use_fixed_timestep)
 		{
-			auto mesh_face = renderer::face{ app_state::all_meshes.get_current_mesh().mesh.faces[i] };
-			auto face_vertices = std::array{
-				app_state::all_meshes.get_current_mesh().mesh.vertices[mesh_face.a],
-				app_state::all_meshes.get_current_mesh().mesh.vertices[mesh_face.b],
-				app_state::all_meshes.get_current_mesh().mesh.vertices[mesh_face.c]
-			};
-
-			auto transformed_vertices = std::array<renderer::vector_4f, 3>{};
-			for (int j = 0; j < 3; j++)
-			{
-				// These need to be applied in the correct order: 
-				// scale, rotate, translate.
-				// Scale our original vertex, then rotate, then 
-				// the vertex away from the camera. The matrix 
-				// translate*rotate*scale is called the world 
-				// matrix and is responsible for placing the
-				// mesh in its correct position in the 3D world.
-				transformed_vertices[j] = 
-					view_matrix
-					* translation
-					* rotationMatrix
-					* scaleMatrix
-					* face_vertices[j];
-			}
+			app_state::previous_camera = app_state::camera;
+			input::update_camera(frame_time);
+			return app_state::camera;
+		}
 
-			auto transformed_triangle = renderer::triangle{
-				.vertices {
-					transformed_vertices[0],
-					transformed_vertices[1],
-					transformed_vertices[2]
-				}
-			};
-			auto normal = renderer::vector_4f{ transformed_triangle.compute_normal() };
-
-			/* Backface culling -- bypass rendering triangles that
-			* are not facing the camera.
-			* Note:
-			* This is a naive implementation and modern graphics APIs
-			* and 3D hardware approach back-face culling differently.
-			* For example, OpenGL does not compare the normal of the
-			* faces with the camera; instead, it does back-face culling
-			* after projection and uses the clockwise/counterclockwise
-			* order of the vertices to determine what is visible and
-			* what's not.
-			*
-			* Note that backface culling is not the same as frustum
-			* culling.
-			*/
-			auto origin = renderer::vector_3f{ 0, 0, 0 };
-			if (app_state::render_settings.culling_mode == renderer::cull_mode::enabled)
-			{
-				const auto& [vector_a, vector_b, _] = transformed_vertices;
-				auto camera_ray = renderer::vector_4f{ renderer::vector_4f{origin.x, origin.y, origin.z, 1.0f} - vector_a };
-				if (renderer::dot_product(camera_ray, normal) <= 0) // cull the face
-					continue;
-			}
+		for (auto steps = app_state::simulation.advance(frame_time); steps > 0; steps--)
+		{
+			app_state::previous_camera = app_state::camera;
+			input::update_camera(app_state::simulation.step());
+		}
+		return renderer::interpolate(app_state::previous_camera, app_state::camera, app_state::simulation.alpha());
+	}
 
-			// Loop all three vertices
-			auto projected_triangle = renderer::triangle{
-				.texcoords = { mesh_face.a_uv, mesh_face.b_uv, mesh_face.c_uv },
-				.color =
-				//global_light.compute_intensity_from_normal(mesh_face.color, normal)
-				global_light.compute_intensity_from_normal(normal),
-			};
+	// Returns true if a frame rendered with this camera and texture would
+	// look the same as the last one presented.
+	auto is_frame_unchanged(const renderer::camera_t& camera, renderer::texture::selected_texture texture) -> bool
+	{
+		const auto& mesh = app_state::all_meshes.get_current_mesh().mesh;
+		auto changed = app_state::frame_changes.update({
+			.camera = camera,
+			.mesh_index = app_state::all_meshes.current_mesh_index,
+			.rotation = mesh.rotation,
+			.scale = mesh.scale,
+			.translation = mesh.translation,
+			.render_settings = app_state::render_settings,
+			.texture = texture,
+			.width = app_state::frame_buffer.color.width(),
+			.height = app_state::frame_buffer.color.height()
+		});
+		return not changed and not app_state::redraw_everything;
+	}
 
-			for (int j = 0; j < 3; j++)
+	// Returns the projected triangles to render, allocated from arena.
+	auto update(const renderer::camera_t& camera, std::pmr::memory_resource& arena) -> renderer::triangle_list
+	{
+		return renderer::project_mesh(
+			app_state::all_meshes.get_current_mesh().mesh,
 			{
-				// Project the current vertex
-				auto projected_point = renderer::vector_4f{ app_state::proj_matrix * transformed_vertices[j] };
-
-				// Scale into the view.
-				projected_point.x *= app_state::window_dimensions.width() / 2;
-				projected_point.y *= app_state::window_dimensions.height() / 2;
-
-				// Invert the y coordinate to account for flipped y-axis in screen space.
-				projected_point.y *= -1;
-
-				// Translate the projected points to the middle of the screen.
-				projected_point.x += app_state::window_dimensions.width() / 2;
-				projected_point.y += app_state::window_dimensions.height() / 2;
-				projected_triangle.vertices[j] = projected_point;
-			}
-
-			// Save the projected triangle in the array of triangles to render
-			app_state::triangles_to_render.push_back(projected_triangle);
-		}
+				.camera = camera,
+				.projection = app_state::proj_matrix,
+				// With dynamic resolution, the frame buffer may be smaller
+				// than the window.
+				.width = app_state::frame_buffer.color.width(),
+				.height = app_state::frame_buffer.color.height(),
+				.culling = app_state::render_settings.culling_mode
+			},
+			arena
+		);
 	}
 
-	void render(
+	// Renders and presents a frame, and returns how long rasterizing it
+	// took, from clearing the frame buffer to the last triangle.
+	//
+	// Only the mesh moves between frames, so unless the whole frame has to
+	// be redrawn, only the area it covered in the last frame or covers now
+	// is cleared, redrawn and copied to the texture.
+	auto render(
 		SDL_Renderer* renderer,
 		SDL_Texture* color_buffer_texture,
 		renderer::frame_buffer& frame_buffer,
-		upng::upng_texture& texture
-	)
+		renderer::texture::selected_texture texture,
+		const renderer::triangle_list& triangles_to_render
+	) -> std::chrono::nanoseconds
 	{
+		// The contents of a locked texture are undefined, so with zero-copy
+		// presentation the frame has to be cleared after locking, at the
+		// start of the frame rather than after presenting the last one,
+		// and always in full.
+		auto zero_copy = app_state::render_settings.presenting_mode == renderer::presentation_mode::zero_copy;
+		auto bounds = renderer::screen_bounds(triangles_to_render, frame_buffer.color.width(), frame_buffer.color.height());
+		auto dirty = std::optional<renderer::screen_rect>{};
+		if (not zero_copy and not app_state::redraw_everything)
+			dirty = bounds.united(app_state::last_drawn_bounds);
+		app_state::last_drawn_bounds = bounds;
+		app_state::redraw_everything = false;
+
+		if (zero_copy)
+			renderer::lock_color_buffer(frame_buffer.color, color_buffer_texture);
+		auto raster_start = std::chrono::steady_clock::now();
+		if (dirty)
+		{
+			renderer::clear_region(*dirty, 0xff000000, frame_buffer);
+			renderer::draw_dot_grid(10, 0xff464646, frame_buffer, *dirty);
+		}
+		else
+		{
+			frame_buffer.clear_color_buffer(0xff000000).clear_z_buffer();
+			renderer::draw_dot_grid(10, 0xff464646, frame_buffer);
+		}
 
-		renderer::draw_dot_grid(10, 0xff464646, frame_buffer);
+		renderer::draw_triangles(triangles_to_render, texture, app_state::render_settings, frame_buffer);
 
-		for (const renderer::triangle& triangle : app_state::triangles_to_render)
-		{
-			if (app_state::render_settings.should_draw_filled_triangles())
-				renderer::draw_filled_triangle(triangle, triangle.color, frame_buffer);
+		auto raster_time = std::chrono::steady_clock::now() - raster_start;
+
+		renderer::present_color_buffer(renderer, frame_buffer.color, color_buffer_texture, dirty);
 
-			if (app_state::render_settings.should_draw_textured_triangles())
-				renderer::draw_textured_triangle(triangle, texture.uint32_buffer(), texture.width(), texture.height(), frame_buffer);
+		SDL_RenderPresent(renderer);
+		return raster_time;
+	}
 
-			if (app_state::render_settings.should_draw_triangles())
-				renderer::draw_triangle(triangle, 0xffffffff, frame_buffer);
-			if (app_state::render_settings.should_draw_points())
+	// Renders the current mesh through every viewport, each on its own
+	// thread, then composites them into the colour buffer texture and
+	// presents once. Returns how long rendering them all took, from the
+	// first clear to the last triangle, which with a core per viewport is
+	// about as long as the slowest of them takes on its own.
+	//
+	// The free camera's viewport follows the camera the frame is rendered
+	// with; the others stay where they are.
+	auto render_viewports(
+		SDL_Renderer* renderer,
+		SDL_Texture* color_buffer_texture,
+		const renderer::camera_t& camera,
+		renderer::texture::selected_texture texture
+	) -> std::chrono::nanoseconds
+	{
+		auto& viewports = app_state::viewports;
+		viewports.back().camera() = camera;
+		const auto& mesh = app_state::all_meshes.get_current_mesh().mesh;
+
+		auto raster_start = std::chrono::steady_clock::now();
+		app_state::viewport_workers.run(
+			viewports.size(),
+			[&](std::size_t index)
 			{
-				for (auto&& vertex : triangle.vertices)
-				{
-					renderer::draw_pixel(
-						static_cast<std::uint32_t>(vertex.y),
-						static_cast<std::uint32_t>(vertex.x),
-						0xffff0000,
-						frame_buffer
-					);
-				}
+				viewports[index].render(mesh, texture, app_state::render_settings, app_state::frame_arenas.local());
 			}
-		}
+		);
+		auto raster_time = std::chrono::steady_clock::now() - raster_start;
+
+		for (auto&& viewport : viewports)
+			renderer::composite_color_buffer(viewport.frame().color, color_buffer_texture, viewport.rect());
+		auto window = SDL_Rect{
+			0,
+			0,
+			static_cast<int>(app_state::window_dimensions.width()),
+			static_cast<int>(app_state::window_dimensions.height())
+		};
+		SDL_RenderCopy(renderer, color_buffer_texture, &window, nullptr);
+		SDL_RenderPresent(renderer);
 
-		renderer::render_color_buffer(renderer, frame_buffer.color, color_buffer_texture);
-		frame_buffer.clear_color_buffer(0xff000000).clear_z_buffer();
-		app_state::triangles_to_render.clear();
+		// Nothing else needs redrawing until something changes; leaving
+		// the layout sets this again, as the single view's dirty areas no
+		// longer match the texture.
+		app_state::redraw_everything = false;
+		return raster_time;
+	}
 
-		SDL_RenderPresent(renderer);
+	// Feeds the frame's raster time to the dynamic resolution controller
+	// and resizes the frame buffer for the next frame if the scale changed.
+	// The raster budget is three quarters of the frame period, which
+	// leaves the rest for the simulation, transforms and presenting.
+	void adjust_resolution(std::chrono::nanoseconds raster_time)
+	{
+		auto& resolution = app_state::dynamic_resolution;
+		resolution.set_budget(
+			app_state::use_dynamic_resolution
+				? renderer::frame_period(app_state::pacer.target()) * 3 / 4
+				: std::chrono::nanoseconds{ 0 }
+		);
+		resolution.record(raster_time);
+
+		auto width = resolution.scaled(app_state::window_dimensions.width());
+		auto height = resolution.scaled(app_state::window_dimensions.height());
+		if (width != app_state::frame_buffer.color.width() or height != app_state::frame_buffer.color.height())
+		{
+			app_state::frame_buffer.resize(width, height);
+			app_state::redraw_everything = true;
+		}
+	}
+
+	// Writes the frame time percentiles, the render resolution, the frame
+	// arenas' high-water mark, the texture cache's counters and the number
+	// of heap allocations since the last report to the debug output once a
+	// second. The report's own allocations aren't counted, so in steady
+	// state the heap allocation count should be 0.
+	void report_frame_statistics()
+	{
+		static auto last_report = std::chrono::steady_clock::now();
+		static auto last_heap_allocations = renderer::heap_allocation_count();
+		auto now = std::chrono::steady_clock::now();
+		if (now - last_report < std::chrono::seconds{ 1 })
+			return;
+		last_report = now;
+
+		using milliseconds = std::chrono::duration<double, std::milli>;
+		auto heap_allocations = renderer::heap_allocation_count() - last_heap_allocations;
+		auto statistics = app_state::pacer.statistics();
+		auto textures = app_state::textures.statistics();
+		renderer::print_debug_string(
+			"frame time over {} frames: p50 {:.2f}ms, p99 {:.2f}ms, max {:.2f}ms; resolution {}x{} ({:.0f}%); "
+			"frame arena high-water mark {} bytes; "
+			"textures ({}): {} hits, {} misses, {} evictions, {}/{} bytes resident; {} heap allocations",
+			statistics.samples,
+			milliseconds{ statistics.p50 }.count(),
+			milliseconds{ statistics.p99 }.count(),
+			milliseconds{ statistics.max }.count(),
+			app_state::frame_buffer.color.width(),
+			app_state::frame_buffer.color.height(),
+			app_state::dynamic_resolution.scale() * 100.f,
+			app_state::frame_arenas.high_water_mark(),
+			app_state::textures.encoding() == renderer::texture_encoding::bc1 ? "bc1" : "argb8888",
+			textures.hits,
+			textures.misses,
+			textures.evictions,
+			textures.resident_bytes,
+			textures.budget_bytes,
+			heap_allocations
+		);
+		last_heap_allocations = renderer::heap_allocation_count();
 	}
 }
\ No newline at end of file
@@ -8,7 +8,7 @@ namespace input
 	constexpr float increment = 0.02f;
 	constexpr float camera_increment = 3.f;
 
-	auto HandleKeyDown(SDL_Keycode key, std::chrono::milliseconds elapsed_time) noexcept
+	auto HandleKeyDown(SDL_Keycode key) noexcept
 	{
 		auto state = SDL_GetKeyboardState(nullptr);
 		auto applyTransform = state[SDL_Scancode::SDL_SCANCODE_LSHIFT];
@@ -35,58 +35,36 @@ namespace input
 			{
 				if (applyTransform)
 					app_state::all_meshes.get_current_mesh().mesh.rotation.x += increment;
-				else
-					app_state::camera.position.y += camera_increment * static_cast<float>(elapsed_time.count()) / 1000.f;
 				break;
 			}
 			case SDL_KeyCode::SDLK_DOWN:
 			{
 				if (applyTransform)
 					app_state::all_meshes.get_current_mesh().mesh.rotation.x -= increment;
-				else
-					app_state::camera.position.y -= camera_increment * static_cast<float>(elapsed_time.count()) / 1000.f;
 				break;
 			}
 			case SDL_KeyCode::SDLK_w:
 			{
 				if (applyTransform)
-				{
 					app_state::all_meshes.get_current_mesh().mesh.translation.y -= increment;
-				}
-				else
-				{
-					app_state::camera.forward_velocity = renderer::scale(app_state::camera.direction, (5 * static_cast<float>(elapsed_time.count()) / 1000.f));
-					app_state::camera.position += app_state::camera.forward_velocity;
-				}
 				break;
 			}
 			case SDL_KeyCode::SDLK_s:
 			{
 				if (applyTransform)
-				{
 					app_state::all_meshes.get_current_mesh().mesh.translation.y += increment;
-				}
-				else
-				{
-					app_state::camera.forward_velocity = renderer::scale(app_state::camera.direction, (-5 * static_cast<float>(elapsed_time.count()) / 1000.f));
-					app_state::camera.position += app_state::camera.forward_velocity;
-				}
 				break;
 			}
 			case SDL_KeyCode::SDLK_a:
 			{
 				if (applyTransform)
 					app_state::all_meshes.get_current_mesh().mesh.translation.x -= increment;
-				else
-					app_state::camera.yaw += 1 * static_cast<float>(elapsed_time.count()) / 1000.f;
 				break;
 			}
 			case SDL_KeyCode::SDLK_d:
 			{
 				if (applyTransform)
 					app_state::all_meshes.get_current_mesh().mesh.translation.x += increment;
-				else
-					app_state::camera.yaw -= 1 * static_cast<float>(elapsed_time.count()) / 1000.f;
 				break;
 			}
 			case SDL_KeyCode::SDLK_e:
@@ -106,7 +84,7 @@ namespace input
 		}
 	};
 
-	auto HandleKeyUp(SDL_Keycode key, std::chrono::milliseconds elapsed_time) noexcept
+	auto HandleKeyUp(SDL_Keycode key) noexcept
 	{
 		switch (key)
 		{
@@ -134,6 +112,44 @@ namespace input
 			case SDL_KeyCode::SDLK_x:
 				app_state::render_settings.culling_mode = renderer::cull_mode::disabled;
 				break;
+			case SDL_KeyCode::SDLK_p:
+				app_state::render_settings.presenting_mode =
+					app_state::render_settings.presenting_mode == renderer::presentation_mode::zero_copy
+					? renderer::presentation_mode::copy
+					: renderer::presentation_mode::zero_copy;
+				// Zero-copy frames are drawn into the texture, not the
+				// frame buffer's own memory.
+				app_state::redraw_everything = true;
+				break;
+			case SDL_KeyCode::SDLK_t:
+				app_state::use_fixed_timestep = not app_state::use_fixed_timestep;
+				break;
+			case SDL_KeyCode::SDLK_r:
+				app_state::use_dynamic_resolution = not app_state::use_dynamic_resolution;
+				break;
+			case SDL_KeyCode::SDLK_v:
+				app_state::use_viewports = not app_state::use_viewports;
+				app_state::redraw_everything = true;
+				break;
+			case SDL_KeyCode::SDLK_b:
+				app_state::textures.set_encoding(
+					app_state::textures.encoding() == renderer::texture_encoding::bc1
+					? renderer::texture_encoding::argb8888
+					: renderer::texture_encoding::bc1
+				);
+				break;
+			case SDL_KeyCode::SDLK_F1:
+				app_state::pacer.set_target(renderer::frame_rate_target::fps_60);
+				break;
+			case SDL_KeyCode::SDLK_F2:
+				app_state::pacer.set_target(renderer::frame_rate_target::fps_120);
+				break;
+			case SDL_KeyCode::SDLK_F3:
+				app_state::pacer.set_target(renderer::frame_rate_target::fps_144);
+				break;
+			case SDL_KeyCode::SDLK_F4:
+				app_state::pacer.set_target(renderer::frame_rate_target::uncapped);
+				break;
 			case SDL_KeyCode::SDLK_LEFTBRACKET:
 				++app_state::all_meshes;
 				break;
@@ -146,29 +162,84 @@ namespace input
 
 export namespace input
 {
-	void process_input(std::chrono::milliseconds elapsed_time)
+	void process_input()
 	{
 		auto eventInfo = SDL_Event{};
-		SDL_PollEvent(&eventInfo);
-		switch (eventInfo.type)
+		while (SDL_PollEvent(&eventInfo))
 		{
-			case SDL_EventType::SDL_QUIT:
+			switch (eventInfo.type)
 			{
-				app_state::is_running = false;
-				break;
-			}
+				case SDL_EventType::SDL_QUIT:
+				{
+					app_state::is_running = false;
+					break;
+				}
 
-			case SDL_EventType::SDL_KEYDOWN:
-			{
-				HandleKeyDown(eventInfo.key.keysym.sym, elapsed_time);
-				break;
-			}
+				case SDL_EventType::SDL_KEYDOWN:
+				{
+					HandleKeyDown(eventInfo.key.keysym.sym);
+					break;
+				}
 
-			case SDL_EventType::SDL_KEYUP:
-			{
-				HandleKeyUp(eventInfo.key.keysym.sym, elapsed_time);
-				break;
+				case SDL_EventType::SDL_KEYUP:
+				{
+					HandleKeyUp(eventInfo.key.keysym.sym);
+					break;
+				}
+
+				case SDL_EventType::SDL_WINDOWEVENT:
+				{
+					if (eventInfo.window.event == SDL_WindowEventID::SDL_WINDOWEVENT_EXPOSED)
+						app_state::redraw_everything = true;
+					break;
+				}
 			}
 		}
 	}
+
+	auto is_any_key_held() noexcept -> bool
+	{
+		auto count = 0;
+		auto state = SDL_GetKeyboardState(&count);
+		return std::ranges::any_of(std::span{ state, static_cast<std::size_t>(count) }, [](auto pressed) { return pressed != 0; });
+	}
+
+	// Sleeps until an event arrives or the timeout passes, leaving the
+	// event for process_input().
+	void wait_for_input(std::chrono::milliseconds timeout) noexcept
+	{
+		SDL_WaitEventTimeout(nullptr, static_cast<int>(timeout.count()));
+	}
+
+	// Moves the camera for as long as its keys are held, by exactly the
+	// simulated time, rather than by a fixed amount per key repeat event.
+	void update_camera(std::chrono::duration<float> step) noexcept
+	{
+		auto state = SDL_GetKeyboardState(nullptr);
+		if (state[SDL_Scancode::SDL_SCANCODE_LSHIFT]) // shift transforms the mesh instead
+			return;
+
+		auto seconds = step.count();
+		if (state[SDL_Scancode::SDL_SCANCODE_UP])
+			app_state::camera.position.y += camera_increment * seconds;
+		if (state[SDL_Scancode::SDL_SCANCODE_DOWN])
+			app_state::camera.position.y -= camera_increment * seconds;
+		if (state[SDL_Scancode::SDL_SCANCODE_A])
+			app_state::camera.yaw += 1 * seconds;
+		if (state[SDL_Scancode::SDL_SCANCODE_D])
+			app_state::camera.yaw -= 1 * seconds;
+
+		auto camera_yaw_rotation = renderer::rotation_matrix{ renderer::y_rotation{ app_state::camera.yaw } };
+		app_state::camera.direction = camera_yaw_rotation * renderer::vector_3f{ 0, 0, 1 };
+		if (state[SDL_Scancode::SDL_SCANCODE_W])
+		{
+			app_state::camera.forward_velocity = renderer::scale(app_state::camera.direction, 5 * seconds);
+			app_state::camera.position += app_state::camera.forward_velocity;
+		}
+		if (state[SDL_Scancode::SDL_SCANCODE_S])
+		{
+			app_state::camera.forward_velocity = renderer::scale(app_state::camera.direction, -5 * seconds);
+			app_state::camera.position += app_state::camera.forward_velocity;
+		}
+	}
 }
\ No newline at end of file
@@ -8,6 +8,53 @@ import std;
 import renderer;
 import mainapp;
 
+// Replace the global allocation functions so that every general-heap
+// allocation is counted; see renderer::heap_allocation_count(). The array
+// and nothrow forms forward to these by default.
+auto operator new(std::size_t size) -> void*
+{
+	renderer::count_heap_allocation();
+	if (auto pointer = std::malloc(size == 0 ? 1 : size))
+		return pointer;
+	throw std::bad_alloc{};
+}
+
+auto operator new(std::size_t size, std::align_val_t alignment) -> void*
+{
+	renderer::count_heap_allocation();
+	// Over-allocate so the block can be aligned, and keep malloc's
+	// pointer just before it so that it can be freed.
+	auto align = static_cast<std::size_t>(alignment);
+	auto raw = std::malloc(size + align + sizeof(void*));
+	if (not raw)
+		throw std::bad_alloc{};
+	auto aligned = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + align - 1) & ~(align - 1);
+	reinterpret_cast<void**>(aligned)[-1] = raw;
+	return reinterpret_cast<void*>(aligned);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+	if (pointer)
+		std::free(static_cast<void**>(pointer)[-1]);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+	if (pointer)
+		std::free(static_cast<void**>(pointer)[-1]);
+}
+
 //int main(int argc, char* argv[]) // use this on subsystem:console
 auto WinMain(int argc, char* argv[]) -> int
 try
@@ -20,19 +67,61 @@ try
 		}
 	);
 
-	auto elapsed = std::chrono::milliseconds{ 0 };
+	// Smooths out the upscaling when rendering below the window's resolution.
+	SDL_SetTextureScaleMode(app_state::color_buffer_texture.get(), SDL_ScaleMode::SDL_ScaleModeLinear);
+
 	while (app_state::is_running)
 	{
-		auto begin = std::chrono::high_resolution_clock::now();
-		input::process_input(elapsed);
-		core::update(elapsed);
-		core::render(
-			app_state::sdl_renderer.get(),
-			app_state::color_buffer_texture.get(),
-			app_state::frame_buffer,
-			app_state::all_meshes.get_current_mesh().texture
-		);
-		elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - begin);
+		auto frame_time = app_state::pacer.begin_frame();
+		app_state::frame_arenas.reset();
+		input::process_input();
+		auto camera = core::simulate(frame_time);
+		auto texture = app_state::textures.acquire(app_state::all_meshes.get_current_mesh().texture);
+		if (core::is_frame_unchanged(camera, texture))
+		{
+			// The last frame is still on screen, so there's nothing to
+			// render or present. Unless a key is held, which may start
+			// moving something next frame, sleep until there's input
+			// rather than waking at the frame rate; the timeout picks up
+			// textures that finish decoding in the meantime.
+			core::report_frame_statistics();
+			if (input::is_any_key_held())
+			{
+				app_state::pacer.wait_for_next_frame();
+			}
+			else
+			{
+				input::wait_for_input(std::chrono::milliseconds{ 100 });
+				app_state::pacer.resume();
+			}
+			continue;
+		}
+
+		if (app_state::use_viewports)
+		{
+			// Each viewport has its own frame at a quarter of the window's
+			// size, so dynamic resolution is left as it is.
+			core::render_viewports(
+				app_state::sdl_renderer.get(),
+				app_state::color_buffer_texture.get(),
+				camera,
+				texture
+			);
+		}
+		else
+		{
+			auto triangles_to_render = core::update(camera, app_state::frame_arenas.local());
+			auto raster_time = core::render(
+				app_state::sdl_renderer.get(),
+				app_state::color_buffer_texture.get(),
+				app_state::frame_buffer,
+				texture,
+				triangles_to_render
+			);
+			core::adjust_resolution(raster_time);
+		}
+		core::report_frame_statistics();
+		app_state::pacer.wait_for_next_frame();
 	}
 
 	return 0;
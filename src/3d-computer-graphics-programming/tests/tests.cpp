@@ -97,4 +97,206 @@ namespace Tests
 			Assert::IsTrue(converted == 3.14159274f);
 		}
 	};
+
+	TEST_CLASS(FrameArenaTests)
+	{
+		TEST_METHOD(TestResetReclaimsMemory)
+		{
+			renderer::frame_arena arena{ 1024 };
+			{
+				std::pmr::vector<int> values{ &arena };
+				values.reserve(100);
+				Assert::IsTrue(arena.used() >= 100 * sizeof(int));
+			}
+			arena.reset();
+			Assert::IsTrue(arena.used() == 0);
+			Assert::IsTrue(arena.high_water_mark() >= 100 * sizeof(int));
+			Assert::IsTrue(arena.upstream_allocations() == 1);
+		}
+
+		TEST_METHOD(TestOverflowGrowsOnReset)
+		{
+			renderer::frame_arena arena{ 64 };
+			{
+				std::pmr::vector<double> values{ &arena };
+				values.reserve(100);
+			}
+			auto after_spike = arena.upstream_allocations();
+			arena.reset();
+			Assert::IsTrue(arena.capacity() >= 100 * sizeof(double));
+
+			// The next frame of the same size fits without the upstream resource.
+			auto before = arena.upstream_allocations();
+			{
+				std::pmr::vector<double> values{ &arena };
+				values.reserve(100);
+			}
+			Assert::IsTrue(after_spike > 1);
+			Assert::IsTrue(arena.upstream_allocations() == before);
+		}
+	};
+
+	TEST_CLASS(DecodedTextureCacheTests)
+	{
+		// 2x2 RGBA PNGs: red, green, blue, white, and the same with black
+		// instead of red.
+		static constexpr unsigned char first_png[] = {
+			0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+			0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x08, 0x06, 0x00, 0x00, 0x00, 0x72, 0xb6, 0x0d,
+			0x24, 0x00, 0x00, 0x00, 0x12, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9c, 0x63, 0xf8, 0xcf, 0xc0, 0xf0,
+			0x1f, 0x0c, 0x81, 0x34, 0x18, 0x00, 0x00, 0x49, 0xc8, 0x09, 0xf7, 0xf9, 0xab, 0xb6, 0x0d, 0x00,
+			0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82
+		};
+		static constexpr unsigned char second_png[] = {
+			0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+			0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x08, 0x06, 0x00, 0x00, 0x00, 0x72, 0xb6, 0x0d,
+			0x24, 0x00, 0x00, 0x00, 0x11, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9c, 0x63, 0x60, 0x60, 0x60, 0xf8,
+			0x0f, 0x86, 0x40, 0x1a, 0x0c, 0x00, 0x38, 0xd9, 0x08, 0xf8, 0x91, 0x1a, 0x02, 0xd9, 0x00, 0x00,
+			0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82
+		};
+
+		static auto write_png(const std::filesystem::path& path, std::span<const unsigned char> bytes)
+		{
+			auto file = std::ofstream{ path, std::ios::binary | std::ios::trunc };
+			file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		}
+
+		TEST_METHOD(TestWarmLoadMapsTheDecodedPixels)
+		{
+			auto directory = std::filesystem::temp_directory_path() / "DecodedTextureCacheTests" / "warm";
+			std::filesystem::remove_all(directory);
+			std::filesystem::create_directories(directory);
+			auto png = directory / "texture.png";
+			write_png(png, first_png);
+
+			upng::decoded_texture_cache cache{ directory / "cache", 1 << 20 };
+			auto cold = cache.load(png);
+			auto warm = cache.load(png);
+			Assert::IsTrue(cache.statistics().misses == 1);
+			Assert::IsTrue(cache.statistics().hits == 1);
+			Assert::IsTrue(warm.width() == 2 and warm.height() == 2);
+			Assert::IsTrue(std::equal(cold.uint32_buffer(), cold.uint32_buffer() + 4, warm.uint32_buffer()));
+			Assert::IsTrue(warm.uint32_buffer()[0] == 0xffff0000);
+		}
+
+		TEST_METHOD(TestChangedSourceIsDecodedAgain)
+		{
+			auto directory = std::filesystem::temp_directory_path() / "DecodedTextureCacheTests" / "changed";
+			std::filesystem::remove_all(directory);
+			std::filesystem::create_directories(directory);
+			auto png = directory / "texture.png";
+			write_png(png, first_png);
+
+			upng::decoded_texture_cache cache{ directory / "cache", 1 << 20 };
+			cache.load(png);
+			write_png(png, second_png);
+			std::filesystem::last_write_time(png, std::filesystem::last_write_time(png) + std::chrono::seconds{ 2 });
+			auto reloaded = cache.load(png);
+			Assert::IsTrue(cache.statistics().misses == 2);
+			Assert::IsTrue(reloaded.uint32_buffer()[0] == 0xff000000);
+		}
+
+		TEST_METHOD(TestMappedEntryIsReplacedOnceReleased)
+		{
+			auto directory = std::filesystem::temp_directory_path() / "DecodedTextureCacheTests" / "mapped";
+			std::filesystem::remove_all(directory);
+			std::filesystem::create_directories(directory);
+			auto png = directory / "texture.png";
+			write_png(png, first_png);
+
+			upng::decoded_texture_cache cache{ directory / "cache", 1 << 20 };
+			cache.load(png);
+			{
+				auto mapped = cache.load(png);
+				write_png(png, second_png);
+				std::filesystem::last_write_time(png, std::filesystem::last_write_time(png) + std::chrono::seconds{ 2 });
+				auto reloaded = cache.load(png);
+				Assert::IsTrue(reloaded.uint32_buffer()[0] == 0xff000000);
+				Assert::IsTrue(cache.statistics().busy_entries == 1);
+			}
+			cache.load(png);
+			auto warm = cache.load(png);
+			Assert::IsTrue(cache.statistics().misses == 3);
+			Assert::IsTrue(cache.statistics().write_failures == 0);
+			Assert::IsTrue(warm.uint32_buffer()[0] == 0xff000000);
+		}
+	};
+
+	TEST_CLASS(TextureCacheTests)
+	{
+		TEST_METHOD(TestMissingTextureReturnsTheFallback)
+		{
+			auto fallback = renderer::texture::red_brick();
+			renderer::texture_cache cache{ 1 << 20, fallback };
+			auto handle = cache.add(std::filesystem::temp_directory_path() / "TextureCacheTests" / "missing.png");
+			cache.acquire(handle);
+			cache.wait_for_decodes();
+
+			auto texture = cache.acquire(handle);
+			Assert::IsTrue(texture.buffer == fallback.buffer);
+			Assert::IsFalse(cache.is_resident(handle));
+			Assert::IsTrue(cache.decode_error(handle) != nullptr);
+			// Not requested again until it's invalidated.
+			Assert::IsTrue(cache.statistics().misses == 2);
+			cache.wait_for_decodes();
+			Assert::IsTrue(cache.acquire(handle).buffer == fallback.buffer);
+		}
+	};
+
+	TEST_CLASS(RasterLayoutTests)
+	{
+		static constexpr std::uint32_t width = 67;
+		static constexpr std::uint32_t height = 45;
+
+		// Overlapping triangles, some partly off screen, at sizes that
+		// aren't tile multiples so that spans start and end mid-tile.
+		static auto scene() -> renderer::triangle_list
+		{
+			auto random = std::mt19937{ 1234 };
+			auto x = std::uniform_real_distribution<float>{ -20.f, width + 20.f };
+			auto y = std::uniform_real_distribution<float>{ -20.f, height + 20.f };
+			auto depth = std::uniform_real_distribution<float>{ 1.f, 10.f };
+
+			auto triangles = renderer::triangle_list{ std::pmr::new_delete_resource() };
+			for (auto i = 0; i < 12; i++)
+			{
+				auto& triangle = triangles.emplace_back();
+				for (auto& vertex : triangle.vertices)
+					vertex = { x(random), y(random), 0.f, depth(random) };
+				triangle.texcoords[0] = { 0.f, 0.f };
+				triangle.texcoords[1] = { 1.f, 0.f };
+				triangle.texcoords[2] = { 0.f, 1.f };
+				triangle.color = random();
+			}
+			return triangles;
+		}
+
+		template<typename TLayout>
+		static auto render(const renderer::triangle_list& triangles) -> renderer::basic_frame_buffer<TLayout>
+		{
+			auto buffer = renderer::basic_frame_buffer<TLayout>{ width, height };
+			buffer.clear_color_buffer().clear_z_buffer();
+			renderer::draw_triangles(triangles, renderer::texture::red_brick(), { .rendering_mode = renderer::render_mode::filled_wireframe }, buffer);
+			renderer::draw_triangles(triangles, renderer::texture::red_brick(), { .rendering_mode = renderer::render_mode::textured }, buffer);
+			return buffer;
+		}
+
+		template<typename TLayout>
+		static auto matches(const renderer::basic_frame_buffer<TLayout>& tested, const renderer::frame_buffer& expected) -> bool
+		{
+			for (std::uint32_t row = 0; row < height; row++)
+				for (std::uint32_t column = 0; column < width; column++)
+					if (tested.color[row, column] != expected.color[row, column] or tested.depth[row, column] != expected.depth[row, column])
+						return false;
+			return true;
+		}
+
+		TEST_METHOD(TestTiledLayoutsRenderLikeLinear)
+		{
+			const auto triangles = scene();
+			const auto expected = render<renderer::default_layout>(triangles);
+			Assert::IsTrue(matches(render<renderer::tiled_layout<>>(triangles), expected));
+			Assert::IsTrue(matches(render<renderer::morton_layout<>>(triangles), expected));
+		}
+	};
 }